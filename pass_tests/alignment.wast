@@ -0,0 +1,68 @@
+;; Copyright (c) 2015 Intel Corporation
+;;
+;; Licensed under the Apache License, Version 2.0 (the "License");
+;; you may not use this file except in compliance with the License.
+;; You may obtain a copy of the License at
+;;
+;;      http://www.apache.org/licenses/LICENSE-2.0
+;;
+;; Unless required by applicable law or agreed to in writing, software
+;; distributed under the License is distributed on an "AS IS" BASIS,
+;; WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+;; See the License for the specific language governing permissions and
+;; limitations under the License.
+
+
+;; The accesses claim the alignment the address and the offset guarantee, and never more than the
+;;   natural one: the unaligned addresses, offsets and align= hints all read back what was stored.
+(module
+  (import $print_i32 "spectest" "print" (param i32))
+
+  (memory 1024 (segment 0 "\01\02\03\04\05\06\07\08\09\0a\0b\0c\0d\0e\0f\10"))
+
+  (func $load_odd (param $addr i32) (result i32)
+    (i32.load align=1 (get_local $addr))
+  )
+
+  (func $load_offset (result i32)
+    (i32.load16_u offset=3 (i32.const 2))
+  )
+
+  (func $store_unaligned (param $addr i32) (param $v i64) (result i64)
+    (i64.store align=1 offset=1 (get_local $addr) (get_local $v))
+    (i64.load offset=1 (get_local $addr))
+  )
+
+  (func $store_aligned (param $v f64) (result f64)
+    (f64.store align=8 (i32.const 64) (get_local $v))
+    (f64.load offset=4 align=4 (i32.const 60))
+  )
+
+  (func $narrow (param $addr i32) (result i32)
+    (i32.store16 offset=7 align=1 (get_local $addr) (i32.const 0x1234))
+    (i32.load8_u offset=8 (get_local $addr))
+  )
+
+  (func $run
+    (call_import $print_i32 (call $load_odd (i32.const 1)))
+    (call_import $print_i32 (call $load_offset))
+    (call_import $print_i32 (call $narrow (i32.const 101)))
+  )
+
+  (export "load_odd" $load_odd)
+  (export "load_offset" $load_offset)
+  (export "store_unaligned" $store_unaligned)
+  (export "store_aligned" $store_aligned)
+  (export "narrow" $narrow)
+  (export "run" $run)
+)
+
+(assert_return (invoke "load_odd" (i32.const 1)) (i32.const 0x05040302))
+(assert_return (invoke "load_odd" (i32.const 3)) (i32.const 0x07060504))
+(assert_return (invoke "load_offset") (i32.const 0x0706))
+(assert_return (invoke "store_unaligned" (i32.const 32) (i64.const 0x0102030405060708)) (i64.const 0x0102030405060708))
+(assert_return (invoke "store_unaligned" (i32.const 38) (i64.const -2)) (i64.const -2))
+(assert_return (invoke "store_aligned" (f64.const 2.5)) (f64.const 2.5))
+(assert_return (invoke "narrow" (i32.const 101)) (i32.const 0x12))
+
+(invoke "run")
@@ -0,0 +1,112 @@
+;; Copyright (c) 2015 Intel Corporation
+;;
+;; Licensed under the Apache License, Version 2.0 (the "License");
+;; you may not use this file except in compliance with the License.
+;; You may obtain a copy of the License at
+;;
+;;      http://www.apache.org/licenses/LICENSE-2.0
+;;
+;; Unless required by applicable law or agreed to in writing, software
+;; distributed under the License is distributed on an "AS IS" BASIS,
+;; WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+;; See the License for the specific language governing permissions and
+;; limitations under the License.
+
+
+;; Every kind of node, so that each walk, visitor and serialization of the AST meets all of them.
+(module
+  (import $print_i32 "spectest" "print" (param i32))
+
+  (memory 1024 (segment 0 "\05\06\07\08"))
+
+  (func $id (param $x i32) (result i32) (get_local $x))
+
+  ;; Constants of each type, unary and binary operators, conversions and a select.
+  (func $arith (param $x i32) (result i32)
+    (local $l i64)
+    (local $f f32)
+    (local $d f64)
+    (set_local $l (i64.extend_s/i32 (get_local $x)))
+    (set_local $l (i64.mul (get_local $l) (i64.const 3)))
+    (set_local $d (f64.convert_s/i64 (get_local $l)))
+    (set_local $f (f32.demote/f64 (f64.sqrt (f64.mul (get_local $d) (get_local $d)))))
+    (set_local $f (f32.add (f32.neg (get_local $f)) (f32.const 0.5)))
+    (i32.add
+      (i32.trunc_s/f64 (f64.promote/f32 (f32.floor (get_local $f))))
+      (i32.select (i32.ctz (i32.wrap/i64 (get_local $l))) (i32.popcnt (get_local $x)) (i32.const 100))
+    )
+  )
+
+  (func $bits (result i32)
+    (i32.reinterpret/f32 (f32.const 1.0))
+  )
+
+  ;; Blocks, loops, labels, ifs, breaks, returns, switches, nops and unreachables.
+  (func $control (param $x i32) (result i32)
+    (local $r i32)
+    (nop)
+    (if_else (i32.gt_s (get_local $x) (i32.const 100))
+      (return (i32.const -1))
+      (set_local $r (i32.const 0))
+    )
+    (label $skip
+      (if (i32.eq (get_local $x) (i32.const 0)) (br $skip))
+    )
+    (loop $done $next
+      (br_if (i32.ge_s (get_local $r) (get_local $x)) $done)
+      (set_local $r (i32.add (get_local $r) (i32.const 1)))
+      (br $next)
+    )
+    (tableswitch $sw (get_local $x)
+      (table (case $zero) (case $one))
+      (case $other)
+      (case $zero (br $sw))
+      (case $one (set_local $r (i32.const 10)) (br $sw))
+      (case $other (if (i32.eq (get_local $x) (i32.const 50)) (unreachable)) (nop))
+    )
+    (block (get_local $r))
+  )
+
+  ;; Loads, stores, the memory size and its growth: each call grows the memory by 1024.
+  (func $memory (result i32)
+    (local $old i32)
+    (i32.store8 offset=4 (i32.const 0) (i32.const 9))
+    (set_local $old (grow_memory (i32.add (memory_size) (i32.const 1024))))
+    (i32.add
+      (i32.add (i32.load8_u (i32.const 4)) (i32.load16_u (i32.const 0)))
+      (i32.sub (memory_size) (get_local $old))
+    )
+  )
+
+  (func $calls (result i32)
+    (call_import $print_i32 (call $id (i32.const 3)))
+    (call $id (i32.const 1))
+  )
+
+  (func $run
+    (call_import $print_i32 (call $arith (i32.const 4)))
+    (call_import $print_i32 (call $bits))
+    (call_import $print_i32 (call $control (i32.const 0)))
+    (call_import $print_i32 (call $control (i32.const 1)))
+    (call_import $print_i32 (call $control (i32.const 3)))
+    (call_import $print_i32 (call $control (i32.const 200)))
+    (call_import $print_i32 (call $memory))
+    (call_import $print_i32 (call $calls))
+  )
+
+  (export "arith" $arith)
+  (export "bits" $bits)
+  (export "control" $control)
+  (export "memory" $memory)
+  (export "run" $run)
+)
+
+(assert_return (invoke "arith" (i32.const 4)) (i32.const -11))
+(assert_return (invoke "bits") (i32.const 0x3f800000))
+(assert_return (invoke "control" (i32.const 0)) (i32.const 0))
+(assert_return (invoke "control" (i32.const 1)) (i32.const 10))
+(assert_return (invoke "control" (i32.const 3)) (i32.const 3))
+(assert_return (invoke "control" (i32.const 200)) (i32.const -1))
+(assert_return (invoke "memory") (i32.const 2574))
+
+(invoke "run")
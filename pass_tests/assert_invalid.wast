@@ -0,0 +1,52 @@
+;; Copyright (c) 2015 Intel Corporation
+;;
+;; Licensed under the Apache License, Version 2.0 (the "License");
+;; you may not use this file except in compliance with the License.
+;; You may obtain a copy of the License at
+;;
+;;      http://www.apache.org/licenses/LICENSE-2.0
+;;
+;; Unless required by applicable law or agreed to in writing, software
+;; distributed under the License is distributed on an "AS IS" BASIS,
+;; WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+;; See the License for the specific language governing permissions and
+;; limitations under the License.
+
+
+;; The modules of assert_invalid go through the passes with the others: the type annotation
+;;   must reject them, and no code is generated for them.
+(module
+  (func $add (param i32) (result i32)
+    (i32.add (get_local 0) (i32.const 1))
+  )
+
+  (export "add" $add)
+)
+
+(assert_invalid
+  (module
+    (func (result i32)
+      (i32.add (i64.const 1) (i32.const 2))
+    )
+  )
+  "type mismatch"
+)
+
+(assert_invalid
+  (module
+    (func (param i64) (result i32)
+      (return (get_local 0))
+    )
+  )
+  "type mismatch"
+)
+
+(assert_invalid
+  (module
+    (func $f (param i32) (param i32))
+    (func (call $f (i32.const 1)))
+  )
+  "arity mismatch"
+)
+
+(assert_return (invoke "add" (i32.const 1)) (i32.const 2))
@@ -0,0 +1,83 @@
+;; Copyright (c) 2015 Intel Corporation
+;;
+;; Licensed under the Apache License, Version 2.0 (the "License");
+;; you may not use this file except in compliance with the License.
+;; You may obtain a copy of the License at
+;;
+;;      http://www.apache.org/licenses/LICENSE-2.0
+;;
+;; Unless required by applicable law or agreed to in writing, software
+;; distributed under the License is distributed on an "AS IS" BASIS,
+;; WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+;; See the License for the specific language governing permissions and
+;; limitations under the License.
+
+;; The constant folding must bail where the result is not a constant of the same type:
+;;   divisions by 0 and signed divisions by -1 are left to the code generation, as are NaNs.
+(module
+  (import $print_i32 "spectest" "print" (param i32))
+
+  (func $div_s_minus_one (result i32) (i32.div_s (i32.const 7) (i32.const -1)))
+  (func $rem_s_minus_one (result i32) (i32.rem_s (i32.const 0x80000000) (i32.const -1)))
+  (func $div_u_minus_one (result i32) (i32.div_u (i32.const -1) (i32.const -1)))
+  (func $rem_u_minus_one (result i32) (i32.rem_u (i32.const 7) (i32.const -1)))
+  (func $div_s_64_minus_one (result i64) (i64.div_s (i64.const 9) (i64.const -1)))
+  (func $div_s (result i32) (i32.div_s (i32.const -7) (i32.const 2)))
+  (func $rem_s (result i32) (i32.rem_s (i32.const -7) (i32.const 2)))
+
+  (func $div_by_zero (result i32) (i32.div_s (i32.const 1) (i32.const 0)))
+  (func $rem_by_zero (result i64) (i64.rem_u (i64.const 1) (i64.const 0)))
+
+  (func $nan_div (result f32) (f32.div (f32.const 0.0) (f32.const 0.0)))
+  (func $nan_min (result f32) (f32.min (f32.const nan) (f32.const 1.0)))
+  (func $nan_eq (result i32) (f32.eq (f32.const nan) (f32.const nan)))
+  (func $nan_ne (result i32) (f32.ne (f32.const nan) (f32.const nan)))
+  (func $nan_trunc (result i32) (i32.trunc_s/f32 (f32.const nan)))
+
+  (func $run
+    (call_import $print_i32 (call $div_s_minus_one))
+    (call_import $print_i32 (call $rem_s_minus_one))
+    (call_import $print_i32 (call $div_u_minus_one))
+    (call_import $print_i32 (call $rem_u_minus_one))
+    (call_import $print_i32 (call $div_s))
+    (call_import $print_i32 (call $rem_s))
+    (call_import $print_i32 (call $nan_eq))
+    (call_import $print_i32 (call $nan_ne))
+  )
+
+  (export "div_s_minus_one" $div_s_minus_one)
+  (export "rem_s_minus_one" $rem_s_minus_one)
+  (export "div_u_minus_one" $div_u_minus_one)
+  (export "rem_u_minus_one" $rem_u_minus_one)
+  (export "div_s_64_minus_one" $div_s_64_minus_one)
+  (export "div_s" $div_s)
+  (export "rem_s" $rem_s)
+  (export "div_by_zero" $div_by_zero)
+  (export "rem_by_zero" $rem_by_zero)
+  (export "nan_div" $nan_div)
+  (export "nan_min" $nan_min)
+  (export "nan_eq" $nan_eq)
+  (export "nan_ne" $nan_ne)
+  (export "nan_trunc" $nan_trunc)
+  (export "run" $run)
+)
+
+(assert_return (invoke "div_s_minus_one") (i32.const -7))
+(assert_return (invoke "rem_s_minus_one") (i32.const 0))
+(assert_return (invoke "div_u_minus_one") (i32.const 1))
+(assert_return (invoke "rem_u_minus_one") (i32.const 7))
+(assert_return (invoke "div_s_64_minus_one") (i64.const -9))
+(assert_return (invoke "div_s") (i32.const -3))
+(assert_return (invoke "rem_s") (i32.const -1))
+
+;; The traps are not checked by the wrapper yet: these only make sure the code is generated.
+(assert_trap (invoke "div_by_zero") "integer divide by zero")
+(assert_trap (invoke "rem_by_zero") "integer divide by zero")
+(assert_trap (invoke "nan_trunc") "invalid conversion to integer")
+
+(assert_return_nan (invoke "nan_div"))
+(assert_return_nan (invoke "nan_min"))
+(assert_return (invoke "nan_eq") (i32.const 0))
+(assert_return (invoke "nan_ne") (i32.const 1))
+
+(invoke "run")
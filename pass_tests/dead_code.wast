@@ -0,0 +1,84 @@
+;; Copyright (c) 2015 Intel Corporation
+;;
+;; Licensed under the Apache License, Version 2.0 (the "License");
+;; you may not use this file except in compliance with the License.
+;; You may obtain a copy of the License at
+;;
+;;      http://www.apache.org/licenses/LICENSE-2.0
+;;
+;; Unless required by applicable law or agreed to in writing, software
+;; distributed under the License is distributed on an "AS IS" BASIS,
+;; WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+;; See the License for the specific language governing permissions and
+;; limitations under the License.
+
+;; The dead code removal splices the blocks and loops nobody breaks to into their parent:
+;;   the breaks crossing them must then target one label less. An operand jumping away wraps the
+;;   operands before it in a new block: the breaks crossing that one target one label more.
+(module
+  (import $print_i32 "spectest" "print" (param i32))
+
+  (func $shift (param i32) (result i32)
+    (block
+      ;; Nobody breaks to this block, nor to the loop below.
+      (block
+        (br_if (i32.eq (get_local 0) (i32.const 1)) 1 (i32.const 10))
+        (loop
+          (br_if (i32.eq (get_local 0) (i32.const 2)) 3 (i32.const 20))
+        )
+      )
+      (i32.const 30)
+    )
+  )
+
+  (func $after_break (param i32) (result i32)
+    (block
+      (br 0 (i32.add (get_local 0) (i32.const 4)))
+      (set_local 0 (i32.const 100))
+      (get_local 0)
+    )
+  )
+
+  (func $after_return (param i32) (result i32)
+    (return (i32.mul (get_local 0) (i32.const 2)))
+    (i32.const 5)
+  )
+
+  (func $operand_jump (param i32) (result i32)
+    (block
+      (i32.add
+        (block
+          (br_if (get_local 0) 1 (i32.const 8))
+          (i32.const 1)
+        )
+        (br 0 (i32.const 2))
+      )
+    )
+  )
+
+  (func $run
+    (call_import $print_i32 (call $shift (i32.const 1)))
+    (call_import $print_i32 (call $shift (i32.const 2)))
+    (call_import $print_i32 (call $shift (i32.const 3)))
+    (call_import $print_i32 (call $after_break (i32.const 1)))
+    (call_import $print_i32 (call $after_return (i32.const 3)))
+    (call_import $print_i32 (call $operand_jump (i32.const 1)))
+    (call_import $print_i32 (call $operand_jump (i32.const 0)))
+  )
+
+  (export "shift" $shift)
+  (export "after_break" $after_break)
+  (export "after_return" $after_return)
+  (export "operand_jump" $operand_jump)
+  (export "run" $run)
+)
+
+(assert_return (invoke "shift" (i32.const 1)) (i32.const 10))
+(assert_return (invoke "shift" (i32.const 2)) (i32.const 20))
+(assert_return (invoke "shift" (i32.const 3)) (i32.const 30))
+(assert_return (invoke "after_break" (i32.const 1)) (i32.const 5))
+(assert_return (invoke "after_return" (i32.const 3)) (i32.const 6))
+(assert_return (invoke "operand_jump" (i32.const 1)) (i32.const 8))
+(assert_return (invoke "operand_jump" (i32.const 0)) (i32.const 2))
+
+(invoke "run")
@@ -0,0 +1,71 @@
+;; Copyright (c) 2015 Intel Corporation
+;;
+;; Licensed under the Apache License, Version 2.0 (the "License");
+;; you may not use this file except in compliance with the License.
+;; You may obtain a copy of the License at
+;;
+;;      http://www.apache.org/licenses/LICENSE-2.0
+;;
+;; Unless required by applicable law or agreed to in writing, software
+;; distributed under the License is distributed on an "AS IS" BASIS,
+;; WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+;; See the License for the specific language governing permissions and
+;; limitations under the License.
+
+
+;; Relaxed floating point may reassociate, contract and turn divisions into multiplications: on
+;;   small integers and powers of two the results stay exact, with or without it.
+(module
+  (import $print_i32 "spectest" "print" (param i32))
+
+  (memory 1024)
+
+  (func $sum3 (param $a f64) (param $b f64) (param $c f64) (result f64)
+    (f64.add (f64.add (get_local $a) (get_local $b)) (get_local $c))
+  )
+
+  (func $quarter (param $x f32) (result f32)
+    (f32.div (get_local $x) (f32.const 4.0))
+  )
+
+  (func $mul_add (param $a f64) (param $b f64) (param $c f64) (result f64)
+    (f64.add (f64.mul (get_local $a) (get_local $b)) (get_local $c))
+  )
+
+  ;; A reduction the vectorizer may only split under relaxed floating point.
+  (func $reduce (param $n i32) (result i32)
+    (local $i i32)
+    (local $acc f32)
+    (loop $done $next
+      (br_if (i32.ge_s (get_local $i) (get_local $n)) $done)
+      (f32.store (i32.shl (get_local $i) (i32.const 2)) (f32.convert_s/i32 (get_local $i)))
+      (set_local $i (i32.add (get_local $i) (i32.const 1)))
+      (br $next)
+    )
+    (set_local $i (i32.const 0))
+    (loop $done $next
+      (br_if (i32.ge_s (get_local $i) (get_local $n)) $done)
+      (set_local $acc (f32.add (get_local $acc) (f32.load (i32.shl (get_local $i) (i32.const 2)))))
+      (set_local $i (i32.add (get_local $i) (i32.const 1)))
+      (br $next)
+    )
+    (i32.trunc_s/f32 (get_local $acc))
+  )
+
+  (func $run
+    (call_import $print_i32 (call $reduce (i32.const 200)))
+  )
+
+  (export "sum3" $sum3)
+  (export "quarter" $quarter)
+  (export "mul_add" $mul_add)
+  (export "reduce" $reduce)
+  (export "run" $run)
+)
+
+(assert_return (invoke "sum3" (f64.const 1.0) (f64.const 2.0) (f64.const 3.0)) (f64.const 6.0))
+(assert_return (invoke "quarter" (f32.const 10.0)) (f32.const 2.5))
+(assert_return (invoke "mul_add" (f64.const 3.0) (f64.const 4.0) (f64.const 5.0)) (f64.const 17.0))
+(assert_return (invoke "reduce" (i32.const 200)) (i32.const 19900))
+
+(invoke "run")
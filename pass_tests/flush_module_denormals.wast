@@ -0,0 +1,36 @@
+;; Copyright (c) 2015 Intel Corporation
+;;
+;; Licensed under the Apache License, Version 2.0 (the "License");
+;; you may not use this file except in compliance with the License.
+;; You may obtain a copy of the License at
+;;
+;;      http://www.apache.org/licenses/LICENSE-2.0
+;;
+;; Unless required by applicable law or agreed to in writing, software
+;; distributed under the License is distributed on an "AS IS" BASIS,
+;; WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+;; See the License for the specific language governing permissions and
+;; limitations under the License.
+
+
+;; Only the second module flushes its denormals: the first one still computes with them.
+(module
+  (func $double (param $x f32) (result f32)
+    (f32.add (get_local $x) (get_local $x))
+  )
+
+  (export "double" $double)
+)
+
+(assert_return (invoke "double" (f32.const 1.4e-45)) (f32.const 2.8e-45))
+
+(module
+  (func $double (param $x f32) (result f32)
+    (f32.add (get_local $x) (get_local $x))
+  )
+
+  (export "double" $double)
+)
+
+(assert_return (invoke "double" (f32.const 1.4e-45)) (f32.const 0.0))
+(assert_return (invoke "double" (f32.const 1.5)) (f32.const 3.0))
@@ -0,0 +1,79 @@
+;; Copyright (c) 2015 Intel Corporation
+;;
+;; Licensed under the Apache License, Version 2.0 (the "License");
+;; you may not use this file except in compliance with the License.
+;; You may obtain a copy of the License at
+;;
+;;      http://www.apache.org/licenses/LICENSE-2.0
+;;
+;; Unless required by applicable law or agreed to in writing, software
+;; distributed under the License is distributed on an "AS IS" BASIS,
+;; WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+;; See the License for the specific language governing permissions and
+;; limitations under the License.
+
+;; The inliner turns the returns of the callee into breaks out of the inlined block, converts
+;;   the block's value to the callee's result type, and zeroes the callee's locals at each call.
+(module
+  (import $print_i32 "spectest" "print" (param i32))
+
+  (func $clamp (param $v i32) (result i32)
+    (if (i32.lt_s (get_local $v) (i32.const 0)) (return (i32.const 0)))
+    (if (i32.gt_s (get_local $v) (i32.const 100)) (return (i32.const 100)))
+    (get_local $v)
+  )
+
+  (func $clamp_plus_one (param $v i32) (result i32)
+    (i32.add (call $clamp (get_local $v)) (i32.const 1))
+  )
+
+  ;; The body is a comparison: the inlined block still gives an i32.
+  (func $is_negative (param $v i32) (result i32)
+    (i32.lt_s (get_local $v) (i32.const 0))
+  )
+
+  (func $count_negatives (param $a i32) (param $b i32) (result i32)
+    (i32.add (call $is_negative (get_local $a)) (call $is_negative (get_local $b)))
+  )
+
+  ;; The local is only set on one path: it must start at 0 on every call.
+  (func $pick (param $c i32) (result i32)
+    (local $r i32)
+    (if (get_local $c) (set_local $r (i32.const 3)))
+    (get_local $r)
+  )
+
+  (func $pick_loop (result i32)
+    (local $i i32)
+    (local $acc i32)
+    (loop $done $next
+      (br_if (i32.eq (get_local $i) (i32.const 2)) $done)
+      (set_local $acc (i32.add (get_local $acc) (call $pick (i32.eq (get_local $i) (i32.const 0)))))
+      (set_local $i (i32.add (get_local $i) (i32.const 1)))
+      (br $next)
+    )
+    (get_local $acc)
+  )
+
+  (func $run
+    (call_import $print_i32 (call $clamp_plus_one (i32.const -5)))
+    (call_import $print_i32 (call $clamp_plus_one (i32.const 50)))
+    (call_import $print_i32 (call $clamp_plus_one (i32.const 500)))
+    (call_import $print_i32 (call $count_negatives (i32.const -1) (i32.const -2)))
+    (call_import $print_i32 (call $pick_loop))
+  )
+
+  (export "clamp_plus_one" $clamp_plus_one)
+  (export "count_negatives" $count_negatives)
+  (export "pick_loop" $pick_loop)
+  (export "run" $run)
+)
+
+(assert_return (invoke "clamp_plus_one" (i32.const -5)) (i32.const 1))
+(assert_return (invoke "clamp_plus_one" (i32.const 50)) (i32.const 51))
+(assert_return (invoke "clamp_plus_one" (i32.const 500)) (i32.const 101))
+(assert_return (invoke "count_negatives" (i32.const -1) (i32.const 2)) (i32.const 1))
+(assert_return (invoke "count_negatives" (i32.const 1) (i32.const 2)) (i32.const 0))
+(assert_return (invoke "pick_loop") (i32.const 3))
+
+(invoke "run")
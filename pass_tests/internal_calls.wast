@@ -0,0 +1,81 @@
+;; Copyright (c) 2015 Intel Corporation
+;;
+;; Licensed under the Apache License, Version 2.0 (the "License");
+;; you may not use this file except in compliance with the License.
+;; You may obtain a copy of the License at
+;;
+;;      http://www.apache.org/licenses/LICENSE-2.0
+;;
+;; Unless required by applicable law or agreed to in writing, software
+;; distributed under the License is distributed on an "AS IS" BASIS,
+;; WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+;; See the License for the specific language governing permissions and
+;; limitations under the License.
+
+
+;; The functions that are not exported are internal and use the fast calling convention: the
+;;   calls between them, recursive or not, and the ones into exported functions must agree on it.
+(module
+  (import $print_i32 "spectest" "print" (param i32))
+
+  (func $fact (param $n i64) (result i64)
+    (if_else (i64.le_s (get_local $n) (i64.const 1))
+      (i64.const 1)
+      (i64.mul (get_local $n) (call $fact (i64.sub (get_local $n) (i64.const 1))))
+    )
+  )
+
+  (func $is_even (param $n i32) (result i32)
+    (if_else (i32.eq (get_local $n) (i32.const 0))
+      (i32.const 1)
+      (call $is_odd (i32.sub (get_local $n) (i32.const 1)))
+    )
+  )
+
+  (func $is_odd (param $n i32) (result i32)
+    (if_else (i32.eq (get_local $n) (i32.const 0))
+      (i32.const 0)
+      (call $is_even (i32.sub (get_local $n) (i32.const 1)))
+    )
+  )
+
+  ;; Many parameters of mixed types.
+  (func $mix (param $a i32) (param $b i64) (param $c f32) (param $d f64) (param $e i32) (param $f i64) (result i32)
+    (i32.add
+      (i32.add (get_local $a) (i32.wrap/i64 (get_local $b)))
+      (i32.add
+        (i32.add (i32.trunc_s/f32 (get_local $c)) (i32.trunc_s/f64 (get_local $d)))
+        (i32.add (get_local $e) (i32.wrap/i64 (get_local $f)))
+      )
+    )
+  )
+
+  (func $call_mix (param $x i32) (result i32)
+    (call $mix (get_local $x) (i64.const 20) (f32.const 300.0) (f64.const 4000.0) (i32.const 50000) (i64.const 600000))
+  )
+
+  (func $fact_20 (result i64)
+    (call $fact (i64.const 20))
+  )
+
+  (func $run
+    (call_import $print_i32 (call $is_even (i32.const 10)))
+    (call_import $print_i32 (call $is_even (i32.const 7)))
+    (call_import $print_i32 (call $call_mix (i32.const 1)))
+    (call_import $print_i32 (i32.wrap/i64 (call $fact (i64.const 10))))
+  )
+
+  (export "fact" $fact)
+  (export "fact_20" $fact_20)
+  (export "is_even" $is_even)
+  (export "call_mix" $call_mix)
+  (export "run" $run)
+)
+
+(assert_return (invoke "fact" (i64.const 5)) (i64.const 120))
+(assert_return (invoke "fact_20") (i64.const 2432902008176640000))
+(assert_return (invoke "is_even" (i32.const 10)) (i32.const 1))
+(assert_return (invoke "is_even" (i32.const 7)) (i32.const 0))
+(assert_return (invoke "call_mix" (i32.const 1)) (i32.const 654321))
+
+(invoke "run")
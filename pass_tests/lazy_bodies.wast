@@ -0,0 +1,77 @@
+;; Copyright (c) 2015 Intel Corporation
+;;
+;; Licensed under the Apache License, Version 2.0 (the "License");
+;; you may not use this file except in compliance with the License.
+;; You may obtain a copy of the License at
+;;
+;;      http://www.apache.org/licenses/LICENSE-2.0
+;;
+;; Unless required by applicable law or agreed to in writing, software
+;; distributed under the License is distributed on an "AS IS" BASIS,
+;; WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+;; See the License for the specific language governing permissions and
+;; limitations under the License.
+
+
+;; Only the bodies reached from the exports are parsed: the calls are found under every kind of
+;;   expression, and through functions that are not exported. $unused keeps only its prototype.
+(module
+  (import $print_i32 "spectest" "print" (param i32))
+
+  (memory 64)
+
+  (func $one (result i32) (i32.const 1))
+  (func $two (result i32) (i32.const 2))
+  (func $three (result i32) (i32.const 3))
+  (func $four (result i32) (i32.const 4))
+  (func $five (result i32) (i32.const 5))
+  (func $six (result i32) (i32.const 6))
+  (func $seven (result i32) (i32.const 7))
+
+  ;; Only called by $inner.
+  (func $deep (param $x i32) (result i32) (i32.mul (get_local $x) (i32.const 10)))
+  (func $inner (param $x i32) (result i32) (call $deep (get_local $x)))
+
+  (func $unused (param $x i32) (result i32)
+    (call $unused (i32.div_s (get_local $x) (i32.const 0)))
+  )
+
+  (func $nested (param $c i32) (result i32)
+    (local $r i32)
+    (i32.store (i32.const 0) (call $one))
+    (if (i32.eq (call $two) (i32.const 2))
+      (set_local $r (i32.select (get_local $c) (i32.const 0) (call $three)))
+    )
+    (block $out
+      (loop $exit $next
+        (br_if (get_local $c) $exit)
+        (set_local $r (i32.add (get_local $r) (call $four)))
+        (set_local $c (i32.const 1))
+        (br $next)
+      )
+    )
+    (tableswitch $sw (get_local $c)
+      (table (case $a))
+      (case $b)
+      (case $a (set_local $r (i32.add (get_local $r) (call $five))))
+      (case $b (set_local $r (i32.add (get_local $r) (i32.clz (call $six)))))
+    )
+    (i32.add
+      (i32.add (get_local $r) (i32.load (i32.const 0)))
+      (i32.add (call $inner (call $seven)) (i32.load (i32.mul (call $one) (i32.const 0))))
+    )
+  )
+
+  (func $run
+    (call_import $print_i32 (call $nested (i32.const 0)))
+    (call_import $print_i32 (call $nested (i32.const 1)))
+  )
+
+  (export "nested" $nested)
+  (export "run" $run)
+)
+
+(assert_return (invoke "nested" (i32.const 0)) (i32.const 108))
+(assert_return (invoke "nested" (i32.const 1)) (i32.const 101))
+
+(invoke "run")
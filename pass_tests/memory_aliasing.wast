@@ -0,0 +1,71 @@
+;; Copyright (c) 2015 Intel Corporation
+;;
+;; Licensed under the Apache License, Version 2.0 (the "License");
+;; you may not use this file except in compliance with the License.
+;; You may obtain a copy of the License at
+;;
+;;      http://www.apache.org/licenses/LICENSE-2.0
+;;
+;; Unless required by applicable law or agreed to in writing, software
+;; distributed under the License is distributed on an "AS IS" BASIS,
+;; WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+;; See the License for the specific language governing permissions and
+;; limitations under the License.
+
+
+;; The linear memory is untyped: accesses of different types and sizes to the same bytes must
+;;   still see each other, whatever the type-based alias information says.
+(module
+  (import $print_i32 "spectest" "print" (param i32))
+
+  (memory 1024)
+
+  (func $int_to_float (param $v i32) (result f32)
+    (i32.store (i32.const 8) (get_local $v))
+    (f32.load (i32.const 8))
+  )
+
+  (func $float_to_int (param $v f32) (result i32)
+    (f32.store (i32.const 16) (get_local $v))
+    (i32.load (i32.const 16))
+  )
+
+  (func $patch_byte (param $addr i32) (result i64)
+    (i64.store (get_local $addr) (i64.const 0))
+    (i32.store8 offset=2 (get_local $addr) (i32.const 0xff))
+    (i64.load (get_local $addr))
+  )
+
+  (func $halves (param $v i32) (result i32)
+    (i32.store (i32.const 40) (get_local $v))
+    (i32.store16 (i32.const 42) (i32.const 1))
+    (i32.add (i32.load16_u (i32.const 40)) (i32.load (i32.const 40)))
+  )
+
+  (func $double_words (param $v f64) (result i32)
+    (f64.store (i32.const 48) (get_local $v))
+    (i32.load offset=4 (i32.const 48))
+  )
+
+  (func $run
+    (call_import $print_i32 (call $float_to_int (f32.const 1.0)))
+    (call_import $print_i32 (call $halves (i32.const 0x00050003)))
+    (call_import $print_i32 (call $double_words (f64.const 2.0)))
+  )
+
+  (export "int_to_float" $int_to_float)
+  (export "float_to_int" $float_to_int)
+  (export "patch_byte" $patch_byte)
+  (export "halves" $halves)
+  (export "double_words" $double_words)
+  (export "run" $run)
+)
+
+(assert_return (invoke "int_to_float" (i32.const 0x40400000)) (f32.const 3.0))
+(assert_return (invoke "float_to_int" (f32.const 1.0)) (i32.const 0x3f800000))
+(assert_return (invoke "patch_byte" (i32.const 24)) (i64.const 0xff0000))
+(assert_return (invoke "patch_byte" (i32.const 27)) (i64.const 0xff0000))
+(assert_return (invoke "halves" (i32.const 0x00050003)) (i32.const 0x00010006))
+(assert_return (invoke "double_words" (f64.const 2.0)) (i32.const 0x40000000))
+
+(invoke "run")
@@ -0,0 +1,63 @@
+;; Copyright (c) 2015 Intel Corporation
+;;
+;; Licensed under the Apache License, Version 2.0 (the "License");
+;; you may not use this file except in compliance with the License.
+;; You may obtain a copy of the License at
+;;
+;;      http://www.apache.org/licenses/LICENSE-2.0
+;;
+;; Unless required by applicable law or agreed to in writing, software
+;; distributed under the License is distributed on an "AS IS" BASIS,
+;; WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+;; See the License for the specific language governing permissions and
+;; limitations under the License.
+
+
+;; The memory base is reloaded after each growth: the accesses after a grow_memory, the ones in
+;;   a loop that grows, and a store whose own value grows the memory all use the new base.
+(module
+  (import $print_i32 "spectest" "print" (param i32))
+
+  (memory 1024 (segment 0 "\2a"))
+
+  (func $grow_then_access (result i32)
+    (local $old i32)
+    (set_local $old (grow_memory (i32.add (memory_size) (i32.const 4096))))
+    (i32.store (i32.sub (memory_size) (i32.const 4)) (i32.const 7))
+    (i32.add
+      (i32.load (i32.sub (memory_size) (i32.const 4)))
+      (i32.sub (memory_size) (get_local $old))
+    )
+  )
+
+  ;; Each iteration grows the memory and writes at the end of it.
+  (func $grow_in_loop (param $n i32) (result i32)
+    (local $i i32)
+    (local $sum i32)
+    (loop $done $next
+      (br_if (i32.ge_s (get_local $i) (get_local $n)) $done)
+      (grow_memory (i32.add (memory_size) (i32.const 1024)))
+      (i32.store8 (i32.sub (memory_size) (i32.const 1)) (get_local $i))
+      (set_local $sum (i32.add (get_local $sum) (i32.load8_u (i32.sub (memory_size) (i32.const 1)))))
+      (set_local $i (i32.add (get_local $i) (i32.const 1)))
+      (br $next)
+    )
+    (i32.add (get_local $sum) (i32.load8_u (i32.const 0)))
+  )
+
+  ;; The value is computed after the address: the store must not use the base from before.
+  (func $store_grown_size (result i32)
+    (i32.store (i32.const 4) (grow_memory (i32.const 8192)))
+    (i32.load (i32.const 4))
+  )
+
+  (func $run
+    (call_import $print_i32 (call $store_grown_size))
+    (call_import $print_i32 (call $grow_then_access))
+    (call_import $print_i32 (call $grow_in_loop (i32.const 5)))
+  )
+
+  (export "run" $run)
+)
+
+(invoke "run")
@@ -0,0 +1,64 @@
+;; Copyright (c) 2015 Intel Corporation
+;;
+;; Licensed under the Apache License, Version 2.0 (the "License");
+;; you may not use this file except in compliance with the License.
+;; You may obtain a copy of the License at
+;;
+;;      http://www.apache.org/licenses/LICENSE-2.0
+;;
+;; Unless required by applicable law or agreed to in writing, software
+;; distributed under the License is distributed on an "AS IS" BASIS,
+;; WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+;; See the License for the specific language governing permissions and
+;; limitations under the License.
+
+
+;; Several modules, each followed by its assertions: the top-level forms are parsed one after
+;;   the other or in parallel chunks, and each keeps its own segments, strings and line numbers.
+(module
+  (memory 64 (segment 0 "a\62c") (segment 8 "\01\02\5c"))
+
+  (func (result i32) (i32.load8_u (i32.const 1)))
+  (func (result i32) (i32.load8_u (i32.const 10)))
+
+  (; A block comment (func $hidden (result i32) (i32.const 1)) ;)
+  (export "second_letter" 0)
+  (export "last" 1)
+)
+
+(assert_return (invoke "second_letter") (i32.const 98))
+(assert_return (invoke "last") (i32.const 92))
+
+(module
+  (memory 64 (segment 0 "xyz"))
+
+  ;; Same export names, other memory.
+  (func (result i32) (i32.load8_u (i32.const 1)))
+  (func (result i32) (i32.load8_u (i32.const 2)))
+
+  (export "second_letter" 0)
+  (export "last" 1)
+)
+
+(assert_return (invoke "second_letter") (i32.const 121))
+(assert_return (invoke "last") (i32.const 122))
+
+(module
+  (func $add (param i32) (param i32) (result i32)
+    (i32.add (get_local 0) (get_local 1))
+  )
+  (func (param i64) (result i64)
+    (i64.sub (get_local 0) (i64.const 1))
+  )
+  (func (param f64) (result f64)
+    (f64.mul (get_local 0) (f64.const 0.5))
+  )
+
+  (export "add" $add)
+  (export "dec" 1)
+  (export "half" 2)
+)
+
+(assert_return (invoke "add" (i32.const 40) (i32.const 2)) (i32.const 42))
+(assert_return (invoke "dec" (i64.const 0x100000000)) (i64.const 0xffffffff))
+(assert_return (invoke "half" (f64.const 5.0)) (f64.const 2.5))
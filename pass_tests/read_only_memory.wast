@@ -0,0 +1,75 @@
+;; Copyright (c) 2015 Intel Corporation
+;;
+;; Licensed under the Apache License, Version 2.0 (the "License");
+;; you may not use this file except in compliance with the License.
+;; You may obtain a copy of the License at
+;;
+;;      http://www.apache.org/licenses/LICENSE-2.0
+;;
+;; Unless required by applicable law or agreed to in writing, software
+;; distributed under the License is distributed on an "AS IS" BASIS,
+;; WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+;; See the License for the specific language governing permissions and
+;; limitations under the License.
+
+;; The loads of the segments nobody stores to are folded into constants: the narrow signed
+;;   loads are sign-extended, the unsigned ones zero-extended. The stored segment stays in memory.
+(module
+  (import $print_i32 "spectest" "print" (param i32))
+
+  (memory 1024
+    (segment 0 "\ff\80\7f\fe")
+    (segment 16 "\01\02")
+  )
+
+  (func $load8_s (result i32) (i32.load8_s (i32.const 0)))
+  (func $load8_u (result i32) (i32.load8_u (i32.const 0)))
+  (func $load8_s_positive (result i32) (i32.load8_s offset=2 (i32.const 0)))
+  (func $load16_s (result i32) (i32.load16_s (i32.const 0)))
+  (func $load16_u (result i32) (i32.load16_u offset=2 (i32.const 0)))
+  (func $load32 (result i32) (i32.load (i32.const 0)))
+  (func $load64_8_s (result i64) (i64.load8_s (i32.const 0)))
+  (func $load64_16_u (result i64) (i64.load16_u (i32.const 1)))
+
+  (func $store_load (param $v i32) (result i32)
+    (i32.store16 (i32.const 16) (get_local $v))
+    (i32.load8_s (i32.const 17))
+  )
+  (func $stored (result i32) (i32.load16_u (i32.const 16)))
+
+  (func $run
+    (call_import $print_i32 (call $load8_s))
+    (call_import $print_i32 (call $load8_u))
+    (call_import $print_i32 (call $load8_s_positive))
+    (call_import $print_i32 (call $load16_s))
+    (call_import $print_i32 (call $load16_u))
+    (call_import $print_i32 (call $load32))
+    (call_import $print_i32 (call $stored))
+  )
+
+  (export "load8_s" $load8_s)
+  (export "load8_u" $load8_u)
+  (export "load8_s_positive" $load8_s_positive)
+  (export "load16_s" $load16_s)
+  (export "load16_u" $load16_u)
+  (export "load32" $load32)
+  (export "load64_8_s" $load64_8_s)
+  (export "load64_16_u" $load64_16_u)
+  (export "store_load" $store_load)
+  (export "stored" $stored)
+  (export "run" $run)
+)
+
+(assert_return (invoke "load8_s") (i32.const -1))
+(assert_return (invoke "load8_u") (i32.const 255))
+(assert_return (invoke "load8_s_positive") (i32.const 127))
+(assert_return (invoke "load16_s") (i32.const -32513))
+(assert_return (invoke "load16_u") (i32.const 65151))
+(assert_return (invoke "load32") (i32.const 0xfe7f80ff))
+(assert_return (invoke "load64_8_s") (i64.const -1))
+(assert_return (invoke "load64_16_u") (i64.const 32640))
+(assert_return (invoke "stored") (i32.const 513))
+(assert_return (invoke "store_load" (i32.const 0x8001)) (i32.const -128))
+(assert_return (invoke "stored") (i32.const 32769))
+
+(invoke "run")
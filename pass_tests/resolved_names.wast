@@ -0,0 +1,101 @@
+;; Copyright (c) 2015 Intel Corporation
+;;
+;; Licensed under the Apache License, Version 2.0 (the "License");
+;; you may not use this file except in compliance with the License.
+;; You may obtain a copy of the License at
+;;
+;;      http://www.apache.org/licenses/LICENSE-2.0
+;;
+;; Unless required by applicable law or agreed to in writing, software
+;; distributed under the License is distributed on an "AS IS" BASIS,
+;; WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+;; See the License for the specific language governing permissions and
+;; limitations under the License.
+
+
+;; The names are resolved to indices before the code generation: the locals and the parameters
+;;   by name or by index, the labels to the innermost one of that name, and the calls to functions
+;;   defined later in the module or given by their index. Each module resolves its own names.
+(module
+  (import $print_i32 "spectest" "print" (param i32))
+
+  (func $diff (param $a i32) (param $b i32) (result i32)
+    (local $tmp i32)
+    ;; Local 2 is $tmp.
+    (set_local 2 (i32.sub (get_local $a) (get_local 1)))
+    (get_local $tmp)
+  )
+
+  ;; The inner $l hides the outer one: the break only leaves the inner block.
+  (func $shadow (param $x i32) (result i32)
+    (block $l
+      (i32.add
+        (block $l
+          (br_if (get_local $x) $l (i32.const 10))
+          (i32.const 20)
+        )
+        (i32.const 1)
+      )
+    )
+  )
+
+  ;; The callee is defined after its caller.
+  (func $forward (param $x i32) (result i32)
+    (call $later (get_local $x))
+  )
+
+  (func $later (param $x i32) (result i32)
+    (i32.mul (get_local $x) (i32.const 3))
+  )
+
+  ;; Function 0 is $diff.
+  (func $by_index (result i32)
+    (call 0 (i32.const 7) (i32.const 2))
+  )
+
+  (func $run
+    (call_import $print_i32 (call $diff (i32.const 9) (i32.const 4)))
+    (call_import $print_i32 (call $shadow (i32.const 1)))
+    (call_import $print_i32 (call $shadow (i32.const 0)))
+    (call_import $print_i32 (call $forward (i32.const 5)))
+    (call_import $print_i32 (call $by_index))
+  )
+
+  (export "diff" $diff)
+  (export "shadow" $shadow)
+  (export "forward" $forward)
+  (export "by_index" $by_index)
+  (export "run" $run)
+)
+
+(assert_return (invoke "diff" (i32.const 9) (i32.const 4)) (i32.const 5))
+(assert_return (invoke "shadow" (i32.const 1)) (i32.const 11))
+(assert_return (invoke "shadow" (i32.const 0)) (i32.const 21))
+(assert_return (invoke "forward" (i32.const 5)) (i32.const 15))
+(assert_return (invoke "by_index") (i32.const 5))
+
+(invoke "run")
+
+;; The same names mean other functions here.
+(module
+  (import $print_i32 "spectest" "print" (param i32))
+
+  (func $later (param $x i32) (result i32)
+    (i32.add (get_local $x) (i32.const 100))
+  )
+
+  (func $forward (param $x i32) (result i32)
+    (call $later (get_local $x))
+  )
+
+  (func $run
+    (call_import $print_i32 (call $forward (i32.const 5)))
+  )
+
+  (export "forward" $forward)
+  (export "run" $run)
+)
+
+(assert_return (invoke "forward" (i32.const 5)) (i32.const 105))
+
+(invoke "run")
@@ -0,0 +1,110 @@
+;; Copyright (c) 2015 Intel Corporation
+;;
+;; Licensed under the Apache License, Version 2.0 (the "License");
+;; you may not use this file except in compliance with the License.
+;; You may obtain a copy of the License at
+;;
+;;      http://www.apache.org/licenses/LICENSE-2.0
+;;
+;; Unless required by applicable law or agreed to in writing, software
+;; distributed under the License is distributed on an "AS IS" BASIS,
+;; WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+;; See the License for the specific language governing permissions and
+;; limitations under the License.
+
+;; The locals live in SSA values: they merge in phis at the loop headers and exits,
+;;   after the ifs, and at the exit of a switch reached by breaks and by falling through.
+(module
+  (import $print_i32 "spectest" "print" (param i32))
+
+  (func $sum (param $n i32) (result i32)
+    (local $i i32)
+    (local $acc i32)
+    (loop $done $next
+      (br_if (i32.ge_s (get_local $i) (get_local $n)) $done)
+      (set_local $acc (i32.add (get_local $acc) (get_local $i)))
+      (set_local $i (i32.add (get_local $i) (i32.const 1)))
+      (br $next)
+    )
+    (get_local $acc)
+  )
+
+  ;; Only the odd iterations update the local: the loop header merges it with itself.
+  (func $sum_odd (param $n i32) (result i32)
+    (local $i i32)
+    (local $acc i32)
+    (loop $done $next
+      (br_if (i32.ge_s (get_local $i) (get_local $n)) $done)
+      (if (i32.and (get_local $i) (i32.const 1))
+        (set_local $acc (i32.add (get_local $acc) (get_local $i)))
+      )
+      (set_local $i (i32.add (get_local $i) (i32.const 1)))
+      (br $next)
+    )
+    (get_local $acc)
+  )
+
+  ;; The local leaves the loop by two breaks carrying different values.
+  (func $find (param $n i32) (result i32)
+    (local $i i32)
+    (local $r i32)
+    (set_local $r (i32.const -1))
+    (loop $done $next
+      (br_if (i32.ge_s (get_local $i) (i32.const 10)) $done)
+      (if (i32.eq (i32.mul (get_local $i) (get_local $i)) (get_local $n))
+        (block
+          (set_local $r (get_local $i))
+          (br $done)
+        )
+      )
+      (set_local $i (i32.add (get_local $i) (i32.const 1)))
+      (br $next)
+    )
+    (get_local $r)
+  )
+
+  (func $switch (param $x i32) (result i32)
+    (local $r i32)
+    (set_local $r (i32.const 1))
+    (tableswitch $sw (get_local $x)
+      (table (case $a) (case $b) (case $c))
+      (case $d)
+      ;; Falls through into $b.
+      (case $a (set_local $r (i32.mul (get_local $r) (i32.const 10))))
+      (case $b (set_local $r (i32.add (get_local $r) (i32.const 2))) (br $sw))
+      ;; Falls through into $d.
+      (case $c (set_local $r (i32.const 7)))
+      (case $d (set_local $r (i32.sub (get_local $r) (i32.const 5))) (nop))
+    )
+    (get_local $r)
+  )
+
+  (func $run
+    (call_import $print_i32 (call $sum (i32.const 5)))
+    (call_import $print_i32 (call $sum_odd (i32.const 6)))
+    (call_import $print_i32 (call $find (i32.const 49)))
+    (call_import $print_i32 (call $find (i32.const 50)))
+    (call_import $print_i32 (call $switch (i32.const 0)))
+    (call_import $print_i32 (call $switch (i32.const 1)))
+    (call_import $print_i32 (call $switch (i32.const 2)))
+    (call_import $print_i32 (call $switch (i32.const 3)))
+  )
+
+  (export "sum" $sum)
+  (export "sum_odd" $sum_odd)
+  (export "find" $find)
+  (export "switch" $switch)
+  (export "run" $run)
+)
+
+(assert_return (invoke "sum" (i32.const 0)) (i32.const 0))
+(assert_return (invoke "sum" (i32.const 5)) (i32.const 10))
+(assert_return (invoke "sum_odd" (i32.const 6)) (i32.const 9))
+(assert_return (invoke "find" (i32.const 49)) (i32.const 7))
+(assert_return (invoke "find" (i32.const 50)) (i32.const -1))
+(assert_return (invoke "switch" (i32.const 0)) (i32.const 12))
+(assert_return (invoke "switch" (i32.const 1)) (i32.const 3))
+(assert_return (invoke "switch" (i32.const 2)) (i32.const 2))
+(assert_return (invoke "switch" (i32.const 3)) (i32.const -4))
+
+(invoke "run")
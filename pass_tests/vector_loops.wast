@@ -0,0 +1,85 @@
+;; Copyright (c) 2015 Intel Corporation
+;;
+;; Licensed under the Apache License, Version 2.0 (the "License");
+;; you may not use this file except in compliance with the License.
+;; You may obtain a copy of the License at
+;;
+;;      http://www.apache.org/licenses/LICENSE-2.0
+;;
+;; Unless required by applicable law or agreed to in writing, software
+;; distributed under the License is distributed on an "AS IS" BASIS,
+;; WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+;; See the License for the specific language governing permissions and
+;; limitations under the License.
+
+
+;; Loops over the linear memory the vectorizers can widen: the results must not depend on the
+;;   width, the interleaving or the remainder iterations.
+(module
+  (import $print_i32 "spectest" "print" (param i32))
+
+  (memory 4096)
+
+  ;; Fill the first n words with 0, 1, 2 and so on.
+  (func $fill (param $n i32)
+    (local $i i32)
+    (loop $done $next
+      (br_if (i32.ge_s (get_local $i) (get_local $n)) $done)
+      (i32.store (i32.shl (get_local $i) (i32.const 2)) (get_local $i))
+      (set_local $i (i32.add (get_local $i) (i32.const 1)))
+      (br $next)
+    )
+  )
+
+  (func $sum (param $n i32) (result i32)
+    (local $i i32)
+    (local $acc i32)
+    (call $fill (get_local $n))
+    (loop $done $next
+      (br_if (i32.ge_s (get_local $i) (get_local $n)) $done)
+      (set_local $acc (i32.add (get_local $acc) (i32.load (i32.shl (get_local $i) (i32.const 2)))))
+      (set_local $i (i32.add (get_local $i) (i32.const 1)))
+      (br $next)
+    )
+    (get_local $acc)
+  )
+
+  ;; Converts the words to floats at 2048, doubles them, and adds them back as integers.
+  (func $scale (param $n i32) (result i32)
+    (local $i i32)
+    (local $acc i32)
+    (call $fill (get_local $n))
+    (loop $done $next
+      (br_if (i32.ge_s (get_local $i) (get_local $n)) $done)
+      (f32.store offset=2048 (i32.shl (get_local $i) (i32.const 2))
+        (f32.mul (f32.convert_s/i32 (i32.load (i32.shl (get_local $i) (i32.const 2)))) (f32.const 2.0)))
+      (set_local $i (i32.add (get_local $i) (i32.const 1)))
+      (br $next)
+    )
+    (set_local $i (i32.const 0))
+    (loop $done $next
+      (br_if (i32.ge_s (get_local $i) (get_local $n)) $done)
+      (set_local $acc (i32.add (get_local $acc) (i32.trunc_s/f32 (f32.load offset=2048 (i32.shl (get_local $i) (i32.const 2))))))
+      (set_local $i (i32.add (get_local $i) (i32.const 1)))
+      (br $next)
+    )
+    (get_local $acc)
+  )
+
+  (func $run
+    (call_import $print_i32 (call $sum (i32.const 100)))
+    (call_import $print_i32 (call $scale (i32.const 37)))
+  )
+
+  (export "sum" $sum)
+  (export "scale" $scale)
+  (export "run" $run)
+)
+
+(assert_return (invoke "sum" (i32.const 0)) (i32.const 0))
+(assert_return (invoke "sum" (i32.const 3)) (i32.const 3))
+(assert_return (invoke "sum" (i32.const 100)) (i32.const 4950))
+(assert_return (invoke "scale" (i32.const 1)) (i32.const 0))
+(assert_return (invoke "scale" (i32.const 37)) (i32.const 1332))
+
+(invoke "run")
@@ -55,7 +55,6 @@
   BISON_PRINT_TABS(n); \
   BISON_PRINT(__VA_ARGS__);
 
-void PrintLine(int line);
 void PrintLine(const char* name, int line);
 
 #endif
@@ -15,19 +15,50 @@
 */
 
 #include <iostream>
+#include <string>
 #include <unistd.h>
 #include <getopt.h>
 
+#include "ast_cache.h"
 #include "debug.h"
 #include "driver.h"
 #include "globals.h"
+#include "parallel_parser.h"
+#include "parser_context.h"
 #include "wasm_file.h"
 
-int yyparse();
-
 void PrintUsage(char* exec_name) {
   std::cerr << "Usage: " << exec_name << " <filename>" << std::endl;
-  std::cerr << "\tOption is: -n/--no-opt, no verification and no optimizations\n" << std::endl;
+  std::cerr << "\tOption is: -n/--no-opt, no verification and no optimizations" << std::endl;
+  std::cerr << "\tOption is: -j N/--jobs=N, parse the top-level forms and run the function passes with N threads" << std::endl;
+  std::cerr << "\tOption is: -c DIR/--ast-cache=DIR, reuse the AST of an unchanged input from DIR" << std::endl;
+  std::cerr << "\tOption is: -p LIST/--passes=LIST, comma-separated Wasm passes to run instead of the default ones, the type annotation always runs last" << std::endl;
+  std::cerr << "\tOption is: -t/--time-passes, print the time spent in each Wasm pass" << std::endl;
+  std::cerr << "\tOption is: -s/--static-memory, use a global array as the memory of the modules that never grow it" << std::endl;
+  std::cerr << "\tOption is: -v LIST/--vectorize=LIST, comma-separated exports whose loops are vectorized whatever the cost model says" << std::endl;
+  std::cerr << "\tOption is: -w N/--vectorize-width=N, vectorization width of the loops" << std::endl;
+  std::cerr << "\tOption is: -i N/--interleave=N, interleave count of the vectorized loops" << std::endl;
+  std::cerr << "\tOption is: -r FILE/--remarks=FILE, write the LLVM optimization remarks in YAML to FILE, keyed by .wast line" << std::endl;
+  std::cerr << "\tOption is: -f[LIST]/--fast-math[=LIST], relaxed floating point for the comma-separated modules and exports, all of them without a list" << std::endl;
+  std::cerr << "\tOption is: -z[LIST]/--flush-denormals[=LIST], exports of the comma-separated modules flush denormals to zero, all of them without a list" << std::endl;
+  std::cerr << "\tOption is: -Z/--flush-denormals-at-init, wasm_llvm_init flushes denormals to zero for the whole process" << std::endl;
+}
+
+static WasmFile* ParseInput(const char* file_name, const std::string& input) {
+  int jobs = Globals::Get()->GetJobs();
+
+  if (jobs > 1) {
+    ParallelParser parser(file_name, input, jobs);
+    return parser.Parse();
+  }
+
+  ParserContext context(file_name);
+
+  if (context.Parse(input.c_str(), input.size()) == false) {
+    return nullptr;
+  }
+
+  return context.GetWasmFile();
 }
 
 int main(int argc, char** argv) {
@@ -39,12 +70,24 @@ int main(int argc, char** argv) {
   struct option long_options[] = {
     {"no-opt", 0, 0, 'n'},
     {"help", 0, 0, 'h'},
+    {"jobs", 1, 0, 'j'},
+    {"ast-cache", 1, 0, 'c'},
+    {"passes", 1, 0, 'p'},
+    {"time-passes", 0, 0, 't'},
+    {"static-memory", 0, 0, 's'},
+    {"vectorize", 1, 0, 'v'},
+    {"vectorize-width", 1, 0, 'w'},
+    {"interleave", 1, 0, 'i'},
+    {"remarks", 1, 0, 'r'},
+    {"fast-math", 2, 0, 'f'},
+    {"flush-denormals", 2, 0, 'z'},
+    {"flush-denormals-at-init", 0, 0, 'Z'},
     {nullptr, 0, 0, 0}
   };
 
   while (1) {
     int idx = 0;
-    int c = getopt_long(argc, argv, "nh", long_options, &idx);
+    int c = getopt_long(argc, argv, "nhj:c:p:tsv:w:i:r:f::z::Z", long_options, &idx);
 
     if (c == -1) {
       break;
@@ -55,6 +98,66 @@ int main(int argc, char** argv) {
         std::cerr << "Disabling Verifications and Optimizations" << std::endl;
         Globals::Get()->DisableVerificationOptimization();
         break;
+      case 'j': {
+        int jobs = atoi(optarg);
+
+        if (jobs < 1) {
+          PrintUsage(argv[0]);
+          return EXIT_FAILURE;
+        }
+
+        Globals::Get()->SetJobs(jobs);
+        break;
+      }
+      case 'c':
+        Globals::Get()->SetAstCacheDirectory(optarg);
+        break;
+      case 'p':
+        Globals::Get()->SetPassList(optarg);
+        break;
+      case 't':
+        Globals::Get()->EnableTimePasses();
+        break;
+      case 's':
+        Globals::Get()->EnableStaticMemory();
+        break;
+      case 'v':
+        Globals::Get()->SetVectorizeList(optarg);
+        break;
+      case 'w': {
+        int width = atoi(optarg);
+
+        if (width < 1) {
+          PrintUsage(argv[0]);
+          return EXIT_FAILURE;
+        }
+
+        Globals::Get()->SetVectorizeWidth(width);
+        break;
+      }
+      case 'i': {
+        int count = atoi(optarg);
+
+        if (count < 1) {
+          PrintUsage(argv[0]);
+          return EXIT_FAILURE;
+        }
+
+        Globals::Get()->SetInterleaveCount(count);
+        break;
+      }
+      case 'r':
+        Globals::Get()->SetRemarksFile(optarg);
+        break;
+      case 'f':
+        Globals::Get()->EnableFastMath(optarg);
+        break;
+      case 'z':
+        Globals::Get()->EnableFlushDenormals(optarg);
+        break;
+      case 'Z':
+        Globals::Get()->EnableFlushDenormalsAtInit();
+        break;
       case 'h':
         PrintUsage(argv[0]);
         return EXIT_SUCCESS;
@@ -64,23 +167,52 @@ int main(int argc, char** argv) {
     }
   }
 
-  // Set up global variable singleton.
-  Globals::Get()->SetFileName(argv[1]);
+  const char* file_name = argv[argc - 1];
+  Globals::Get()->SetInputFileName(file_name);
 
-  BISON_PRINT("Parsing %s\n", argv[1]);
+  BISON_PRINT("Parsing %s\n", file_name);
 
-  FILE* f = freopen(argv[argc - 1], "r", stdin);
+  FILE* f = fopen(file_name, "r");
 
   if (f == nullptr) {
-    std::cerr << "File " << argv[argc - 1] << " not opening" << std::endl;
+    std::cerr << "File " << file_name << " not opening" << std::endl;
     PrintUsage(argv[0]);
     return EXIT_FAILURE;
   }
 
-  if (yyparse() == 0) {
-    BISON_PRINT("Done Parsing %s\n", argv[1]);
+  // Get the whole input in memory: it is hashed for the AST cache and shared by the parsers.
+  std::string input;
+  char tmp[4096];
+  size_t read;
+
+  while ((read = fread(tmp, 1, sizeof(tmp), f)) > 0) {
+    input.append(tmp, read);
+  }
+
+  fclose(f), f = nullptr;
+
+  WasmFile* file = nullptr;
+  const char* cache_directory = Globals::Get()->GetAstCacheDirectory();
+
+  if (cache_directory != nullptr) {
+    AstCache cache(cache_directory);
+    uint64_t hash = AstCache::Hash(input.c_str(), input.size());
+
+    file = cache.Load(hash);
+
+    if (file == nullptr) {
+      file = ParseInput(file_name, input);
+
+      if (file != nullptr && cache.Store(file, hash) == false) {
+        BISON_PRINT("Could not store the AST of %s in %s\n", file_name, cache_directory);
+      }
+    }
+  } else {
+    file = ParseInput(file_name, input);
+  }
 
-    WasmFile* file = Globals::Get()->GetWasmFile();
+  if (file != nullptr) {
+    BISON_PRINT("Done Parsing %s\n", file_name);
 
     Driver driver(file);
     driver.Drive();
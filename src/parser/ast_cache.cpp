@@ -0,0 +1,1169 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include "ast_cache.h"
+#include "binop.h"
+#include "debug.h"
+#include "expression.h"
+#include "function.h"
+#include "function_field.h"
+#include "import_function.h"
+#include "local.h"
+#include "memory.h"
+#include "module.h"
+#include "operation.h"
+#include "parser_context.h"
+#include "simple.h"
+#include "switch_expression.h"
+#include "wasm_file.h"
+#include "wasm_script.h"
+#include "wasm_script_elem.h"
+
+// Bump the version each time the format changes: older entries are then ignored.
+static const char kAstCacheMagic[8] = {'W', 'A', 'S', 'M', 'A', 'S', 'T', '\0'};
+static const uint32_t kAstCacheVersion = 4;
+
+// Lists use ~0 as their size when they are a nullptr.
+static const uint32_t kNullList = ~0u;
+
+struct AstCacheHeader {
+  char magic_[8];
+  uint32_t version_;
+  uint32_t padding_;
+  uint64_t hash_;
+  uint64_t records_size_;
+  uint64_t strings_size_;
+};
+
+void AstWriter::WriteString(const char* s) {
+  // Offset 0 is the nullptr, the others are shifted by one.
+  if (s == nullptr) {
+    WriteU32(0);
+    return;
+  }
+
+  uint32_t offset = 0;
+  auto iter = string_offsets_.find(s);
+
+  if (iter != string_offsets_.end()) {
+    offset = iter->second;
+  } else {
+    offset = strings_.size() + 1;
+    strings_.append(s, strlen(s) + 1);
+    string_offsets_[s] = offset;
+  }
+
+  WriteU32(offset);
+}
+
+void AstWriter::WriteVariable(const Variable* var) {
+  WriteBool(var != nullptr);
+
+  if (var == nullptr) {
+    return;
+  }
+
+  WriteBool(var->IsString());
+
+  if (var->IsString() == true) {
+    WriteString(var->GetString());
+  } else {
+    WriteI64(var->GetIdx());
+  }
+}
+
+void AstWriter::WriteOperation(const Operation* op) {
+  const ConversionOperation* conversion = dynamic_cast<const ConversionOperation*>(op);
+
+  WriteBool(conversion != nullptr);
+  WriteU32(op->GetOperation());
+  WriteBool(op->GetSignedOrOrdered());
+  WriteU32(op->GetType());
+
+  if (conversion != nullptr) {
+    WriteU32(conversion->GetSrc());
+  }
+}
+
+void AstWriter::WriteValue(const ValueHolder* value) {
+  WriteU8(value->type_);
+
+  // The whole union is kept: floating point values keep their exact bits.
+  if (value->type_ == VH_STRING) {
+    WriteString(value->value_.s);
+  } else {
+    WriteI64(value->value_.i);
+  }
+}
+
+void AstWriter::WriteLocal(const Local* local) {
+  const std::deque<LocalElem*>& elems = local->GetList();
+
+  WriteU32(elems.size());
+
+  for (auto elem : elems) {
+    WriteU32(elem->GetType());
+    WriteString(elem->GetName());
+  }
+}
+
+void AstWriter::WriteExpression(const Expression* expr) {
+  if (expr == nullptr) {
+    WriteTag(AST_NULL);
+    return;
+  }
+
+  expr->Serialize(*this);
+
+  // Every node is followed by its line.
+  WriteU32(expr->GetLine());
+}
+
+void AstWriter::WriteExpressions(const std::list<Expression*>* list) {
+  if (list == nullptr) {
+    WriteU32(kNullList);
+    return;
+  }
+
+  WriteU32(list->size());
+
+  for (auto expr : *list) {
+    WriteExpression(expr);
+  }
+}
+
+void AstWriter::WriteCaseDefinition(const CaseDefinition* def) {
+  // 0 is no definition, 1 a variable, and 2 an expression.
+  const VariableCaseDefinition* var_def = llvm::dyn_cast_or_null<const VariableCaseDefinition>(def);
+  const ExpressionCaseDefinition* expr_def = llvm::dyn_cast_or_null<const ExpressionCaseDefinition>(def);
+
+  if (var_def != nullptr) {
+    WriteU8(1);
+    WriteVariable(var_def->GetVariable());
+  } else if (expr_def != nullptr) {
+    WriteU8(2);
+    WriteExpression(expr_def->GetExpression());
+  } else {
+    WriteU8(0);
+  }
+}
+
+void AstWriter::WriteField(const FunctionField* field) {
+  const ParamField* pf = llvm::dyn_cast<ParamField>(field);
+
+  if (pf != nullptr) {
+    WriteTag(AST_PARAM_FIELD);
+    WriteLocal(pf->GetLocal());
+    return;
+  }
+
+  const ResultField* rf = llvm::dyn_cast<ResultField>(field);
+
+  if (rf != nullptr) {
+    WriteTag(AST_RESULT_FIELD);
+    WriteU32(rf->GetType());
+    return;
+  }
+
+  const LocalField* lf = llvm::dyn_cast<LocalField>(field);
+
+  if (lf != nullptr) {
+    WriteTag(AST_LOCAL_FIELD);
+    WriteLocal(lf->GetLocal());
+    return;
+  }
+
+  const ExpressionField* ef = llvm::dyn_cast<ExpressionField>(field);
+
+  if (ef != nullptr) {
+    WriteTag(AST_EXPRESSION_FIELD);
+    WriteExpression(ef->GetExpression());
+    return;
+  }
+
+  // Lazy bodies are handled by WriteFunction.
+  BISON_PRINT("No serialization for this function field\n");
+  assert(0);
+}
+
+void AstWriter::WriteFields(const std::list<FunctionField*>* fields) {
+  if (fields == nullptr) {
+    WriteU32(kNullList);
+    return;
+  }
+
+  WriteU32(fields->size());
+
+  for (auto field : *fields) {
+    WriteField(field);
+  }
+}
+
+static bool ParseLazyBody(const LazyBodyField* lazy, std::list<FunctionField*>& body) {
+  // Only freshly parsed files are stored.
+  if (lazy->IsCached() == true) {
+    return false;
+  }
+
+  ParserContext context(lazy->GetFileName(), lazy->GetLine());
+  const std::string& text = lazy->GetText();
+
+  if (context.ParseBody(text.c_str(), text.size()) == false) {
+    return false;
+  }
+
+  std::list<FunctionField*>* fields = context.GetBodyFields();
+  body.splice(body.end(), *fields);
+  delete fields, fields = nullptr;
+
+  return true;
+}
+
+void AstWriter::WriteFunction(WasmFunction* fct) {
+  WriteString(fct->GetName());
+
+  // Split the signature from the body: the fields after the first expression are the body.
+  std::list<FunctionField*> signature;
+  std::list<FunctionField*> body;
+  std::list<FunctionField*>* fields = fct->GetFields();
+  bool in_body = false;
+
+  if (fields != nullptr) {
+    for (auto field : *fields) {
+      const LazyBodyField* lazy = llvm::dyn_cast<LazyBodyField>(field);
+
+      if (lazy != nullptr) {
+        // The cache stores parsed bodies: the text is parsed now.
+        if (ParseLazyBody(lazy, body) == false) {
+          BISON_PRINT("AST cache: could not parse the body of %s\n", fct->GetName().c_str());
+          failed_ = true;
+        }
+
+        in_body = true;
+        continue;
+      }
+
+      if (llvm::isa<ExpressionField>(field)) {
+        in_body = true;
+      }
+
+      if (in_body == true) {
+        body.push_back(field);
+      } else {
+        signature.push_back(field);
+      }
+    }
+  }
+
+  WriteFields(&signature);
+
+  // The body is prefixed by its size: the reader leaves it in the mapping until it is needed.
+  size_t size_position = records_.size();
+  WriteU32(0);
+  size_t start = records_.size();
+
+  if (body.empty() == false) {
+    WriteFields(&body);
+  }
+
+  uint32_t size = records_.size() - start;
+  memcpy(&records_[size_position], &size, sizeof(size));
+}
+
+void AstWriter::WriteImportFunction(WasmImportFunction* wif) {
+  WriteString(wif->GetName());
+  WriteString(wif->GetModuleName());
+  WriteString(wif->GetFunctionName());
+  WriteFields(wif->GetFields());
+}
+
+void AstWriter::WriteExport(WasmExport* exp) {
+  WriteString(exp->GetName());
+  WriteVariable(exp->GetVariable());
+}
+
+void AstWriter::WriteModule(WasmModule* module) {
+  WriteU32(module->GetLine());
+
+  std::list<WasmFunction*>& functions = module->GetWasmFunctions();
+  WriteU32(functions.size());
+
+  for (auto fct : functions) {
+    WriteFunction(fct);
+  }
+
+  const std::list<WasmExport*>& exports = module->GetExports();
+  WriteU32(exports.size());
+
+  for (auto exp : exports) {
+    WriteExport(exp);
+  }
+
+  const std::list<WasmImportFunction*>& imports = module->GetImportFunctions();
+  WriteU32(imports.size());
+
+  for (auto wif : imports) {
+    WriteImportFunction(wif);
+  }
+
+  // The memory is -1 when the module does not define any.
+  int64_t memory = module->GetMemory();
+  WriteI64(memory);
+
+  if (memory != -1) {
+    WriteI64(module->GetMaxMemory());
+
+    std::list<Segment*>* segments = module->GetSegments();
+
+    if (segments == nullptr) {
+      WriteU32(kNullList);
+    } else {
+      WriteU32(segments->size());
+
+      for (auto segment : *segments) {
+        WriteU32(segment->GetStart());
+        WriteString(segment->GetData());
+      }
+    }
+  }
+}
+
+void AstWriter::WriteScriptElem(WasmScriptElem* elem, const std::vector<WasmModule*>& modules) {
+  // Most derived first: an assert return nan or an assert invalid is also an assert return.
+  if (llvm::isa<WasmAssertInvalid>(elem)) {
+    WriteTag(AST_ASSERT_INVALID);
+  } else if (llvm::isa<WasmAssertReturnNan>(elem)) {
+    WriteTag(AST_ASSERT_RETURN_NAN);
+  } else if (llvm::isa<WasmAssertReturn>(elem)) {
+    WriteTag(AST_ASSERT_RETURN);
+  } else if (llvm::isa<WasmAssertTrap>(elem)) {
+    WriteTag(AST_ASSERT_TRAP);
+  } else if (llvm::isa<WasmInvoke>(elem)) {
+    WriteTag(AST_INVOKE);
+  } else {
+    BISON_PRINT("AST cache: unknown script element %s\n", elem->GetName().c_str());
+    failed_ = true;
+    WriteTag(AST_NULL);
+  }
+
+  WriteU32(elem->GetLine());
+  WriteExpression(elem->GetExpression());
+
+  // The module is written with the others: refer to it by its index.
+  WasmAssertInvalid* invalid = llvm::dyn_cast<WasmAssertInvalid>(elem);
+
+  if (invalid != nullptr) {
+    auto it = std::find(modules.begin(), modules.end(), invalid->GetModule());
+    assert(it != modules.end());
+
+    WriteU32(it - modules.begin());
+    WriteString(invalid->GetErrorMessage());
+  }
+}
+
+bool AstWriter::WriteFile(WasmFile* file) {
+  std::vector<WasmModule*>& modules = file->GetWasmModules();
+  WriteU32(modules.size());
+
+  for (auto module : modules) {
+    WriteModule(module);
+  }
+
+  const std::deque<WasmScriptElem*>& elems = file->GetScript().GetScriptElems();
+  WriteU32(elems.size());
+
+  for (auto elem : elems) {
+    WriteScriptElem(elem, modules);
+  }
+
+  return failed_ == false;
+}
+
+bool AstWriter::Save(const char* path, uint64_t hash) const {
+  // Write a temporary file first: concurrent compiles never see a partial entry.
+  std::ostringstream oss;
+  oss << path << "." << getpid() << ".tmp";
+  std::string tmp_path = oss.str();
+
+  FILE* f = fopen(tmp_path.c_str(), "wb");
+
+  if (f == nullptr) {
+    return false;
+  }
+
+  AstCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic_, kAstCacheMagic, sizeof(header.magic_));
+  header.version_ = kAstCacheVersion;
+  header.hash_ = hash;
+  header.records_size_ = records_.size();
+  header.strings_size_ = strings_.size();
+
+  bool res = (fwrite(&header, sizeof(header), 1, f) == 1);
+  res = res && (records_.empty() == true || fwrite(records_.data(), records_.size(), 1, f) == 1);
+  res = res && (strings_.empty() == true || fwrite(strings_.data(), strings_.size(), 1, f) == 1);
+  res = (fclose(f) == 0) && res;
+
+  if (res == true) {
+    res = (rename(tmp_path.c_str(), path) == 0);
+  }
+
+  if (res == false) {
+    unlink(tmp_path.c_str());
+  }
+
+  return res;
+}
+
+void AstReader::ReadRaw(void* data, size_t size) {
+  assert(pos_ + size <= size_);
+  memcpy(data, records_ + pos_, size);
+  pos_ += size;
+}
+
+char* AstReader::ReadString() {
+  uint32_t offset = ReadU32();
+
+  if (offset == 0) {
+    return nullptr;
+  }
+
+  // The mapping is private: the AST is free to write to its strings.
+  return const_cast<char*>(strings_ + offset - 1);
+}
+
+Variable* AstReader::ReadVariable() {
+  if (ReadBool() == false) {
+    return nullptr;
+  }
+
+  if (ReadBool() == true) {
+    const char* name = ReadString();
+    return new Variable(name);
+  }
+
+  return new Variable(ReadI64());
+}
+
+Operation* AstReader::ReadOperation() {
+  bool is_conversion = ReadBool();
+  OPERATION op = static_cast<OPERATION>(ReadU32());
+  bool sign_or_order = ReadBool();
+  ETYPE type = static_cast<ETYPE>(ReadU32());
+
+  if (is_conversion == true) {
+    ETYPE src = static_cast<ETYPE>(ReadU32());
+    return new ConversionOperation(op, sign_or_order, type, src);
+  }
+
+  return new Operation(op, sign_or_order, type);
+}
+
+ValueHolder* AstReader::ReadValue() {
+  VH_TYPE type = static_cast<VH_TYPE>(ReadU8());
+
+  if (type == VH_STRING) {
+    return new ValueHolder(ReadString());
+  }
+
+  ValueHolder* value = new ValueHolder(ReadI64());
+  value->type_ = type;
+
+  return value;
+}
+
+Local* AstReader::ReadLocal() {
+  uint32_t nbr = ReadU32();
+  std::vector<LocalElem> elems;
+
+  for (uint32_t i = 0; i < nbr; i++) {
+    ETYPE type = static_cast<ETYPE>(ReadU32());
+    char* name = ReadString();
+    elems.push_back(LocalElem(type, name));
+  }
+
+  // Elements are added in front.
+  Local* local = new Local();
+
+  for (auto it = elems.rbegin(); it != elems.rend(); it++) {
+    local->AddElem(it->type_, it->name_);
+  }
+
+  return local;
+}
+
+std::list<Expression*>* AstReader::ReadExpressions() {
+  uint32_t nbr = ReadU32();
+
+  if (nbr == kNullList) {
+    return nullptr;
+  }
+
+  std::list<Expression*>* list = new std::list<Expression*>();
+
+  for (uint32_t i = 0; i < nbr; i++) {
+    list->push_back(ReadExpression());
+  }
+
+  return list;
+}
+
+CaseDefinition* AstReader::ReadCaseDefinition() {
+  uint8_t kind = ReadU8();
+
+  switch (kind) {
+    case 1:
+      return new VariableCaseDefinition(ReadVariable());
+    case 2:
+      return new ExpressionCaseDefinition(ReadExpression());
+    default:
+      return nullptr;
+  }
+}
+
+Expression* AstReader::ReadExpression() {
+  Expression* expr = ReadExpressionNode();
+
+  if (expr != nullptr) {
+    expr->SetLine(ReadU32());
+  }
+
+  return expr;
+}
+
+Expression* AstReader::ReadExpressionNode() {
+  AstTag tag = static_cast<AstTag>(ReadU8());
+
+  switch (tag) {
+    case AST_NULL:
+      return nullptr;
+    case AST_NOP:
+      return new Nop();
+    case AST_UNOP: {
+      Operation* op = ReadOperation();
+      Expression* only = ReadExpression();
+      return new Unop(op, only);
+    }
+    case AST_BINOP: {
+      Operation* op = ReadOperation();
+      Expression* left = ReadExpression();
+      Expression* right = ReadExpression();
+      return new Binop(op, left, right);
+    }
+    case AST_GET_LOCAL:
+      return new GetLocal(ReadVariable());
+    case AST_SET_LOCAL: {
+      Variable* var = ReadVariable();
+      Expression* value = ReadExpression();
+      return new SetLocal(var, value);
+    }
+    case AST_IF: {
+      Expression* cond = ReadExpression();
+      Expression* true_cond = ReadExpression();
+      Expression* false_cond = ReadExpression();
+      return new IfExpression(cond, true_cond, false_cond);
+    }
+    case AST_CONST: {
+      ETYPE type = static_cast<ETYPE>(ReadU32());
+      ValueHolder* value = ReadValue();
+      return new Const(type, value);
+    }
+    case AST_CALL:
+    case AST_CALL_IMPORT: {
+      Variable* var = ReadVariable();
+      std::list<Expression*>* params = ReadExpressions();
+
+      if (tag == AST_CALL) {
+        return new CallExpression(var, params);
+      }
+
+      return new CallImportExpression(var, params);
+    }
+    case AST_RETURN:
+      return new ReturnExpression(ReadExpression());
+    case AST_LOOP: {
+      Variable* var = ReadVariable();
+      Variable* exit_name = ReadVariable();
+      std::list<Expression*>* list = ReadExpressions();
+      return new LoopExpression(var, exit_name, list);
+    }
+    case AST_LABEL: {
+      Variable* var = ReadVariable();
+      Expression* expr = ReadExpression();
+      return new LabelExpression(var, expr);
+    }
+    case AST_BREAK: {
+      Variable* var = ReadVariable();
+      Expression* expr = ReadExpression();
+      return new BreakExpression(var, expr);
+    }
+    case AST_BREAK_IF: {
+      Expression* cond = ReadExpression();
+      Variable* var = ReadVariable();
+      Expression* expr = ReadExpression();
+      return new BreakIfExpression(cond, var, expr);
+    }
+    case AST_BLOCK: {
+      const char* name = ReadString();
+      std::list<Expression*>* list = ReadExpressions();
+      return new BlockExpression(name, list);
+    }
+    case AST_STRING:
+      return new StringExpression(ReadString());
+    case AST_UNREACHABLE:
+      return new Unreachable();
+    case AST_SELECT: {
+      ETYPE type = static_cast<ETYPE>(ReadU32());
+      Expression* cond = ReadExpression();
+      Expression* first = ReadExpression();
+      Expression* second = ReadExpression();
+      return new SelectExpression(type, cond, first, second);
+    }
+    case AST_STORE:
+    case AST_LOAD: {
+      MemoryExpression* mem = nullptr;
+      Store* store = nullptr;
+
+      if (tag == AST_STORE) {
+        store = new Store();
+        mem = store;
+      } else {
+        mem = new Load();
+      }
+
+      mem->SetAddress(ReadExpression());
+      mem->SetSize(ReadU32());
+      mem->SetSign(ReadBool());
+      mem->SetType(static_cast<ETYPE>(ReadU32()));
+
+      uint32_t offset = ReadU32();
+      uint32_t align = ReadU32();
+      mem->SetOffsetAlign(offset, align);
+
+      if (store != nullptr) {
+        store->SetValue(ReadExpression());
+      }
+
+      return mem;
+    }
+    case AST_MEMORY_SIZE:
+      return new MemorySize();
+    case AST_MEMORY_GROW:
+      return new MemoryGrow(ReadExpression());
+    case AST_SWITCH: {
+      const char* name = ReadString();
+      Expression* selector = ReadExpression();
+
+      std::list<CaseDefinition*>* index_table = nullptr;
+      uint32_t nbr = ReadU32();
+
+      if (nbr != kNullList) {
+        index_table = new std::list<CaseDefinition*>();
+
+        for (uint32_t i = 0; i < nbr; i++) {
+          index_table->push_back(ReadCaseDefinition());
+        }
+      }
+
+      CaseDefinition* default_case = ReadCaseDefinition();
+
+      std::list<CaseExpression*>* cases = nullptr;
+      nbr = ReadU32();
+
+      if (nbr != kNullList) {
+        cases = new std::list<CaseExpression*>();
+
+        for (uint32_t i = 0; i < nbr; i++) {
+          CaseExpression* one_case = llvm::dyn_cast_or_null<CaseExpression>(ReadExpression());
+          assert(one_case != nullptr);
+          cases->push_back(one_case);
+        }
+      }
+
+      return new SwitchExpression(name, selector, index_table, default_case, cases);
+    }
+    case AST_CASE: {
+      const char* id = ReadString();
+      std::list<Expression*>* list = ReadExpressions();
+      return new CaseExpression(id, list);
+    }
+    default:
+      break;
+  }
+
+  BISON_PRINT("AST cache: unknown expression tag %d\n", tag);
+  assert(0);
+  return nullptr;
+}
+
+FunctionField* AstReader::ReadField() {
+  AstTag tag = static_cast<AstTag>(ReadU8());
+
+  switch (tag) {
+    case AST_PARAM_FIELD:
+      return new ParamField(ReadLocal());
+    case AST_RESULT_FIELD:
+      return new ResultField(ReadU32());
+    case AST_LOCAL_FIELD:
+      return new LocalField(ReadLocal());
+    case AST_EXPRESSION_FIELD:
+      return new ExpressionField(ReadExpression());
+    default:
+      break;
+  }
+
+  BISON_PRINT("AST cache: unknown field tag %d\n", tag);
+  assert(0);
+  return nullptr;
+}
+
+std::list<FunctionField*>* AstReader::ReadFields() {
+  uint32_t nbr = ReadU32();
+
+  if (nbr == kNullList) {
+    return nullptr;
+  }
+
+  std::list<FunctionField*>* fields = new std::list<FunctionField*>();
+
+  for (uint32_t i = 0; i < nbr; i++) {
+    fields->push_back(ReadField());
+  }
+
+  return fields;
+}
+
+WasmFunction* AstReader::ReadFunction() {
+  std::string name = ReadString();
+  std::list<FunctionField*>* fields = ReadFields();
+  uint32_t body_size = ReadU32();
+
+  if (body_size > 0) {
+    // Leave the body in the mapping: it is only decoded if the function is reachable.
+    assert(pos_ + body_size <= size_);
+    fields->push_back(new LazyBodyField(records_ + pos_, body_size, strings_));
+    pos_ += body_size;
+  }
+
+  return new WasmFunction(fields, name);
+}
+
+WasmImportFunction* AstReader::ReadImportFunction() {
+  std::string name = ReadString();
+  std::string module_name = ReadString();
+  std::string function_name = ReadString();
+  std::list<FunctionField*>* fields = ReadFields();
+
+  return new WasmImportFunction(module_name, function_name, fields, name);
+}
+
+WasmExport* AstReader::ReadExport() {
+  std::string name = ReadString();
+  Variable* var = ReadVariable();
+
+  return new WasmExport(name, var);
+}
+
+WasmModule* AstReader::ReadModule() {
+  WasmModule* module = new WasmModule();
+  module->SetLine(ReadU32());
+
+  // The module's lists are built by adding in front: read everything first.
+  std::vector<WasmFunction*> functions;
+  uint32_t nbr = ReadU32();
+
+  for (uint32_t i = 0; i < nbr; i++) {
+    functions.push_back(ReadFunction());
+  }
+
+  for (auto it = functions.rbegin(); it != functions.rend(); it++) {
+    module->AddFunction(*it);
+  }
+
+  std::vector<WasmExport*> exports;
+  nbr = ReadU32();
+
+  for (uint32_t i = 0; i < nbr; i++) {
+    exports.push_back(ReadExport());
+  }
+
+  for (auto it = exports.rbegin(); it != exports.rend(); it++) {
+    module->AddExport(*it);
+  }
+
+  std::vector<WasmImportFunction*> imports;
+  nbr = ReadU32();
+
+  for (uint32_t i = 0; i < nbr; i++) {
+    imports.push_back(ReadImportFunction());
+  }
+
+  for (auto it = imports.rbegin(); it != imports.rend(); it++) {
+    module->AddImportFunction(*it);
+  }
+
+  int64_t memory = ReadI64();
+
+  if (memory != -1) {
+    uint64_t max_memory = ReadI64();
+
+    std::list<Segment*>* segments = nullptr;
+    nbr = ReadU32();
+
+    if (nbr != kNullList) {
+      segments = new std::list<Segment*>();
+
+      for (uint32_t i = 0; i < nbr; i++) {
+        int start = ReadU32();
+        char* data = ReadString();
+        segments->push_back(new Segment(start, data));
+      }
+    }
+
+    if (max_memory == ~0ull) {
+      module->AddMemory(memory, segments);
+    } else {
+      module->AddMemory(memory, max_memory, segments);
+    }
+  }
+
+  return module;
+}
+
+WasmScriptElem* AstReader::ReadScriptElem(const std::vector<WasmModule*>& modules) {
+  AstTag tag = static_cast<AstTag>(ReadU8());
+  int line = ReadU32();
+  Expression* expr = ReadExpression();
+
+  WasmScriptElem* elem = nullptr;
+
+  switch (tag) {
+    case AST_ASSERT_RETURN:
+      elem = new WasmAssertReturn(expr);
+      break;
+    case AST_ASSERT_RETURN_NAN:
+      elem = new WasmAssertReturnNan(expr);
+      break;
+    case AST_ASSERT_TRAP:
+      elem = new WasmAssertTrap(expr);
+      break;
+    case AST_INVOKE:
+      elem = new WasmInvoke(expr);
+      break;
+    case AST_ASSERT_INVALID: {
+      uint32_t idx = ReadU32();
+      assert(idx < modules.size());
+
+      elem = new WasmAssertInvalid(modules[idx], ReadString());
+      break;
+    }
+    default:
+      BISON_PRINT("AST cache: unknown script element tag %d\n", tag);
+      assert(0);
+      return nullptr;
+  }
+
+  elem->SetLine(line);
+  return elem;
+}
+
+WasmFile* AstReader::ReadFile() {
+  WasmFile* file = new WasmFile();
+
+  uint32_t nbr = ReadU32();
+
+  for (uint32_t i = 0; i < nbr; i++) {
+    file->AddModule(ReadModule());
+  }
+
+  // Script elements are added in front.
+  std::vector<WasmScriptElem*> elems;
+  nbr = ReadU32();
+
+  for (uint32_t i = 0; i < nbr; i++) {
+    elems.push_back(ReadScriptElem(file->GetWasmModules()));
+  }
+
+  for (auto it = elems.rbegin(); it != elems.rend(); it++) {
+    file->AddScriptElem(*it);
+  }
+
+  // The constructors took numbers from the global counters: give back the parse's names.
+  file->RenumberInSourceOrder();
+
+  return file;
+}
+
+uint64_t AstCache::Hash(const char* data, size_t length) {
+  // FNV-1a: the key only has to tell inputs apart.
+  uint64_t hash = 14695981039346656037ull;
+
+  for (size_t i = 0; i < length; i++) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 1099511628211ull;
+  }
+
+  return hash;
+}
+
+std::string AstCache::GetPath(uint64_t hash) const {
+  std::ostringstream oss;
+  oss << directory_ << "/" << std::hex << std::setw(16) << std::setfill('0') << hash << ".ast";
+  return oss.str();
+}
+
+WasmFile* AstCache::Load(uint64_t hash) const {
+  std::string path = GetPath(hash);
+  int fd = open(path.c_str(), O_RDONLY);
+
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  struct stat st;
+
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(AstCacheHeader)) {
+    close(fd);
+    return nullptr;
+  }
+
+  // Private mapping: nothing done to the AST's strings goes back to the file.
+  size_t size = st.st_size;
+  void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (ptr == MAP_FAILED) {
+    return nullptr;
+  }
+
+  const char* base = static_cast<const char*>(ptr);
+
+  AstCacheHeader header;
+  memcpy(&header, base, sizeof(header));
+
+  if (memcmp(header.magic_, kAstCacheMagic, sizeof(header.magic_)) != 0 ||
+      header.version_ != kAstCacheVersion ||
+      header.hash_ != hash ||
+      sizeof(header) + header.records_size_ + header.strings_size_ != size) {
+    munmap(ptr, size);
+    return nullptr;
+  }
+
+  BISON_PRINT("Loading the AST from %s\n", path.c_str());
+
+  // The mapping is never unmapped: the AST and the cached bodies point into it.
+  const char* records = base + sizeof(header);
+  const char* strings = records + header.records_size_;
+
+  AstReader reader(records, header.records_size_, strings);
+  return reader.ReadFile();
+}
+
+bool AstCache::Store(WasmFile* file, uint64_t hash) const {
+  AstWriter writer;
+
+  if (writer.WriteFile(file) == false) {
+    return false;
+  }
+
+  // The directory might not exist yet.
+  mkdir(directory_.c_str(), 0755);
+
+  return writer.Save(GetPath(hash).c_str(), hash);
+}
+
+// Serialization of each node: the tag comes first, then the fields in the reader's order.
+
+void Nop::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_NOP);
+}
+
+void Unop::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_UNOP);
+  writer.WriteOperation(operation_);
+  writer.WriteExpression(only_);
+}
+
+void Binop::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_BINOP);
+  writer.WriteOperation(operation_);
+  writer.WriteExpression(left_);
+  writer.WriteExpression(right_);
+}
+
+void GetLocal::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_GET_LOCAL);
+  writer.WriteVariable(var_);
+}
+
+void SetLocal::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_SET_LOCAL);
+  writer.WriteVariable(var_);
+  writer.WriteExpression(value_);
+}
+
+void IfExpression::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_IF);
+  writer.WriteExpression(cond_);
+  writer.WriteExpression(true_cond_);
+  writer.WriteExpression(false_cond_);
+}
+
+void Const::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_CONST);
+  writer.WriteU32(type_);
+  writer.WriteValue(value_);
+}
+
+void CallExpression::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_CALL);
+  writer.WriteVariable(call_id_);
+  writer.WriteExpressions(params_);
+}
+
+void CallImportExpression::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_CALL_IMPORT);
+  writer.WriteVariable(call_id_);
+  writer.WriteExpressions(params_);
+}
+
+void ReturnExpression::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_RETURN);
+  writer.WriteExpression(result_);
+}
+
+void LoopExpression::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_LOOP);
+  writer.WriteVariable(var_);
+  writer.WriteVariable(exit_name_);
+  writer.WriteExpressions(loop_);
+}
+
+void LabelExpression::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_LABEL);
+  writer.WriteVariable(var_);
+  writer.WriteExpression(expr_);
+}
+
+void BreakExpression::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_BREAK);
+  writer.WriteVariable(var_);
+  writer.WriteExpression(expr_);
+}
+
+void BreakIfExpression::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_BREAK_IF);
+  writer.WriteExpression(cond_);
+  writer.WriteVariable(var_);
+  writer.WriteExpression(expr_);
+}
+
+void BlockExpression::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_BLOCK);
+  writer.WriteString(name_);
+  writer.WriteExpressions(list_);
+}
+
+void StringExpression::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_STRING);
+  writer.WriteString(s_);
+}
+
+void Unreachable::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_UNREACHABLE);
+}
+
+void SelectExpression::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_SELECT);
+  writer.WriteU32(type_);
+  writer.WriteExpression(cond_);
+  writer.WriteExpression(first_);
+  writer.WriteExpression(second_);
+}
+
+void MemoryExpression::SerializeMemoryInformation(AstWriter& writer) const {
+  writer.WriteExpression(address_);
+  writer.WriteU32(size_);
+  writer.WriteBool(sign_);
+  writer.WriteU32(type_);
+  writer.WriteU32(offset_);
+  writer.WriteU32(align_);
+}
+
+void Store::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_STORE);
+  SerializeMemoryInformation(writer);
+  writer.WriteExpression(value_);
+}
+
+void Load::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_LOAD);
+  SerializeMemoryInformation(writer);
+}
+
+void MemorySize::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_MEMORY_SIZE);
+}
+
+void MemoryGrow::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_MEMORY_GROW);
+  writer.WriteExpression(expr_);
+}
+
+void CaseExpression::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_CASE);
+  writer.WriteString(id_);
+  writer.WriteExpressions(list_);
+}
+
+void SwitchExpression::Serialize(AstWriter& writer) const {
+  writer.WriteTag(AST_SWITCH);
+  writer.WriteString(name_);
+  writer.WriteExpression(selector_);
+
+  if (index_table_ == nullptr) {
+    writer.WriteU32(kNullList);
+  } else {
+    writer.WriteU32(index_table_->size());
+
+    for (auto def : *index_table_) {
+      writer.WriteCaseDefinition(def);
+    }
+  }
+
+  writer.WriteCaseDefinition(default_);
+
+  if (cases_ == nullptr) {
+    writer.WriteU32(kNullList);
+  } else {
+    writer.WriteU32(cases_->size());
+
+    for (auto one_case : *cases_) {
+      writer.WriteExpression(one_case);
+    }
+  }
+}
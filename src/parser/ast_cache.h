@@ -0,0 +1,235 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#ifndef H_AST_CACHE
+#define H_AST_CACHE
+
+#include <stdint.h>
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+// Forward declarations.
+class CaseDefinition;
+class Expression;
+class FunctionField;
+class Local;
+class Operation;
+class ValueHolder;
+class Variable;
+class WasmExport;
+class WasmFile;
+class WasmFunction;
+class WasmImportFunction;
+class WasmModule;
+class WasmScriptElem;
+
+/**
+ * Binary serialization of the parsed AST, used to skip lexing and parsing on repeated compiles.
+ *
+ * A cache file is a header, the records and a string table. Strings are stored once in the table
+ *   and records refer to them by offset: once the file is mapped, an offset only needs the table's
+ *   address to become a pointer. Function bodies are stored in their own span, prefixed by
+ *   its size: they are only decoded if the function is reachable, like lazily parsed bodies.
+ */
+
+enum AstTag {
+  AST_NULL,
+  AST_NOP,
+  AST_UNOP,
+  AST_BINOP,
+  AST_GET_LOCAL,
+  AST_SET_LOCAL,
+  AST_IF,
+  AST_CONST,
+  AST_CALL,
+  AST_CALL_IMPORT,
+  AST_RETURN,
+  AST_LOOP,
+  AST_LABEL,
+  AST_BREAK,
+  AST_BREAK_IF,
+  AST_BLOCK,
+  AST_STRING,
+  AST_UNREACHABLE,
+  AST_SELECT,
+  AST_STORE,
+  AST_LOAD,
+  AST_MEMORY_SIZE,
+  AST_MEMORY_GROW,
+  AST_SWITCH,
+  AST_CASE,
+  AST_PARAM_FIELD,
+  AST_RESULT_FIELD,
+  AST_LOCAL_FIELD,
+  AST_EXPRESSION_FIELD,
+  AST_ASSERT_RETURN,
+  AST_ASSERT_RETURN_NAN,
+  AST_ASSERT_TRAP,
+  AST_INVOKE,
+  AST_ASSERT_INVALID,
+};
+
+class AstWriter {
+  protected:
+    std::string records_;
+    std::string strings_;
+    std::unordered_map<std::string, uint32_t> string_offsets_;
+
+    // Set when a function body could not be parsed: the file is then not cached.
+    bool failed_;
+
+    void WriteRaw(const void* data, size_t size) {
+      records_.append(static_cast<const char*>(data), size);
+    }
+
+    void WriteFunction(WasmFunction* fct);
+    void WriteImportFunction(WasmImportFunction* wif);
+    void WriteExport(WasmExport* exp);
+    void WriteModule(WasmModule* module);
+    void WriteScriptElem(WasmScriptElem* elem, const std::vector<WasmModule*>& modules);
+
+  public:
+    AstWriter() : failed_(false) {
+    }
+
+    void WriteU8(uint8_t value) {
+      WriteRaw(&value, sizeof(value));
+    }
+
+    void WriteU32(uint32_t value) {
+      WriteRaw(&value, sizeof(value));
+    }
+
+    void WriteI64(int64_t value) {
+      WriteRaw(&value, sizeof(value));
+    }
+
+    void WriteTag(AstTag tag) {
+      WriteU8(tag);
+    }
+
+    void WriteBool(bool b) {
+      WriteU8(b ? 1 : 0);
+    }
+
+    void WriteString(const char* s);
+    void WriteString(const std::string& s) {
+      WriteString(s.c_str());
+    }
+
+    void WriteVariable(const Variable* var);
+    void WriteOperation(const Operation* op);
+    void WriteValue(const ValueHolder* value);
+    void WriteLocal(const Local* local);
+    void WriteExpression(const Expression* expr);
+    void WriteExpressions(const std::list<Expression*>* list);
+    void WriteCaseDefinition(const CaseDefinition* def);
+    void WriteField(const FunctionField* field);
+    void WriteFields(const std::list<FunctionField*>* fields);
+
+    // Returns false if the file could not be serialized.
+    bool WriteFile(WasmFile* file);
+
+    // For the in-memory uses, like copying a tree: read them back with an AstReader.
+    const std::string& GetRecords() const {
+      return records_;
+    }
+
+    const std::string& GetStrings() const {
+      return strings_;
+    }
+
+    bool Save(const char* path, uint64_t hash) const;
+};
+
+class AstReader {
+  protected:
+    const char* records_;
+    size_t size_;
+    size_t pos_;
+    const char* strings_;
+
+    void ReadRaw(void* data, size_t size);
+
+    WasmFunction* ReadFunction();
+    WasmImportFunction* ReadImportFunction();
+    WasmExport* ReadExport();
+    WasmModule* ReadModule();
+    WasmScriptElem* ReadScriptElem(const std::vector<WasmModule*>& modules);
+
+  public:
+    AstReader(const char* records, size_t size, const char* strings) :
+      records_(records), size_(size), pos_(0), strings_(strings) {
+    }
+
+    uint8_t ReadU8() {
+      uint8_t value;
+      ReadRaw(&value, sizeof(value));
+      return value;
+    }
+
+    uint32_t ReadU32() {
+      uint32_t value;
+      ReadRaw(&value, sizeof(value));
+      return value;
+    }
+
+    int64_t ReadI64() {
+      int64_t value;
+      ReadRaw(&value, sizeof(value));
+      return value;
+    }
+
+    bool ReadBool() {
+      return ReadU8() != 0;
+    }
+
+    // The string lives in the mapped file.
+    char* ReadString();
+
+    Variable* ReadVariable();
+    Operation* ReadOperation();
+    ValueHolder* ReadValue();
+    Local* ReadLocal();
+    Expression* ReadExpressionNode();
+    Expression* ReadExpression();
+    std::list<Expression*>* ReadExpressions();
+    CaseDefinition* ReadCaseDefinition();
+    FunctionField* ReadField();
+    std::list<FunctionField*>* ReadFields();
+
+    WasmFile* ReadFile();
+};
+
+class AstCache {
+  protected:
+    std::string directory_;
+
+    std::string GetPath(uint64_t hash) const;
+
+  public:
+    AstCache(const char* directory) : directory_(directory) {
+    }
+
+    static uint64_t Hash(const char* data, size_t length);
+
+    // Returns nullptr if there is no valid entry for the hash.
+    WasmFile* Load(uint64_t hash) const;
+    bool Store(WasmFile* file, uint64_t hash) const;
+};
+
+#endif
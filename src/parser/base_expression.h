@@ -18,17 +18,125 @@
 
 #include <stdio.h>
 
+#include <algorithm>
+#include <list>
+#include <type_traits>
+#include <vector>
+
 #include "debug.h"
+#include "enums.h"
 
 // Forward declaration.
+class AstWriter;
+class NameResolver;
 class WasmFunction;
 
+// The concrete node classes: classof and ExpressionVisitor dispatch on it instead of using RTTI.
+//   Classes with subclasses cover a contiguous range.
+enum ExpressionKind {
+  EXPR_BASE,
+  EXPR_NOP,
+  EXPR_UNOP,
+  EXPR_BINOP,
+  EXPR_GET_LOCAL,
+  EXPR_SET_LOCAL,
+  EXPR_IF,
+  EXPR_BREAK_IF,
+  EXPR_CONST,
+  EXPR_CALL,
+  EXPR_CALL_IMPORT,
+  EXPR_RETURN,
+  EXPR_LOOP,
+  EXPR_LABEL,
+  EXPR_BREAK,
+  EXPR_BLOCK,
+  EXPR_STRING,
+  EXPR_VALUE,
+  EXPR_UNREACHABLE,
+  EXPR_SELECT,
+  EXPR_LOAD,
+  EXPR_STORE,
+  EXPR_MEMORY_SIZE,
+  EXPR_MEMORY_GROW,
+  EXPR_CASE,
+  EXPR_SWITCH,
+};
+
 /**
  * This basic file contains the base implemetation of an expression node.
  */
 
 class Expression {
+  protected:
+    const ExpressionKind kind_;
+
+    // Stamped by the TypeAnnotator: the type of the value the code generation produces,
+    //   the code generation requires it.
+    ETYPE value_type_;
+    bool typed_;
+
+    // The line of the .wast file, 0 for the nodes created by the passes.
+    int line_;
+
+    static void ReplaceInList(std::list<Expression*>* list, Expression* old_child, Expression* new_child) {
+      if (list != nullptr) {
+        std::replace(list->begin(), list->end(), old_child, new_child);
+      }
+    }
+
+    // Helpers for ForEachChild: a missing child is skipped.
+    static bool CallOnChild(Expression* child, bool (*fct)(Expression*, void*), void* data) {
+      return child == nullptr || fct(child, data);
+    }
+
+    template <typename T>
+    static bool CallOnChildren(const std::list<T*>* list, bool (*fct)(Expression*, void*), void* data) {
+      if (list != nullptr) {
+        for (auto child : *list) {
+          if (fct(child, data) == false) {
+            return false;
+          }
+        }
+      }
+
+      return true;
+    }
+
+    static bool AppendChild(Expression* child, void* data) {
+      static_cast<std::vector<Expression*>*>(data)->push_back(child);
+      return true;
+    }
+
+    template <typename F>
+    static bool WalkChild(Expression* child, void* data) {
+      return child->Walk(*static_cast<typename std::remove_reference<F>::type*>(data));
+    }
+
   public:
+    Expression(ExpressionKind kind = EXPR_BASE) : kind_(kind), value_type_(VOID), typed_(false), line_(0) {
+    }
+
+    ExpressionKind GetKind() const {
+      return kind_;
+    }
+
+    ETYPE GetValueType() const {
+      return value_type_;
+    }
+
+    void SetValueType(ETYPE type) {
+      value_type_ = type;
+      typed_ = true;
+    }
+
+    void SetLine(int line) {
+      line_ = line;
+    }
+
+    int GetLine() const {
+      return line_;
+    }
+
     virtual void Dump(int tabs = 0) const {
       BISON_TABBED_PRINT(tabs, "(Base Expression %p)", this);
     }
@@ -37,11 +145,69 @@ class Expression {
       return false;
     }
 
-    virtual bool Walk(bool (*fct)(Expression*, void*), void* data) {
-      assert(fct != nullptr);
-      return fct(this, data);
+    // Jumping, returning or trapping terminates the current basic block: nothing can be generated after it.
+    bool IsTerminator() const {
+      return kind_ == EXPR_RETURN || kind_ == EXPR_BREAK || kind_ == EXPR_UNREACHABLE;
+    }
+
+    // Once a sub-expression jumped, returned, or trapped, the insert block is terminated: the operands after it and the node are dead.
+    //   Returns that terminator, the value the parents look for after a break, nullptr if code can still be generated.
+    static llvm::Value* GetTerminator(llvm::IRBuilder<>& builder) {
+      return builder.GetInsertBlock()->getTerminator();
+    }
+
+    typedef bool (*ChildFunction)(Expression* child, void* data);
+
+    // Call fct on the direct sub-expressions, in evaluation order, until it returns false.
+    //   Nothing is allocated: this is what Walk is built on.
+    virtual bool ForEachChild(ChildFunction fct, void* data) const {
+      (void) fct;
+      (void) data;
+
+      return true;
+    }
+
+    // Append the direct sub-expressions, in evaluation order.
+    void GetChildren(std::vector<Expression*>& children) const {
+      ForEachChild(AppendChild, &children);
     }
 
+    // Swap the direct sub-expression old_child for new_child, used by the passes rewriting the tree.
+    virtual void ReplaceChild(Expression* old_child, Expression* new_child) {
+      (void) old_child;
+      (void) new_child;
+
+      BISON_PRINT("No sub-expression to replace in this expression node\n");
+      assert(0);
+    }
+
+    // Pre-order walk of the sub-tree: stops as soon as fct returns false.
+    //   fct is any callable taking an Expression*, it gets inlined in the walk.
+    template <typename F>
+    bool Walk(F&& fct) {
+      if (fct(this) == false) {
+        return false;
+      }
+
+      return ForEachChild(WalkChild<F>, &fct);
+    }
+
+    // Rewrite the named references of the node and its children into indices.
+    virtual void ResolveNames(NameResolver& resolver) {
+      (void) resolver;
+    }
+
+    // Write the node in the AST cache format, see ast_cache.h.
+    virtual void Serialize(AstWriter& writer) const {
+      (void) writer;
+
+      BISON_PRINT("No serialization for this expression node\n");
+      assert(0);
+    }
+
+    // Code generation under the line of the node: what is generated for a sub-expression goes through here.
+    llvm::Value* Generate(WasmFunction* fct, llvm::IRBuilder<>& builder);
+
     virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
       BISON_PRINT("No code generation for this expression node\n");
 
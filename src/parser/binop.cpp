@@ -34,24 +34,16 @@ class ReallyDivRem : public Binop {
 
     virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
       assert(left_ != nullptr && right_ != nullptr);
-      Value* lv = left_->Codegen(fct, builder);
-      Value* rv = right_->Codegen(fct, builder);
+      Value* lv = GenerateOperand(left_, fct, builder);
 
-      if (lv == nullptr || rv == nullptr) {
-        return nullptr;
+      if (GetTerminator(builder) != nullptr) {
+        return lv;
       }
 
-      // Get the type.
-      ETYPE old_type = operation_->GetType();
-
-      // If it's void, we have a bit more work to do.
-      llvm::Type* lt = lv->getType();
-      llvm::Type* rt = rv->getType();
-
-      ETYPE type = HandleType(lt, rt);
+      Value* rv = GenerateOperand(right_, fct, builder);
 
-      if (old_type != type) {
-        operation_->SetType(type);
+      if (GetTerminator(builder) != nullptr) {
+        return rv;
       }
 
       if (div_ == false) {
@@ -70,17 +62,18 @@ class ReallyDivRem : public Binop {
     }
 };
 
-ETYPE Binop::HandleType(llvm::Type* lt, llvm::Type* rt) {
-  // If type is not void, the type should be the same as lt.
-  llvm::Type* chosen = lt;
-  llvm::Type* void_type = llvm::Type::getVoidTy(llvm::getGlobalContext());
+llvm::Value* Binop::GenerateOperand(Expression* operand, WasmFunction* fct, llvm::IRBuilder<>& builder) {
+  llvm::Value* value = operand->Generate(fct, builder);
 
-  if (chosen == void_type) {
-    chosen = rt;
+  // The operand jumped away: this is its terminator, the callers stop there.
+  llvm::Value* terminator = GetTerminator(builder);
+
+  if (terminator != nullptr) {
+    return terminator;
   }
 
-  // Return lt's type.
-  return ConvertType2ETYPE(chosen);
+  // A comparison is widened to the operation's integer.
+  return ConvertValue(value, operand->GetValueType(), operation_->GetType(), false, builder);
 }
 
 llvm::Value* Binop::HandleInteger(llvm::Value* lv, llvm::Value* rv, llvm::IRBuilder<>& builder) {
@@ -167,9 +160,11 @@ llvm::Value* Binop::HandleDivRem(WasmFunction* fct, llvm::IRBuilder<>& builder,
     vh = new ValueHolder((int64_t) 0x8000000000000000L);
   }
   Const* max = new Const(type, vh);
+  max->SetValueType(type);
 
   Operation* op = new Operation(EQ_OPER, true, type);
   Binop* cond = new Binop(op, left_, max);
+  cond->SetValueType(INT_1);
 
   Expression* left;
   // TODO: when rereading the spec, this does not seem right for signed divide; even rem I'm not sure.
@@ -199,23 +194,32 @@ llvm::Value* Binop::HandleDivRem(WasmFunction* fct, llvm::IRBuilder<>& builder,
     }
   }
 
+  // The nodes built here are generated right away: they get their types from the operation.
+  left->SetValueType(type);
+
   ReallyDivRem* rdr = new ReallyDivRem(left_, right_, div, sign, type);
+  rdr->SetValueType(type);
   IfExpression* left_test = new IfExpression(cond, left, rdr);
   left_test->SetBlockNames("div_left_true", "div_left_false", "div_left_end");
+  left_test->SetValueType(type);
 
   // Now we generate the test on the right side: is it -1?
   vh = new ValueHolder(-1);
   Const* minus_one = new Const(type, vh);
+  minus_one->SetValueType(type);
 
   op = new Operation(EQ_OPER, true, type);
   cond = new Binop(op, right_, minus_one);
+  cond->SetValueType(INT_1);
 
   rdr = new ReallyDivRem(left_, right_, div, sign, type);
+  rdr->SetValueType(type);
   IfExpression* final = new IfExpression(cond, left_test, rdr);
   final->SetBlockNames("div_minus1_true", "div_minus1_false", "div_minus1_end");
+  final->SetValueType(type);
 
   // Now generate code.
-  return final->Codegen(fct, builder);
+  return final->Generate(fct, builder);
 }
 
 llvm::Value* Binop::HandleIntrinsic(WasmFunction* fct, llvm::IRBuilder<>& builder) {
@@ -244,8 +248,15 @@ llvm::Value* Binop::HandleIntrinsic(WasmFunction* fct, llvm::IRBuilder<>& builde
 
   // Handle paramters.
   std::vector<Value*> args;
-  args.push_back(left_->Codegen(fct, builder));
-  args.push_back(right_->Codegen(fct, builder));
+  for (auto operand : {left_, right_}) {
+    Value* value = GenerateOperand(operand, fct, builder);
+
+    if (GetTerminator(builder) != nullptr) {
+      return value;
+    }
+
+    args.push_back(value);
+  }
 
   return builder.CreateCall(intrinsic_fct, args, "calltmp");
 }
@@ -278,24 +289,16 @@ llvm::Value* Binop::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
   }
 
   assert(left_ != nullptr && right_ != nullptr);
-  Value* lv = left_->Codegen(fct, builder);
-  Value* rv = right_->Codegen(fct, builder);
+  Value* lv = GenerateOperand(left_, fct, builder);
 
-  if (lv == nullptr || rv == nullptr) {
-    return nullptr;
+  if (GetTerminator(builder) != nullptr) {
+    return lv;
   }
 
-  // Get the type.
-  ETYPE old_type = type;
-
-  // If it's void, we have a bit more work to do.
-  llvm::Type* lt = lv->getType();
-  llvm::Type* rt = rv->getType();
-
-  type = HandleType(lt, rt);
+  Value* rv = GenerateOperand(right_, fct, builder);
 
-  if (old_type != type) {
-    operation_->SetType(type);
+  if (GetTerminator(builder) != nullptr) {
+    return rv;
   }
 
   if (type == FLOAT_32 || type == FLOAT_64) {
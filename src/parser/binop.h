@@ -32,19 +32,31 @@ class Binop : public Expression {
     Operation* operation_;
     Expression *left_, *right_;
 
-    ETYPE HandleType(llvm::Type* lt, llvm::Type* rt);
+    llvm::Value* GenerateOperand(Expression* operand, WasmFunction* fct, llvm::IRBuilder<>& builder);
     llvm::Value* HandleInteger(llvm::Value* lv, llvm::Value* rv, llvm::IRBuilder<>& builder);
     llvm::Value* HandleShift(WasmFunction* fct, llvm::IRBuilder<>& builder, bool sign, bool right);
     llvm::Value* HandleDivRem(WasmFunction* fct, llvm::IRBuilder<>& builder, bool sign, bool div);
     llvm::Value* HandleIntrinsic(WasmFunction* fct, llvm::IRBuilder<>& builder);
 
   public:
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_BINOP;
+    }
+
     Binop(Operation* op, Expression* l, Expression* r) :
-      operation_(op), left_(l), right_(r) {
+      Expression(EXPR_BINOP), operation_(op), left_(l), right_(r) {
     }
 
+    virtual void ResolveNames(NameResolver& resolver);
+
+    virtual void Serialize(AstWriter& writer) const;
+
     virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 
+    Operation* GetOperation() const {
+      return operation_;
+    }
+
     Expression* GetRight() const {
       return right_;
     }
@@ -62,6 +74,20 @@ class Binop : public Expression {
     }
 
     virtual void Dump(int tabs = 0) const;
+
+    virtual bool ForEachChild(ChildFunction fct, void* data) const {
+      return CallOnChild(left_, fct, data) &&
+             CallOnChild(right_, fct, data);
+    }
+
+    virtual void ReplaceChild(Expression* old_child, Expression* new_child) {
+      if (left_ == old_child) {
+        left_ = new_child;
+      } else {
+        assert(right_ == old_child);
+        right_ = new_child;
+      }
+    }
 };
 
 #endif
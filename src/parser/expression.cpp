@@ -15,6 +15,7 @@
 */
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/IR/CFG.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
@@ -24,41 +25,45 @@
 #include "function.h"
 #include "module.h"
 
-llvm::Value* GetLocal::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
-  llvm::AllocaInst* alloca = nullptr;
-  const char* name = nullptr;
+// Nothing branches to bb once all the paths going there jumped away: what follows is dead.
+static bool IsDead(llvm::BasicBlock* bb) {
+  return llvm::pred_begin(bb) == llvm::pred_end(bb);
+}
 
-  if (var_->IsString()) {
-    name = var_->GetString();
-    alloca = fct->GetVariable(name);
-  } else {
-    size_t idx = var_->GetIdx();
-    std::ostringstream oss;
-    oss << "var_idx_" << idx;
-    name = oss.str().c_str();
-    alloca = fct->GetVariable(idx);
-  }
+llvm::Value* Expression::Generate(WasmFunction* fct, llvm::IRBuilder<>& builder) {
+  // What the parent generates after its sub-expressions goes back to its own line.
+  llvm::DebugLoc parent_location = builder.getCurrentDebugLocation();
 
-  assert(alloca != nullptr);
+  // The code generation switches on the annotated types, see TypeAnnotator.
+  assert(typed_ == true);
 
-  llvm::Value* res = builder.CreateLoad(alloca->getAllocatedType(), alloca, "get_local");
-  return res;
+  fct->SetDebugLocation(line_, builder);
+  llvm::Value* value = Codegen(fct, builder);
+
+  builder.SetCurrentDebugLocation(parent_location);
+  return value;
+}
+
+llvm::Value* GetLocal::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
+  return fct->ReadLocal(var_, builder);
 }
 
 llvm::Value* SetLocal::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
   // First generate the value code.
-  llvm::Value* value = value_->Codegen(fct, builder);
+  llvm::Value* value = value_->Generate(fct, builder);
   assert(value != nullptr);
 
-  // Now call the right method to set it.
-  if (var_->IsString()) {
-    const char* name = var_->GetString();
-    builder.CreateStore(value, fct->GetVariable(name));
-  } else {
-    size_t idx = var_->GetIdx();
-    builder.CreateStore(value, fct->GetVariable(idx));
+  // Nothing to set if the value jumped away.
+  llvm::Value* terminator = GetTerminator(builder);
+
+  if (terminator != nullptr) {
+    return terminator;
   }
 
+  // Now set it, as the type of the local.
+  value = ConvertValue(value, value_->GetValueType(), value_type_, false, builder);
+  fct->WriteLocal(var_, value, builder);
+
   // Return the value.
   return value;
 }
@@ -103,6 +108,25 @@ llvm::Value* Const::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
 }
 
 WasmFunction* CallExpression::GetCallee(WasmFunction* fct) const {
+  // An import has no WasmFunction: callers must skip CallImportExpression, which is also a CallExpression.
+  assert(llvm::isa<CallImportExpression>(this) == false);
+
+  // If the name resolution already found it, we are done.
+  if (callee_ != nullptr) {
+    return callee_;
+  }
+
+  WasmFunction* wfct = FindCallee(fct);
+
+  if (wfct == nullptr) {
+    BISON_PRINT("Problem with finding %s\n", call_id_->GetString());
+  }
+  assert(wfct != nullptr);
+
+  return wfct;
+}
+
+WasmFunction* CallExpression::FindCallee(WasmFunction* fct) const {
   WasmModule* module = fct->GetModule();
   WasmFunction* wfct = nullptr;
 
@@ -116,18 +140,20 @@ WasmFunction* CallExpression::GetCallee(WasmFunction* fct) const {
     wfct  = module->GetWasmFunction(idx);
   }
 
-  if (wfct == nullptr) {
-    BISON_PRINT("Problem with finding %s\n", call_id_->GetString());
-  }
-  assert(wfct != nullptr);
-
   return wfct;
 }
 
 llvm::Value* CallExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
   WasmFunction* wfct = GetCallee(fct);
   assert(wfct != nullptr);
+
+  // Another module only sees the C entry point of its exports.
   llvm::Function* callee = wfct->GetFunction();
+
+  if (wfct->GetModule() != fct->GetModule()) {
+    callee = wfct->GetExternalFunction();
+  }
+
   assert(callee != nullptr);
 
   // Now create the arguments for the call creation.
@@ -135,7 +161,14 @@ llvm::Value* CallExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& build
 
   if (params_ != nullptr) {
     for (auto elem : *params_) {
-      args.push_back(elem->Codegen(fct, builder));
+      args.push_back(elem->Generate(fct, builder));
+
+      // The next arguments and the call are dead if this one jumped away.
+      llvm::Value* terminator = GetTerminator(builder);
+
+      if (terminator != nullptr) {
+        return terminator;
+      }
     }
   }
 
@@ -145,10 +178,18 @@ llvm::Value* CallExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& build
     return_name = "calltmp";
   }
 
-  return builder.CreateCall(callee, args, return_name);
+  llvm::CallInst* result = builder.CreateCall(callee, args, return_name);
+  result->setCallingConv(callee->getCallingConv());
+
+  // The callee might have moved the memory.
+  if (wfct->MayGrowMemory() == true) {
+    fct->ReloadBaseMemory(builder);
+  }
+
+  return result;
 }
 
-llvm::Value* CallImportExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
+WasmImportFunction* CallImportExpression::FindImport(WasmFunction* fct) const {
   WasmModule* module = fct->GetModule();
   WasmImportFunction* wif = nullptr;
 
@@ -162,6 +203,19 @@ llvm::Value* CallImportExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>&
     wif  = module->GetWasmImportFunction(idx);
   }
 
+  return wif;
+}
+
+llvm::Value* CallImportExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
+  WasmModule* module = fct->GetModule();
+
+  // Use the resolved import if the name resolution ran.
+  WasmImportFunction* wif = import_;
+
+  if (wif == nullptr) {
+    wif = FindImport(fct);
+  }
+
   assert(wif != nullptr);
 
   llvm::Function* callee = wif->GetFunction(module);
@@ -170,7 +224,14 @@ llvm::Value* CallImportExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>&
   std::vector<Value*> args;
   if (params_ != nullptr) {
     for (auto elem : *params_) {
-      args.push_back(elem->Codegen(fct, builder));
+      args.push_back(elem->Generate(fct, builder));
+
+      // Like for a call inside the module.
+      llvm::Value* terminator = GetTerminator(builder);
+
+      if (terminator != nullptr) {
+        return terminator;
+      }
     }
   }
 
@@ -179,30 +240,38 @@ llvm::Value* CallImportExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>&
     return_name = "calltmp";
   }
 
-  return builder.CreateCall(callee, args, return_name);
+  llvm::Value* result = builder.CreateCall(callee, args, return_name);
+
+  // Imports can call back into a function growing the memory.
+  fct->ReloadBaseMemory(builder);
+
+  return result;
 }
 
 llvm::Value* ConditionalExpression::TransformCondition(llvm::Value* value, llvm::IRBuilder<>& builder) {
-  llvm::Type* type = value->getType();
-
-  if (type->isIntegerTy(1) == false) {
-    if (type->isFloatingPointTy()) {
-      llvm::Value* zero = llvm::ConstantFP::get(llvm::getGlobalContext(), APFloat(0.0));;
-      // Not sure ordered is what we want but let us assume for now.
-      return builder.CreateFCmpONE(value, zero, "cmp_zero");
-    } else {
-      llvm::Value* zero = llvm::ConstantInt::get(llvm::getGlobalContext(), APInt(type->getIntegerBitWidth(), 0, false));
-      return builder.CreateICmpNE(value, zero, "cmp_zero");
-    }
+  return ::TransformCondition(value, cond_->GetValueType(), builder);
+}
+
+llvm::Value* IfExpression::ConvertResult(llvm::Value* result, Expression* side, llvm::IRBuilder<>& builder) const {
+  // The annotation says what both sides merge to: a comparison on one side is widened.
+  if (value_type_ == VOID || false_cond_ == nullptr) {
+    return result;
   }
 
-  // Nothing to be done.
-  return value;
+  return ConvertValue(result, side->GetValueType(), value_type_, false, builder);
 }
 
 llvm::Value* IfExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
   // Start by generating the condition.
-  llvm::Value* cond_value = cond_->Codegen(fct, builder);
+  llvm::Value* cond_value = cond_->Generate(fct, builder);
+
+  // Neither side runs if the condition jumped away.
+  llvm::Value* terminator = GetTerminator(builder);
+
+  if (terminator != nullptr) {
+    return terminator;
+  }
+
   cond_value = TransformCondition(cond_value, builder);
 
   llvm::Function* llvm_fct = fct->GetFunction();
@@ -226,10 +295,12 @@ llvm::Value* IfExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder
 
   // Start generating the true side.
   builder.SetInsertPoint(true_bb);
-  llvm::Value* true_result = true_cond_->Codegen(fct, builder);
+  llvm::Value* true_result = true_cond_->Generate(fct, builder);
 
   // If we do not finish with a terminator, generate a jump.
-  if (dynamic_cast<TerminatorInst*>(true_result) == nullptr) {
+  if (llvm::dyn_cast_or_null<TerminatorInst>(true_result) == nullptr) {
+    true_result = ConvertResult(true_result, true_cond_, builder);
+
     // Branch now to the end_bb.
     builder.CreateBr(end_bb);
   }
@@ -245,11 +316,14 @@ llvm::Value* IfExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder
   // We might not have one.
   llvm::Value* false_result = nullptr;
   if (false_cond_ != nullptr) {
-    false_result = false_cond_->Codegen(fct, builder);
+    false_result = false_cond_->Generate(fct, builder);
   }
 
-  // Branch now to the end_bb.
-  builder.CreateBr(end_bb);
+  // Branch now to the end_bb, unless the false side already left.
+  if (llvm::dyn_cast_or_null<TerminatorInst>(false_result) == nullptr) {
+    false_result = ConvertResult(false_result, false_cond_, builder);
+    builder.CreateBr(end_bb);
+  }
 
   // Come back to the false_bb.
   false_bb = builder.GetInsertBlock();
@@ -259,20 +333,21 @@ llvm::Value* IfExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder
   llvm_fct->getBasicBlockList().push_back(end_bb);
   builder.SetInsertPoint(end_bb);
 
+  // Both sides jumped away.
+  if (IsDead(end_bb) == true) {
+    return builder.CreateUnreachable();
+  }
+
   // Result is the true_result except if there is an else.
   Value* result = true_result;
 
-  if (true_result == nullptr || (dynamic_cast<TerminatorInst*>(true_result) != nullptr)) {
+  if (true_result == nullptr || llvm::isa<TerminatorInst>(true_result)) {
     result = false_result;
   } else {
-    if (should_merge_ == true && false_result != nullptr) {
+    if (should_merge_ == true && value_type_ != VOID && false_result != nullptr && llvm::isa<TerminatorInst>(false_result) == false) {
       // Now add a phi node for both sides. And that will be the result.
-
-      // But first what type?
-      llvm::Type* merge_type = true_result->getType();
-
-      // TODO: this is not enough even... but it should bring me back here fast...
-      assert(merge_type == false_result->getType());
+      //   Both sides were converted to the annotated type.
+      llvm::Type* merge_type = ConvertType(value_type_);
 
       PHINode* merge_phi = builder.CreatePHI(merge_type, 2, "iftmp");
 
@@ -297,27 +372,34 @@ llvm::Value* LabelExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& buil
   // For now, just ignore it for code generation.
   llvm::BasicBlock* end_label = BasicBlock::Create(llvm::getGlobalContext(), name);
 
-  fct->PushLabel(name, end_label);
+  fct->PushLabel(end_label);
   fct->RegisterNamedExpression(end_label, this);
 
   // Generate the code now.
-  llvm::Value* res = expr_->Codegen(fct, builder);
+  llvm::Value* res = expr_->Generate(fct, builder);
 
   if (res != nullptr) {
-    AddIncomingPhi(res, builder.GetInsertBlock());
+    AddIncomingPhi(res, expr_->GetValueType(), builder.GetInsertBlock());
   }
 
   // Now add the block and set it as insert point.
   llvm::Function* llvm_fct = fct->GetFunction();
   llvm_fct->getBasicBlockList().push_back(end_label);
 
-  // Now jump to the end_label.
-  builder.CreateBr(end_label);
+  // Now jump to the end_label, unless the expression already left.
+  if (llvm::dyn_cast_or_null<TerminatorInst>(res) == nullptr) {
+    builder.CreateBr(end_label);
+  }
 
   // Now set ourselves to the end of the label.
   builder.SetInsertPoint(end_label);
 
-  res = HandlePhiNodes(builder);
+  if (IsDead(end_label) == true) {
+    fct->PopLabel();
+    return builder.CreateUnreachable();
+  }
+
+  res = HandlePhiNodes(value_type_, builder);
 
   // Finally pop the label.
   fct->PopLabel();
@@ -334,75 +416,121 @@ llvm::Value* LoopExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& build
   llvm::BasicBlock* exit_block = BasicBlock::Create(llvm::getGlobalContext(), exit_name, fct->GetFunction());
 
   // Push it.
-  fct->PushLabel(exit_name, exit_block);
-  fct->PushLabel(name, loop);
+  fct->PushLabel(exit_block);
+  fct->PushLabel(loop);
 
   // Also register for the function level that this loop is this exit block.
   fct->RegisterNamedExpression(exit_block, this);
 
   // Jump to the loop.
+  llvm::BasicBlock* preheader = builder.GetInsertBlock();
   builder.CreateBr(loop);
 
   // Now we are in the loop.
   builder.SetInsertPoint(loop);
 
   llvm::Value* value = nullptr;
+  ETYPE value_type = VOID;
   for(std::list<Expression*>::iterator it = loop_->begin();
       it != loop_->end();
       it++) {
     Expression* expr = *it;
-    value = expr->Codegen(fct, builder);
+    value = expr->Generate(fct, builder);
+    value_type = expr->GetValueType();
+
+    // Like in a block, the rest would be generated after a terminator.
+    if (GetTerminator(builder) != nullptr) {
+      break;
+    }
   }
 
-  // If last node from the loop is not nullptr, register it.
-  if (value != nullptr) {
-    // If the last value is not a terminator.
-    if (dynamic_cast<TerminatorInst*>(value) == nullptr) {
-      builder.CreateBr(exit_block);
-      AddIncomingPhi(value, builder.GetInsertBlock());
+  // Falling off the end of the body goes to the exit, with the last value if any.
+  if (GetTerminator(builder) == nullptr) {
+    if (value != nullptr) {
+      AddIncomingPhi(value, value_type, builder.GetInsertBlock());
+    }
+
+    builder.CreateBr(exit_block);
+  }
+
+  // The branches back to the loop carry its hints: the vectorizer looks at the latch.
+  llvm::MDNode* loop_id = fct->CreateLoopMetadata();
+
+  if (loop_id != nullptr) {
+    for (auto it = llvm::pred_begin(loop); it != llvm::pred_end(loop); it++) {
+      llvm::BasicBlock* pred = *it;
+
+      if (pred != preheader) {
+        pred->getTerminator()->setMetadata(llvm::LLVMContext::MD_loop, loop_id);
+      }
     }
   }
 
   // Create a new block, it will be dead code but it will let LLVM land on its feet.
   builder.SetInsertPoint(exit_block);
 
-  value = HandlePhiNodes(builder);
-
   // Pop the labels.
   fct->PopLabel();
   fct->PopLabel();
 
+  // Nobody breaks out of the loop.
+  if (IsDead(exit_block) == true) {
+    return builder.CreateUnreachable();
+  }
+
+  value = HandlePhiNodes(value_type_, builder);
+
   // All is good :).
   return value;
 }
 
-void NamedExpression::AddIncomingPhi(llvm::Value* value, llvm::BasicBlock* bb) {
+void NamedExpression::AddIncomingPhi(llvm::Value* value, ETYPE type, llvm::BasicBlock* bb) {
   assert(value != nullptr);
-  if (dynamic_cast<TerminatorInst*>(value) == nullptr) {
-    incoming_phis_.push_back(std::make_pair(value, bb));
+  if (llvm::dyn_cast_or_null<TerminatorInst>(value) == nullptr) {
+    incoming_phis_.push_back(IncomingPhi(value, type, bb));
   }
 }
 
-llvm::Value* NamedExpression::HandlePhiNodes(llvm::IRBuilder<>& builder) const {
+llvm::Value* NamedExpression::ConvertIncoming(const IncomingPhi& incoming, ETYPE type) const {
+  // The incoming block is normally terminated already: convert right before its branch.
+  llvm::IRBuilder<> convert_builder(incoming.bb_);
+  llvm::Instruction* terminator = incoming.bb_->getTerminator();
+
+  if (terminator != nullptr) {
+    convert_builder.SetInsertPoint(terminator);
+  }
+
+  return ConvertValue(incoming.value_, incoming.type_, type, false, convert_builder);
+}
+
+llvm::Value* NamedExpression::HandlePhiNodes(ETYPE type, llvm::IRBuilder<>& builder) const {
+  // No value merges here.
+  if (type == VOID) {
+    return nullptr;
+  }
+
   llvm::Value* value = nullptr;
 
   // Now handle the phi nodes if we have any.
   size_t size = incoming_phis_.size();
   if (size > 1) {
-    // Let us assume the merge type is fine for all elements.
-    llvm::Type* merge_type = incoming_phis_[0].first->getType();
+    std::vector<llvm::Value*> values;
+
+    for (auto& incoming : incoming_phis_) {
+      values.push_back(ConvertIncoming(incoming, type));
+    }
 
-    PHINode* merge_phi = builder.CreatePHI(merge_type, size, "merge_phi");
+    PHINode* merge_phi = builder.CreatePHI(ConvertType(type), size, "merge_phi");
 
-    for (auto p : incoming_phis_) {
-      merge_phi->addIncoming(p.first, p.second);
+    for (size_t i = 0; i < size; i++) {
+      merge_phi->addIncoming(values[i], incoming_phis_[i].bb_);
     }
 
     value = merge_phi;
   } else {
     // If only one element, just return it.
     if (size == 1) {
-      return incoming_phis_[0].first;
+      return ConvertIncoming(incoming_phis_[0], type);
     }
   }
 
@@ -423,20 +551,21 @@ llvm::Value* BlockExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& buil
   builder.SetInsertPoint(block_code);
 
   // Push it.
-  fct->PushLabel(name, exit_block_code);
+  fct->PushLabel(exit_block_code);
 
   // Also register for the function level that this loop is this exit block.
   fct->RegisterNamedExpression(exit_block_code, this);
 
   // For now, there is no reason to really care about block.
   bool finished_with_termination = false;
+  ETYPE res_type = VOID;
   for (std::list<Expression*>::const_iterator it = list_->begin(); it != list_->end(); it++) {
     Expression* expr = *it;
-    res = expr->Codegen(fct, builder);
+    res = expr->Generate(fct, builder);
+    res_type = expr->GetValueType();
 
-    // Stop if we are jumping or returning.
-    if ((dynamic_cast<ReturnExpression*>(expr) != nullptr) ||
-        (dynamic_cast<BreakExpression*>(expr) != nullptr)) {
+    // Stop if we are jumping, returning, or trapping, maybe from an operand.
+    if (GetTerminator(builder) != nullptr) {
       finished_with_termination = true;
       break;
     }
@@ -444,52 +573,59 @@ llvm::Value* BlockExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& buil
 
   // If last node from the block is not nullptr, register it.
   if (res != nullptr) {
-    AddIncomingPhi(res, builder.GetInsertBlock());
+    AddIncomingPhi(res, res_type, builder.GetInsertBlock());
   }
 
   // Pop it.
   fct->PopLabel();
 
+  // Otherwise the exit block is only reached by the breaks: the dead-code pass
+  //   removes the blocks nobody breaks to.
   if (finished_with_termination == false) {
     builder.CreateBr(exit_block_code);
-  } else {
-    // In the case we did finish with termination, we generated the exit block but there is a possibility it is not used.
-    //  However it must finish with a terminator outside and we don't know if we are going towards it.
-
-    // So let's find out if someone is going there.
-    // TODO.
   }
 
   builder.SetInsertPoint(exit_block_code);
 
-  res = HandlePhiNodes(builder);
+  // Nobody breaks to the block and its end is never reached.
+  if (IsDead(exit_block_code) == true) {
+    return builder.CreateUnreachable();
+  }
+
+  res = HandlePhiNodes(value_type_, builder);
 
   return res;
 }
 
 llvm::Value* BreakIfExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
-  llvm::BasicBlock* bb = nullptr;
-
-  if (var_->IsString() == false) {
-    size_t idx = var_->GetIdx();
-    bb = fct->GetLabel(idx);
-  } else {
-    const char* name = var_->GetString();
-    bb = fct->GetLabel(name);
-  }
-
+  // The name resolution ran: a name left would have made the function invalid.
+  assert(var_->IsString() == false);
+  llvm::BasicBlock* bb = fct->GetLabel(var_->GetIdx());
   assert(bb != nullptr);
 
   // First generate the expr if there.
   llvm::Value* result = nullptr;
   if (expr_ != nullptr) {
-    result = expr_->Codegen(fct, builder);
+    result = expr_->Generate(fct, builder);
+  }
+
+  // There is no branch left to generate if the value jumped away.
+  llvm::Value* terminator = GetTerminator(builder);
+
+  if (terminator != nullptr) {
+    return terminator;
   }
 
   // Second generate the cond if there.
   llvm::Value* cond = nullptr;
   if (cond_ != nullptr) {
-    cond = cond_->Codegen(fct, builder);
+    cond = cond_->Generate(fct, builder);
+    terminator = GetTerminator(builder);
+
+    if (terminator != nullptr) {
+      return terminator;
+    }
+
     cond = TransformCondition(cond, builder);
   }
 
@@ -517,7 +653,7 @@ llvm::Value* BreakIfExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& bu
 
     // If we did not find it, we will not push the information there, it is not going to a merge point...
     if (named != nullptr) {
-      named->AddIncomingPhi(result, true_bb);
+      named->AddIncomingPhi(result, expr_->GetValueType(), true_bb);
     }
   }
 
@@ -534,20 +670,20 @@ llvm::Value* BreakIfExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& bu
 }
 
 llvm::Value* BreakExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
-  llvm::BasicBlock* bb = nullptr;
-
-  if (var_->IsString() == false) {
-    size_t idx = var_->GetIdx();
-    bb = fct->GetLabel(idx);
-  } else {
-    const char* name = var_->GetString();
-    bb = fct->GetLabel(name);
-  }
-
+  // The name resolution ran: a name left would have made the function invalid.
+  assert(var_->IsString() == false);
+  llvm::BasicBlock* bb = fct->GetLabel(var_->GetIdx());
   assert(bb != nullptr);
 
   if (expr_ != nullptr) {
-    llvm::Value* result = expr_->Codegen(fct, builder);
+    llvm::Value* result = expr_->Generate(fct, builder);
+
+    // The value already jumped away.
+    llvm::Value* terminator = GetTerminator(builder);
+
+    if (terminator != nullptr) {
+      return terminator;
+    }
 
     if (result != nullptr) {
       // We should push this to the named expression so that it knows about it.
@@ -555,7 +691,7 @@ llvm::Value* BreakExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& buil
 
       // If we did not find it, we will not push the information there, it is not going to a merge point...
       if (named != nullptr) {
-        named->AddIncomingPhi(result, builder.GetInsertBlock());
+        named->AddIncomingPhi(result, expr_->GetValueType(), builder.GetInsertBlock());
       }
     }
   }
@@ -566,9 +702,17 @@ llvm::Value* BreakExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& buil
 
 llvm::Value* ReturnExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
   // Generate the code for the return, then call the handler.
-  llvm::Value* result = result_->Codegen(fct, builder);
+  llvm::Value* result = result_->Generate(fct, builder);
   assert(result != nullptr);
-  return fct->HandleReturn(result, builder);
+
+  // The result already jumped away.
+  llvm::Value* terminator = GetTerminator(builder);
+
+  if (terminator != nullptr) {
+    return terminator;
+  }
+
+  return fct->HandleReturn(result, result_->GetValueType(), builder);
 }
 
 llvm::Value* Unreachable::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
@@ -576,33 +720,40 @@ llvm::Value* Unreachable::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder)
   WasmModule* wasm_module = fct->GetModule();
   llvm::Function* intrinsic_fct = wasm_module->GetOrCreateIntrinsic(intrinsic);
   std::vector<Value*> no_arg;
-  return builder.CreateCall(intrinsic_fct, no_arg);
+  builder.CreateCall(intrinsic_fct, no_arg);
+
+  // Nothing comes back from the trap: like a break or a return, this ends the block.
+  return builder.CreateUnreachable();
 }
 
 llvm::Value* SelectExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
-  // First generate the condition, first, and second.
-  llvm::Value* cond = cond_->Codegen(fct, builder);
+  // First generate the condition, first, and second: all of them run, unless one jumps away.
+  llvm::Value* cond = cond_->Generate(fct, builder);
+  llvm::Value* terminator = GetTerminator(builder);
 
-  // We need to handle the unreachable case here because the LLVM builder
-  //   won't like us passing a trap call...
-  // This is not perfect and might need more work later down the road.
-  if (dynamic_cast<Unreachable*>(cond_) != nullptr) {
-    return cond;
+  if (terminator != nullptr) {
+    return terminator;
   }
 
-  llvm::Value* first = first_->Codegen(fct, builder);
+  llvm::Value* first = first_->Generate(fct, builder);
+  terminator = GetTerminator(builder);
 
-  if (dynamic_cast<Unreachable*>(first_) != nullptr) {
-    return first;
+  if (terminator != nullptr) {
+    return terminator;
   }
 
-  llvm::Value* second = second_->Codegen(fct, builder);
+  llvm::Value* second = second_->Generate(fct, builder);
+  terminator = GetTerminator(builder);
 
-  if (dynamic_cast<Unreachable*>(second_) != nullptr) {
-    return second;
+  if (terminator != nullptr) {
+    return terminator;
   }
 
-  cond = TransformCondition(cond, builder);
+  cond = TransformCondition(cond, cond_->GetValueType(), builder);
+
+  // A comparison is widened to the other operand's integer.
+  first = ConvertValue(first, first_->GetValueType(), value_type_, false, builder);
+  second = ConvertValue(second, second_->GetValueType(), value_type_, false, builder);
 
   return builder.CreateSelect(cond, first, second, "select");
 }
@@ -27,9 +27,19 @@
 // Forward declaration.
 class SwitchExpression;
 class WasmFunction;
+class WasmImportFunction;
 
 class Nop : public Expression {
   public:
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_NOP;
+    }
+
+    Nop() : Expression(EXPR_NOP) {
+    }
+
+    virtual void Serialize(AstWriter& writer) const;
+
     virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
       (void) fct;
       (void) builder;
@@ -43,16 +53,36 @@ class Unop : public Expression {
     Operation* operation_;
     Expression* only_;
 
+    llvm::Value* GenerateOperand(WasmFunction* fct, llvm::IRBuilder<>& builder);
+
   public:
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_UNOP;
+    }
+
     Unop(Operation* op, Expression* only) :
-      operation_(op), only_(only) {
+      Expression(EXPR_UNOP), operation_(op), only_(only) {
+    }
+
+    Operation* GetOperation() const {
+      return operation_;
     }
 
+    Expression* GetOnly() const {
+      return only_;
+    }
+
+    virtual void ResolveNames(NameResolver& resolver);
+
+    virtual void Serialize(AstWriter& writer) const;
+
     virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 
     virtual void Dump(int tabs = 0) const;
 
-    virtual bool Walk(bool (*fct)(Expression*, void*), void* data);
+    virtual bool ForEachChild(ChildFunction fct, void* data) const;
+
+    virtual void ReplaceChild(Expression* old_child, Expression* new_child);
 };
 
 
@@ -61,7 +91,15 @@ class GetLocal : public Expression {
     Variable* var_;
 
   public:
-    GetLocal(Variable* v = nullptr) : var_(v) {
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_GET_LOCAL;
+    }
+
+    GetLocal(Variable* v = nullptr) : Expression(EXPR_GET_LOCAL), var_(v) {
+    }
+
+    Variable* GetVariable() const {
+      return var_;
     }
 
     virtual void Dump(int tabs = 0) const {
@@ -72,6 +110,10 @@ class GetLocal : public Expression {
       }
     }
 
+    virtual void ResolveNames(NameResolver& resolver);
+
+    virtual void Serialize(AstWriter& writer) const;
+
     virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 };
 
@@ -81,7 +123,19 @@ class SetLocal : public Expression {
     Expression* value_;
 
   public:
-    SetLocal(Variable* v, Expression* val) : var_(v), value_(val) {
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_SET_LOCAL;
+    }
+
+    SetLocal(Variable* v, Expression* val) : Expression(EXPR_SET_LOCAL), var_(v), value_(val) {
+    }
+
+    Variable* GetVariable() const {
+      return var_;
+    }
+
+    Expression* GetValue() const {
+      return value_;
     }
 
     virtual void Dump(int tabs = 0) const {
@@ -94,19 +148,19 @@ class SetLocal : public Expression {
       }
     }
 
-    virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
+    virtual void ResolveNames(NameResolver& resolver);
 
-    virtual bool Walk(bool (*fct)(Expression*, void*), void* data) {
-      assert(fct != nullptr);
-      if (fct(this, data) == false) {
-        return false;
-      }
+    virtual void Serialize(AstWriter& writer) const;
 
-      if (value_ != nullptr) {
-        return value_->Walk(fct, data);
-      }
+    virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 
-      return true;
+    virtual bool ForEachChild(ChildFunction fct, void* data) const {
+      return CallOnChild(value_, fct, data);
+    }
+
+    virtual void ReplaceChild(Expression* old_child, Expression* new_child) {
+      assert(value_ == old_child);
+      value_ = new_child;
     }
 };
 
@@ -117,7 +171,11 @@ class ConditionalExpression : public Expression {
     llvm::Value* TransformCondition(llvm::Value* value, llvm::IRBuilder<>& builder);
 
   public:
-    ConditionalExpression(Expression* cond) : cond_(cond) {
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() >= EXPR_IF && expr->GetKind() <= EXPR_BREAK_IF;
+    }
+
+    ConditionalExpression(ExpressionKind kind, Expression* cond) : Expression(kind), cond_(cond) {
     }
 
     Expression* GetCondition() const {
@@ -138,9 +196,15 @@ class IfExpression : public ConditionalExpression {
     std::string true_block_name_;
     std::string false_block_name_;
 
+    llvm::Value* ConvertResult(llvm::Value* result, Expression* side, llvm::IRBuilder<>& builder) const;
+
   public:
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_IF;
+    }
+
     IfExpression(Expression* c, Expression* t, Expression* f = nullptr) :
-      ConditionalExpression(c), true_cond_(t), false_cond_(f), should_merge_(true) {
+      ConditionalExpression(EXPR_IF, c), true_cond_(t), false_cond_(f), should_merge_(true) {
         end_block_name_ = "end_block";
         true_block_name_ = "true_block";
         false_block_name_ = "false_block";
@@ -164,6 +228,10 @@ class IfExpression : public ConditionalExpression {
       should_merge_ = b;
     }
 
+    bool ShouldMerge() const {
+      return should_merge_;
+    }
+
     virtual void Dump(int tabs = 0) const {
       if (cond_ && true_cond_) {
         BISON_TABBED_PRINT(tabs, "(If ");
@@ -188,33 +256,27 @@ class IfExpression : public ConditionalExpression {
       return false_cond_;
     }
 
-    virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
+    virtual void ResolveNames(NameResolver& resolver);
 
-    virtual bool Walk(bool (*fct)(Expression*, void*), void* data) {
-      assert(fct != nullptr);
-      if (fct(this, data) == false) {
-        return false;
-      }
+    virtual void Serialize(AstWriter& writer) const;
 
-      if (cond_ != nullptr) {
-        if (cond_->Walk(fct, data) == false) {
-          return false;
-        }
-      }
+    virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 
-      if (true_cond_ != nullptr) {
-        if (true_cond_->Walk(fct, data) == false) {
-          return false;
-        }
-      }
+    virtual bool ForEachChild(ChildFunction fct, void* data) const {
+      return CallOnChild(cond_, fct, data) &&
+             CallOnChild(true_cond_, fct, data) &&
+             CallOnChild(false_cond_, fct, data);
+    }
 
-      if (false_cond_ != nullptr) {
-        if (false_cond_->Walk(fct, data) == false) {
-          return false;
-        }
+    virtual void ReplaceChild(Expression* old_child, Expression* new_child) {
+      if (cond_ == old_child) {
+        cond_ = new_child;
+      } else if (true_cond_ == old_child) {
+        true_cond_ = new_child;
+      } else {
+        assert(false_cond_ == old_child);
+        false_cond_ = new_child;
       }
-
-      return true;
     }
 };
 
@@ -224,7 +286,11 @@ class Const: public Expression {
     ValueHolder* value_;
 
   public:
-    Const(ETYPE t, ValueHolder* v) : type_(t), value_(v) {
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_CONST;
+    }
+
+    Const(ETYPE t, ValueHolder* v) : Expression(EXPR_CONST), type_(t), value_(v) {
       switch (t) {
         case FLOAT_32:
           v->Convert(VH_FLOAT);
@@ -247,6 +313,16 @@ class Const: public Expression {
       }
     }
 
+    ETYPE GetType() const {
+      return type_;
+    }
+
+    const ValueHolder* GetValue() const {
+      return value_;
+    }
+
+    virtual void Serialize(AstWriter& writer) const;
+
     llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 };
 
@@ -254,29 +330,30 @@ class CallExpression : public Expression {
   protected:
     Variable* call_id_;
     std::list<Expression*>* params_;
-    int line_;
+
+    // Filled by the name resolution, avoids looking up the callee at each code generation.
+    WasmFunction* callee_;
+
+    WasmFunction* FindCallee(WasmFunction* fct) const;
+    void ResolveParams(NameResolver& resolver);
 
   public:
-    CallExpression(Variable* id, std::list<Expression*> *params) :
-      call_id_(id), params_(params), line_(0) {
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() >= EXPR_CALL && expr->GetKind() <= EXPR_CALL_IMPORT;
+    }
+
+    CallExpression(Variable* id, std::list<Expression*> *params, ExpressionKind kind = EXPR_CALL) :
+      Expression(kind), call_id_(id), params_(params), callee_(nullptr) {
     }
 
     CallExpression(Variable* id, Expression* p) :
-      call_id_(id), line_(0) {
+      Expression(EXPR_CALL), call_id_(id), callee_(nullptr) {
         params_ = new std::list<Expression*>();
         params_->push_back(p);
     }
 
     CallExpression(Variable* id) :
-      call_id_(id), params_(nullptr), line_(0) {
-    }
-
-    void SetLine(int line) {
-      line_ = line;
-    }
-
-    int GetLine() const {
-      return line_;
+      Expression(EXPR_CALL), call_id_(id), params_(nullptr), callee_(nullptr) {
     }
 
     Variable* GetVariable() const {
@@ -285,6 +362,11 @@ class CallExpression : public Expression {
 
     WasmFunction* GetCallee(WasmFunction* fct) const;
 
+    // For passes copying a resolved call: the copy calls the same function.
+    virtual void CopyResolution(const CallExpression* other) {
+      callee_ = other->callee_;
+    }
+
     virtual void Dump(int tabs = 0) const {
       BISON_TABBED_PRINT(tabs, "(Call ");
       if (call_id_) {
@@ -303,30 +385,50 @@ class CallExpression : public Expression {
       BISON_PRINT(")");
     }
 
-    virtual bool Walk(bool (*fct)(Expression*, void*), void* data) {
-      assert(fct != nullptr);
-      if (fct(this, data) == false) {
-        return false;
-      }
-
-      for (auto elem : *params_) {
-        if (elem->Walk(fct, data) == false) {
-          return false;
-        }
-      }
+    virtual bool ForEachChild(ChildFunction fct, void* data) const {
+      return CallOnChildren(params_, fct, data);
+    }
 
-      return true;
+    virtual void ReplaceChild(Expression* old_child, Expression* new_child) {
+      ReplaceInList(params_, old_child, new_child);
     }
 
+    virtual void ResolveNames(NameResolver& resolver);
+
+    virtual void Serialize(AstWriter& writer) const;
+
     virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 };
 
 class CallImportExpression : public CallExpression {
+  protected:
+    // Filled by the name resolution.
+    WasmImportFunction* import_;
+
+    WasmImportFunction* FindImport(WasmFunction* fct) const;
+
   public:
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_CALL_IMPORT;
+    }
+
     CallImportExpression(Variable* id, std::list<Expression*> *params) :
-      CallExpression(id, params) {
+      CallExpression(id, params, EXPR_CALL_IMPORT), import_(nullptr) {
+    }
+
+    WasmImportFunction* GetImport(WasmFunction* fct) const {
+      return import_ != nullptr ? import_ : FindImport(fct);
     }
 
+    virtual void CopyResolution(const CallExpression* other) {
+      CallExpression::CopyResolution(other);
+      import_ = llvm::cast<CallImportExpression>(other)->import_;
+    }
+
+    virtual void ResolveNames(NameResolver& resolver);
+
+    virtual void Serialize(AstWriter& writer) const;
+
     virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 };
 
@@ -335,7 +437,11 @@ class ReturnExpression : public Expression {
     Expression* result_;
 
   public:
-    ReturnExpression(Expression* expr) : result_(expr) {
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_RETURN;
+    }
+
+    ReturnExpression(Expression* expr) : Expression(EXPR_RETURN), result_(expr) {
     }
 
     virtual void Dump(int tabs = 0) const {
@@ -351,21 +457,18 @@ class ReturnExpression : public Expression {
       return result_;
     }
 
-    virtual bool Walk(bool (*fct)(Expression*, void*), void* data) {
-      assert(fct != nullptr);
+    virtual bool ForEachChild(ChildFunction fct, void* data) const {
+      return CallOnChild(result_, fct, data);
+    }
 
-      if (fct(this, data) == false) {
-        return false;
-      }
+    virtual void ReplaceChild(Expression* old_child, Expression* new_child) {
+      assert(result_ == old_child);
+      result_ = new_child;
+    }
 
-      if (result_ != nullptr) {
-        if (result_->Walk(fct, data) == false) {
-          return false;
-        }
-      }
+    virtual void ResolveNames(NameResolver& resolver);
 
-      return true;
-    }
+    virtual void Serialize(AstWriter& writer) const;
 
     llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 };
@@ -373,12 +476,40 @@ class ReturnExpression : public Expression {
 // Base class for Loops and Blocks to register incoming phi nodes.
 class NamedExpression {
   protected:
-    std::vector<std::pair<llvm::Value*, llvm::BasicBlock*> > incoming_phis_;
+    // A value coming to the merge point, with its annotated type.
+    struct IncomingPhi {
+      llvm::Value* value_;
+      ETYPE type_;
+      llvm::BasicBlock* bb_;
+
+      IncomingPhi(llvm::Value* value, ETYPE type, llvm::BasicBlock* bb) : value_(value), type_(type), bb_(bb) {
+      }
+    };
+
+    std::vector<IncomingPhi> incoming_phis_;
+
+    // If not VOID, the annotated type of the expression: the incoming values are converted to it,
+    //   like a function does for its returns.
+    ETYPE merge_type_;
+
+    llvm::Value* ConvertIncoming(const IncomingPhi& incoming, ETYPE type) const;
 
   public:
-    void AddIncomingPhi(llvm::Value* value, llvm::BasicBlock* bb);
+    NamedExpression() : merge_type_(VOID) {
+    }
 
-    llvm::Value* HandlePhiNodes(llvm::IRBuilder<>& builder) const;
+    void SetMergeType(ETYPE type) {
+      merge_type_ = type;
+    }
+
+    ETYPE GetMergeType() const {
+      return merge_type_;
+    }
+
+    void AddIncomingPhi(llvm::Value* value, ETYPE type, llvm::BasicBlock* bb);
+
+    // The incoming values are converted to type, the merged expression's annotated type.
+    llvm::Value* HandlePhiNodes(ETYPE type, llvm::IRBuilder<>& builder) const;
 };
 
 class LoopExpression : public Expression, public NamedExpression {
@@ -388,7 +519,16 @@ class LoopExpression : public Expression, public NamedExpression {
     std::list<Expression*>* loop_;
 
   public:
-    LoopExpression(Variable* var, Variable* exit_name, std::list<Expression*>* list) : var_(var), exit_name_(exit_name), loop_(list) {
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_LOOP;
+    }
+
+    LoopExpression(Variable* var, Variable* exit_name, std::list<Expression*>* list) :
+      Expression(EXPR_LOOP), var_(var), exit_name_(exit_name), loop_(list) {
+    }
+
+    std::list<Expression*>* GetList() const {
+      return loop_;
     }
 
     virtual void Dump(int tabs = 0) const {
@@ -414,24 +554,17 @@ class LoopExpression : public Expression, public NamedExpression {
       return true;
     }
 
-    virtual bool Walk(bool (*fct)(Expression*, void*), void* data) {
-      assert(fct != nullptr);
+    virtual bool ForEachChild(ChildFunction fct, void* data) const {
+      return CallOnChildren(loop_, fct, data);
+    }
 
-      if (fct(this, data) == false) {
-        return false;
-      }
+    virtual void ReplaceChild(Expression* old_child, Expression* new_child) {
+      ReplaceInList(loop_, old_child, new_child);
+    }
 
-      for(std::list<Expression*>::iterator it = loop_->begin();
-          it != loop_->end();
-          it++) {
-        Expression* expr = *it;
-        if (expr->Walk(fct, data) == false) {
-          return false;
-        }
-      }
+    virtual void ResolveNames(NameResolver& resolver);
 
-      return true;
-    }
+    virtual void Serialize(AstWriter& writer) const;
 
     llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 };
@@ -442,7 +575,15 @@ class LabelExpression : public Expression, NamedExpression {
     Expression* expr_;
 
   public:
-    LabelExpression(Variable* v, Expression* e) : var_(v), expr_(e) {
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_LABEL;
+    }
+
+    LabelExpression(Variable* v, Expression* e) : Expression(EXPR_LABEL), var_(v), expr_(e) {
+    }
+
+    Expression* GetExpression() const {
+      return expr_;
     }
 
     virtual void Dump(int tabs = 0) const {
@@ -464,21 +605,18 @@ class LabelExpression : public Expression, NamedExpression {
       return true;
     }
 
-    virtual bool Walk(bool (*fct)(Expression*, void*), void* data) {
-      assert(fct != nullptr);
+    virtual bool ForEachChild(ChildFunction fct, void* data) const {
+      return CallOnChild(expr_, fct, data);
+    }
 
-      if (fct(this, data) == false) {
-        return false;
-      }
+    virtual void ReplaceChild(Expression* old_child, Expression* new_child) {
+      assert(expr_ == old_child);
+      expr_ = new_child;
+    }
 
-      if (expr_ != nullptr) {
-        if (expr_->Walk(fct, data) == false) {
-          return false;
-        }
-      }
+    virtual void ResolveNames(NameResolver& resolver);
 
-      return true;
-    }
+    virtual void Serialize(AstWriter& writer) const;
 
     llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 };
@@ -489,7 +627,19 @@ class BreakExpression : public Expression {
     Expression* expr_;
 
   public:
-    BreakExpression(Variable* v = nullptr, Expression* e = nullptr) : var_(v), expr_(e) {
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_BREAK;
+    }
+
+    BreakExpression(Variable* v = nullptr, Expression* e = nullptr) : Expression(EXPR_BREAK), var_(v), expr_(e) {
+    }
+
+    Variable* GetVariable() const {
+      return var_;
+    }
+
+    Expression* GetExpression() const {
+      return expr_;
     }
 
     virtual void Dump(int tabs = 0) const {
@@ -507,6 +657,19 @@ class BreakExpression : public Expression {
       BISON_PRINT(")");
     }
 
+    virtual bool ForEachChild(ChildFunction fct, void* data) const {
+      return CallOnChild(expr_, fct, data);
+    }
+
+    virtual void ReplaceChild(Expression* old_child, Expression* new_child) {
+      assert(expr_ == old_child);
+      expr_ = new_child;
+    }
+
+    virtual void ResolveNames(NameResolver& resolver);
+
+    virtual void Serialize(AstWriter& writer) const;
+
     llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 };
 
@@ -516,8 +679,20 @@ class BreakIfExpression : public ConditionalExpression {
     Expression* expr_;
 
   public:
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_BREAK_IF;
+    }
+
     BreakIfExpression(Expression* cond, Variable* v, Expression* e) :
-      ConditionalExpression(cond), var_(v), expr_(e) {
+      ConditionalExpression(EXPR_BREAK_IF, cond), var_(v), expr_(e) {
+    }
+
+    Variable* GetVariable() const {
+      return var_;
+    }
+
+    Expression* GetExpression() const {
+      return expr_;
     }
 
     virtual void Dump(int tabs = 0) const {
@@ -540,6 +715,24 @@ class BreakIfExpression : public ConditionalExpression {
       BISON_PRINT(")");
     }
 
+    virtual bool ForEachChild(ChildFunction fct, void* data) const {
+      return CallOnChild(expr_, fct, data) &&
+             CallOnChild(cond_, fct, data);
+    }
+
+    virtual void ReplaceChild(Expression* old_child, Expression* new_child) {
+      if (cond_ == old_child) {
+        cond_ = new_child;
+      } else {
+        assert(expr_ == old_child);
+        expr_ = new_child;
+      }
+    }
+
+    virtual void ResolveNames(NameResolver& resolver);
+
+    virtual void Serialize(AstWriter& writer) const;
+
     llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 };
 
@@ -549,7 +742,15 @@ class BlockExpression : public Expression, public NamedExpression {
     const char* name_;
 
   public:
-    BlockExpression(const char* name, std::list<Expression*>* l) : name_(name), list_(l) {
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_BLOCK;
+    }
+
+    BlockExpression(const char* name, std::list<Expression*>* l) : Expression(EXPR_BLOCK), name_(name), list_(l) {
+    }
+
+    std::list<Expression*>* GetList() const {
+      return list_;
     }
 
     virtual void Dump(int tabs = 0) const {
@@ -570,29 +771,22 @@ class BlockExpression : public Expression, public NamedExpression {
       }
     }
 
-    virtual bool Walk(bool (*fct)(Expression*, void*), void* data) {
-      assert(fct != nullptr);
-
-      if (fct(this, data) == false) {
-        return false;
-      }
-
-      for(std::list<Expression*>::const_iterator iter = list_->begin();
-                                                 iter != list_->end();
-                                                 iter++) {
-        auto elem = *iter;
-        if (elem->Walk(fct, data) == false) {
-          return false;
-        }
-      }
+    virtual bool ForEachChild(ChildFunction fct, void* data) const {
+      return CallOnChildren(list_, fct, data);
+    }
 
-      return false;
+    virtual void ReplaceChild(Expression* old_child, Expression* new_child) {
+      ReplaceInList(list_, old_child, new_child);
     }
 
     virtual bool GoesToTheLine() const {
       return true;
     }
 
+    virtual void ResolveNames(NameResolver& resolver);
+
+    virtual void Serialize(AstWriter& writer) const;
+
     llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 };
 
@@ -601,13 +795,19 @@ class StringExpression : public Expression {
     char* s_;
 
   public:
-    StringExpression(char* s) : s_(s) {
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_STRING;
+    }
+
+    StringExpression(char* s) : Expression(EXPR_STRING), s_(s) {
     }
 
     virtual void Dump(int tabs = 0) const {
       BISON_TABBED_PRINT(tabs, "(String Expression %s)", s_);
     }
 
+    virtual void Serialize(AstWriter& writer) const;
+
     virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
       (void) fct;
 
@@ -620,7 +820,11 @@ class ValueExpression : public Expression {
     llvm::Value* value_;
 
   public:
-    ValueExpression(llvm::Value* value) : value_(value) {
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_VALUE;
+    }
+
+    ValueExpression(llvm::Value* value) : Expression(EXPR_VALUE), value_(value) {
     }
 
     virtual void Dump(int tabs = 0) const {
@@ -637,13 +841,19 @@ class ValueExpression : public Expression {
 
 class Unreachable : public Expression {
   public:
-    Unreachable() {
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_UNREACHABLE;
+    }
+
+    Unreachable() : Expression(EXPR_UNREACHABLE) {
     }
 
     virtual void Dump(int tabs = 0) const {
       BISON_TABBED_PRINT(tabs, "(Unreachable)");
     }
 
+    virtual void Serialize(AstWriter& writer) const;
+
     virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 };
 
@@ -655,10 +865,47 @@ class SelectExpression : public Expression {
     Expression* second_;
 
   public:
-    SelectExpression(ETYPE type, Expression* cond, Expression* first, Expression* second) : 
-      cond_(cond), first_(first), second_(second) {
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_SELECT;
+    }
+
+    SelectExpression(ETYPE type, Expression* cond, Expression* first, Expression* second) :
+      Expression(EXPR_SELECT), type_(type), cond_(cond), first_(first), second_(second) {
+    }
+
+    Expression* GetCondition() const {
+      return cond_;
     }
 
+    Expression* GetFirst() const {
+      return first_;
+    }
+
+    Expression* GetSecond() const {
+      return second_;
+    }
+
+    virtual bool ForEachChild(ChildFunction fct, void* data) const {
+      return CallOnChild(cond_, fct, data) &&
+             CallOnChild(first_, fct, data) &&
+             CallOnChild(second_, fct, data);
+    }
+
+    virtual void ReplaceChild(Expression* old_child, Expression* new_child) {
+      if (cond_ == old_child) {
+        cond_ = new_child;
+      } else if (first_ == old_child) {
+        first_ = new_child;
+      } else {
+        assert(second_ == old_child);
+        second_ = new_child;
+      }
+    }
+
+    virtual void ResolveNames(NameResolver& resolver);
+
+    virtual void Serialize(AstWriter& writer) const;
+
     virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 };
 
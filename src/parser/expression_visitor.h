@@ -0,0 +1,211 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#ifndef H_EXPRESSION_VISITOR
+#define H_EXPRESSION_VISITOR
+
+#include "binop.h"
+#include "expression.h"
+#include "memory.h"
+#include "switch_expression.h"
+
+/**
+ * Visitor over the expression nodes, resolved at compile time: Visit switches on the node's
+ *   kind and calls the derived class' method directly, so there is neither RTTI nor a virtual
+ *   call per node. A derived class only defines the Visit methods it cares about, the others
+ *   fall back to the method of the node's base class, then to VisitExpression.
+ */
+template <typename Derived, typename RetTy = void>
+class ExpressionVisitor {
+  protected:
+    Derived* GetDerived() {
+      return static_cast<Derived*>(this);
+    }
+
+  public:
+    RetTy Visit(Expression* expr) {
+      switch (expr->GetKind()) {
+        case EXPR_NOP:
+          return GetDerived()->VisitNop(static_cast<Nop*>(expr));
+        case EXPR_UNOP:
+          return GetDerived()->VisitUnop(static_cast<Unop*>(expr));
+        case EXPR_BINOP:
+          return GetDerived()->VisitBinop(static_cast<Binop*>(expr));
+        case EXPR_GET_LOCAL:
+          return GetDerived()->VisitGetLocal(static_cast<GetLocal*>(expr));
+        case EXPR_SET_LOCAL:
+          return GetDerived()->VisitSetLocal(static_cast<SetLocal*>(expr));
+        case EXPR_IF:
+          return GetDerived()->VisitIfExpression(static_cast<IfExpression*>(expr));
+        case EXPR_BREAK_IF:
+          return GetDerived()->VisitBreakIfExpression(static_cast<BreakIfExpression*>(expr));
+        case EXPR_CONST:
+          return GetDerived()->VisitConst(static_cast<Const*>(expr));
+        case EXPR_CALL:
+          return GetDerived()->VisitCallExpression(static_cast<CallExpression*>(expr));
+        case EXPR_CALL_IMPORT:
+          return GetDerived()->VisitCallImportExpression(static_cast<CallImportExpression*>(expr));
+        case EXPR_RETURN:
+          return GetDerived()->VisitReturnExpression(static_cast<ReturnExpression*>(expr));
+        case EXPR_LOOP:
+          return GetDerived()->VisitLoopExpression(static_cast<LoopExpression*>(expr));
+        case EXPR_LABEL:
+          return GetDerived()->VisitLabelExpression(static_cast<LabelExpression*>(expr));
+        case EXPR_BREAK:
+          return GetDerived()->VisitBreakExpression(static_cast<BreakExpression*>(expr));
+        case EXPR_BLOCK:
+          return GetDerived()->VisitBlockExpression(static_cast<BlockExpression*>(expr));
+        case EXPR_STRING:
+          return GetDerived()->VisitStringExpression(static_cast<StringExpression*>(expr));
+        case EXPR_VALUE:
+          return GetDerived()->VisitValueExpression(static_cast<ValueExpression*>(expr));
+        case EXPR_UNREACHABLE:
+          return GetDerived()->VisitUnreachable(static_cast<Unreachable*>(expr));
+        case EXPR_SELECT:
+          return GetDerived()->VisitSelectExpression(static_cast<SelectExpression*>(expr));
+        case EXPR_LOAD:
+          return GetDerived()->VisitLoad(static_cast<Load*>(expr));
+        case EXPR_STORE:
+          return GetDerived()->VisitStore(static_cast<Store*>(expr));
+        case EXPR_MEMORY_SIZE:
+          return GetDerived()->VisitMemorySize(static_cast<MemorySize*>(expr));
+        case EXPR_MEMORY_GROW:
+          return GetDerived()->VisitMemoryGrow(static_cast<MemoryGrow*>(expr));
+        case EXPR_CASE:
+          return GetDerived()->VisitCaseExpression(static_cast<CaseExpression*>(expr));
+        case EXPR_SWITCH:
+          return GetDerived()->VisitSwitchExpression(static_cast<SwitchExpression*>(expr));
+        default:
+          return GetDerived()->VisitExpression(expr);
+      }
+    }
+
+    RetTy VisitExpression(Expression* expr) {
+      (void) expr;
+      return RetTy();
+    }
+
+    // The intermediate classes.
+    RetTy VisitConditionalExpression(ConditionalExpression* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitMemoryExpression(MemoryExpression* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    // The nodes.
+    RetTy VisitNop(Nop* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitUnop(Unop* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitBinop(Binop* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitGetLocal(GetLocal* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitSetLocal(SetLocal* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitIfExpression(IfExpression* expr) {
+      return GetDerived()->VisitConditionalExpression(expr);
+    }
+
+    RetTy VisitBreakIfExpression(BreakIfExpression* expr) {
+      return GetDerived()->VisitConditionalExpression(expr);
+    }
+
+    RetTy VisitConst(Const* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitCallExpression(CallExpression* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitCallImportExpression(CallImportExpression* expr) {
+      return GetDerived()->VisitCallExpression(expr);
+    }
+
+    RetTy VisitReturnExpression(ReturnExpression* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitLoopExpression(LoopExpression* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitLabelExpression(LabelExpression* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitBreakExpression(BreakExpression* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitBlockExpression(BlockExpression* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitStringExpression(StringExpression* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitValueExpression(ValueExpression* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitUnreachable(Unreachable* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitSelectExpression(SelectExpression* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitLoad(Load* expr) {
+      return GetDerived()->VisitMemoryExpression(expr);
+    }
+
+    RetTy VisitStore(Store* expr) {
+      return GetDerived()->VisitMemoryExpression(expr);
+    }
+
+    RetTy VisitMemorySize(MemorySize* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitMemoryGrow(MemoryGrow* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitCaseExpression(CaseExpression* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+
+    RetTy VisitSwitchExpression(SwitchExpression* expr) {
+      return GetDerived()->VisitExpression(expr);
+    }
+};
+
+#endif
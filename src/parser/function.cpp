@@ -16,9 +16,12 @@
 #include <string>
 #include <iostream>
 
+#include "ast_cache.h"
 #include "debug.h"
 #include "function.h"
+#include "globals.h"
 #include "module.h"
+#include "parser_context.h"
 
 llvm::Type* WasmFunction::GetReturnType() const {
   return ConvertType(result_);
@@ -53,13 +56,13 @@ void WasmFunction::Populate() {
       FunctionField* ff = *it;
 
       // First check if it is a parameter.
-      ParamField* pf = dynamic_cast<ParamField*>(ff);
+      ParamField* pf = llvm::dyn_cast<ParamField>(ff);
 
       if (pf != nullptr) {
         params_.push_back(pf);
       } else {
         // Second check if it is a result.
-        ResultField* rf = dynamic_cast<ResultField*>(ff);
+        ResultField* rf = llvm::dyn_cast<ResultField>(ff);
 
         if (rf != nullptr) {
           // Current limitation, only one result.
@@ -71,13 +74,13 @@ void WasmFunction::Populate() {
           }
         } else {
           // Third is the expression fields.
-          ExpressionField* ef = dynamic_cast<ExpressionField*>(ff);
+          ExpressionField* ef = llvm::dyn_cast<ExpressionField>(ff);
 
           if (ef != nullptr) {
             ast_.push_back(ef->GetExpression());
           } else {
             // Third is the local fields.
-            LocalField* lf = dynamic_cast<LocalField*>(ff);
+            LocalField* lf = llvm::dyn_cast<LocalField>(ff);
 
             if (lf != nullptr) {
               Local* local = lf->GetLocal();
@@ -85,6 +88,13 @@ void WasmFunction::Populate() {
               // For simplificity, right now just remember them; then we will come back.
               //  We also assume we have only global locals... which seems to be the spec.
               locals_.push_back(local);
+            } else {
+              // Finally, the body might not be parsed yet.
+              LazyBodyField* lbf = llvm::dyn_cast<LazyBodyField>(ff);
+
+              if (lbf != nullptr) {
+                lazy_body_ = lbf;
+              }
             }
           }
         }
@@ -93,6 +103,55 @@ void WasmFunction::Populate() {
   }
 }
 
+void WasmFunction::ParseBody() {
+  if (lazy_body_ == nullptr) {
+    return;
+  }
+
+  std::list<FunctionField*>* body = nullptr;
+
+  if (lazy_body_->IsCached() == true) {
+    BISON_PRINT("Loading the cached body of %s\n", name_.c_str());
+
+    AstReader reader(lazy_body_->GetRecords(), lazy_body_->GetRecordsSize(), lazy_body_->GetStrings());
+    body = reader.ReadFields();
+  } else {
+    BISON_PRINT("Parsing the body of %s\n", name_.c_str());
+
+    // Same file and line as the original parse: error messages and line numbers are unchanged.
+    ParserContext context(lazy_body_->GetFileName(), lazy_body_->GetLine());
+    const std::string& text = lazy_body_->GetText();
+
+    bool parsed = context.ParseBody(text.c_str(), text.size());
+    assert(parsed == true);
+    (void) parsed;
+
+    body = context.GetBodyFields();
+  }
+
+  for (auto ff : *body) {
+    ExpressionField* ef = llvm::dyn_cast<ExpressionField>(ff);
+
+    if (ef != nullptr) {
+      ast_.push_back(ef->GetExpression());
+    } else {
+      // The signature was already handled, only locals can still show up.
+      LocalField* lf = llvm::dyn_cast<LocalField>(ff);
+
+      if (lf != nullptr) {
+        locals_.push_back(lf->GetLocal());
+      }
+    }
+  }
+
+  // Replace the text by the parsed fields: dumps then show the whole function.
+  fields_->remove(lazy_body_);
+  fields_->splice(fields_->end(), *body);
+
+  delete body, body = nullptr;
+  delete lazy_body_, lazy_body_ = nullptr;
+}
+
 void WasmFunction::GeneratePrototype(WasmModule* module) {
   // Remember the module.
   module_ = module;
@@ -116,45 +175,122 @@ void WasmFunction::GeneratePrototype(WasmModule* module) {
 
   // Now create the function.
   fct_ = llvm::Function::Create(fct_type, Function::ExternalLinkage, name_, module->GetModule());
+
+  // llc has to generate code for the CPU the vectorizers costed.
+  llvm::TargetMachine* target_machine = module->GetTargetMachine();
+
+  if (target_machine != nullptr) {
+    fct_->addFnAttr("target-cpu", target_machine->getTargetCPU());
+    fct_->addFnAttr("target-features", target_machine->getTargetFeatureString());
+  }
 }
 
-void WasmFunction::PopulateLocalHolders(llvm::IRBuilder<>& builder) {
-  for (auto local : locals_) {
-    const std::deque<LocalElem*>& elems = local->GetList();
+static llvm::Metadata* CreateLoopHint(const char* name, llvm::Constant* value) {
+  llvm::Metadata* ops[] = {
+    llvm::MDString::get(llvm::getGlobalContext(), name),
+    llvm::ConstantAsMetadata::get(value)
+  };
 
-    for (auto elem : elems) {
-      // Get the type.
-      ETYPE etype = elem->GetType();
-      // Convert to LLVM.
-      llvm::Type* type = ConvertType(etype);
-      assert(type != nullptr);
+  return llvm::MDNode::get(llvm::getGlobalContext(), ops);
+}
 
-      Allocate(elem->GetName(), type, builder);
-    }
+llvm::MDNode* WasmFunction::CreateLoopMetadata() const {
+  llvm::Type* i32 = llvm::Type::getInt32Ty(llvm::getGlobalContext());
+  int width = Globals::Get()->GetVectorizeWidth();
+  int interleave = Globals::Get()->GetInterleaveCount();
+
+  // The first operand is the node itself: each loop needs a distinct one.
+  std::vector<llvm::Metadata*> ops;
+  ops.push_back(nullptr);
+
+  if (force_vectorize_ == true) {
+    ops.push_back(CreateLoopHint("llvm.loop.vectorize.enable", llvm::ConstantInt::getTrue(llvm::getGlobalContext())));
+  }
+
+  if (width > 0) {
+    ops.push_back(CreateLoopHint("llvm.loop.vectorize.width", llvm::ConstantInt::get(i32, width)));
+  }
+
+  if (interleave > 0) {
+    ops.push_back(CreateLoopHint("llvm.loop.interleave.count", llvm::ConstantInt::get(i32, interleave)));
+  }
+
+  // Without hints, leave the loop to the cost models.
+  if (ops.size() == 1) {
+    return nullptr;
   }
+
+  llvm::MDNode* loop_id = llvm::MDNode::getDistinct(llvm::getGlobalContext(), ops);
+  loop_id->replaceOperandWith(0, loop_id);
+
+  return loop_id;
 }
 
-llvm::AllocaInst* WasmFunction::Allocate(const char* name, llvm::Type* type, llvm::IRBuilder<>& builder, bool is_argument) {
-  // If we have a name, fill it up.
-  llvm::AllocaInst* alloca_var = nullptr;
-  if (name != nullptr) {
-    alloca_var = CreateAlloca(name, type, builder, is_argument);
-    map_values_[name] = alloca_var;
-  } else {
-    std::ostringstream oss;
-    oss << "var_" << vector_values_.size();
-    // Create an anonymous one.
-    alloca_var = CreateAlloca(oss.str().c_str(), type, builder, is_argument);
+void WasmFunction::GenerateLinkage(bool exported) {
+  // Nothing outside of the module calls the function itself:
+  //   LLVM is free to inline it, drop it, change its signature and pass more arguments in registers.
+  fct_->setLinkage(Function::InternalLinkage);
+  fct_->setCallingConv(CallingConv::Fast);
+
+  if (exported == true) {
+    GenerateExportWrapper();
+  }
+}
+
+void WasmFunction::GenerateExportWrapper() {
+  // The wrapper takes over the name and keeps the C calling convention.
+  fct_->setName(name_ + "_fast");
+
+  wrapper_ = llvm::Function::Create(fct_->getFunctionType(), Function::ExternalLinkage, name_, module_->GetModule());
+  wrapper_->setAttributes(fct_->getAttributes());
+
+  llvm::BasicBlock* bb = llvm::BasicBlock::Create(getGlobalContext(), "entry", wrapper_);
+  llvm::IRBuilder<> builder(getGlobalContext());
+  builder.SetInsertPoint(bb);
+
+  std::vector<llvm::Value*> args;
+
+  for (auto &arg: wrapper_->args()) {
+    args.push_back(&arg);
+  }
+
+  // The module computes with the denormals flushed, the caller gets its own mode back.
+  llvm::Value* mxcsr = nullptr;
+
+  if (module_->IsFlushingDenormals() == true && Globals::Get()->GetFlushDenormalsAtInit() == false) {
+    mxcsr = module_->GenerateFlushDenormals(builder);
+
+    // Inlined, the floating-point code could be moved above the switch or below the restore.
+    fct_->addFnAttr(llvm::Attribute::NoInline);
+
+    // The wrapper itself reads and writes the control register.
+    wrapper_->removeFnAttr(llvm::Attribute::ReadNone);
+    wrapper_->removeFnAttr(llvm::Attribute::ReadOnly);
   }
 
-  // Always fill the vector.
-  // For now push nullptr there, we fill it later.
-  vector_values_.push_back(alloca_var);
+  llvm::CallInst* call = builder.CreateCall(fct_, args);
+  call->setCallingConv(fct_->getCallingConv());
 
-  return alloca_var;
+  if (mxcsr == nullptr) {
+    call->setTailCall();
+  }
+
+  module_->GenerateRestoreDenormals(mxcsr, builder);
+
+  if (result_ == VOID) {
+    builder.CreateRetVoid();
+  } else {
+    builder.CreateRet(call);
+  }
+}
+
+size_t WasmFunction::DefineLocal(const char* name, llvm::Type* type, llvm::Value* value, llvm::IRBuilder<>& builder) {
+  size_t idx = ssa_.AddLocal(name, type);
+  ssa_.Write(idx, value, builder.GetInsertBlock());
+  return idx;
 }
 
-void WasmFunction::PopulateAllocas(llvm::IRBuilder<>& builder) {
+void WasmFunction::PopulateLocals(llvm::IRBuilder<>& builder) {
   // The problem is that:
   //    WASM allows you to do (params i32 i32 ...) where a single node can have multiple parameters.
   //
@@ -193,41 +329,66 @@ void WasmFunction::PopulateAllocas(llvm::IRBuilder<>& builder) {
       arg.setName(elem->GetName());
     }
 
-    llvm::AllocaInst* alloca_var = Allocate(elem->GetName(), type, builder, true);
-
-    // Now create store towards that alloca.
-    builder.CreateStore(&arg, alloca_var);
+    // The parameter starts with the argument.
+    DefineLocal(elem->GetName(), type, &arg, builder);
 
     elem_it++;
   }
   assert(elem_it == elems.end());
 
-  // Generate place holders for the locals.
-  PopulateLocalHolders(builder);
-}
-
-llvm::AllocaInst* WasmFunction::CreateAlloca(const char* name, llvm::Type* type, llvm::IRBuilder<>& builder, bool is_argument) {
-  llvm::AllocaInst* res = builder.CreateAlloca(type, 0, name);
+  // The locals start at 0.
+  for (auto local : locals_) {
+    const std::deque<LocalElem*>& list = local->GetList();
 
-  // If it's an argument, do not store first 0.
-  if (is_argument == false) {
-    llvm::Value* zero = Constant::getNullValue(type);
+    for (auto elem : list) {
+      llvm::Type* type = ConvertType(elem->GetType());
+      assert(type != nullptr);
 
-    builder.CreateStore(zero, res);
+      DefineLocal(elem->GetName(), type, Constant::getNullValue(type), builder);
+    }
   }
+}
 
-  return res;
+void WasmFunction::SetDebugLocation(int line, llvm::IRBuilder<>& builder) const {
+  if (subprogram_ != nullptr && line != 0) {
+    builder.SetCurrentDebugLocation(llvm::DebugLoc::get(line, 0, subprogram_));
+  }
 }
 
 void WasmFunction::GetBaseMemory(llvm::IRBuilder<>& builder) {
   // Only care about this if we have a memory to the module.
-  //  We could check if the function would use it and use that but this should be
-  //   sufficient as LLVM can remove the call if it is unused.
-  if (module_->GetMemory() != -1) {
-    // Ok, then what we want is ask it for the address.
-    llvm::GlobalVariable* base = module_->GetBaseMemory();
+  //   A function known not to access memory does not even load the base.
+  //   Neither does a static memory: its base is a constant.
+  if (module_->GetMemory() != -1 && module_->IsMemoryStatic() == false && fct_->doesNotAccessMemory() == false) {
+    // The base is kept like a local: it is only loaded here and where the memory might have moved,
+    //   the SSA form carries it everywhere else.
+    local_base_idx_ = ssa_.AddLocal("local_base", llvm::Type::getInt8PtrTy(llvm::getGlobalContext()));
+    has_local_base_ = true;
+
+    ReloadBaseMemory(builder);
+  }
+}
+
+llvm::Value* WasmFunction::GetLocalBase(llvm::IRBuilder<>& builder) {
+  if (module_->IsMemoryStatic() == true) {
+    return module_->GetStaticMemoryBase();
+  }
+
+  assert(has_local_base_ == true);
+  return ssa_.Read(local_base_idx_, builder.GetInsertBlock());
+}
+
+void WasmFunction::SetLocalBase(llvm::Value* base, llvm::IRBuilder<>& builder) {
+  if (has_local_base_ == true) {
+    ssa_.Write(local_base_idx_, base, builder.GetInsertBlock());
+  }
+}
 
-    local_base_ = builder.CreateLoad(base, "local_base");
+void WasmFunction::ReloadBaseMemory(llvm::IRBuilder<>& builder) {
+  if (has_local_base_ == true) {
+    llvm::LoadInst* load = builder.CreateLoad(module_->GetBaseMemory(), "local_base");
+    load->setMetadata(llvm::LLVMContext::MD_tbaa, module_->GetBaseMemoryTBAA());
+    SetLocalBase(load, builder);
   }
 }
 
@@ -241,20 +402,38 @@ void WasmFunction::Generate() {
   llvm::IRBuilder<> builder(getGlobalContext());
   builder.SetInsertPoint(bb);
   llvm::Value* last = nullptr;
+  ETYPE last_type = VOID;
   bool is_last_return = false;
 
-  // Now that we have that, we can actually create the allocas for the input arguments and the locals of the method.
-  PopulateAllocas(builder);
+  // The function starts at its first expression.
+  int line = (ast_.empty() == false) ? ast_.front()->GetLine() : 0;
+  subprogram_ = module_->CreateSubprogram(fct_, name_, line);
+
+  // Every floating point operation generated by the builder gets the flags:
+  //   reductions can be reassociated and vectorized, the backend can contract a * b + c into a FMA.
+  if (fast_math_ == true) {
+    llvm::FastMathFlags flags;
+    flags.setUnsafeAlgebra();
+    builder.SetFastMathFlags(flags);
+
+    fct_->addFnAttr("unsafe-fp-math", "true");
+    fct_->addFnAttr("no-nans-fp-math", "true");
+    fct_->addFnAttr("no-infs-fp-math", "true");
+  }
+
+  // Now that we have that, we can actually give their first value to the input arguments and the locals of the method.
+  PopulateLocals(builder);
 
   // Generate the "get me the memory linear call".
   GetBaseMemory(builder);
 
   for (auto iter : ast_) {
     Expression* exp = iter;
-    last = exp->Codegen(this, builder);
-    is_last_return = (dynamic_cast<ReturnExpression*>(exp) != nullptr);
+    last = exp->Generate(this, builder);
+    last_type = exp->GetValueType();
+    is_last_return = (Expression::GetTerminator(builder) != nullptr);
 
-    // If it is a return, we stop generation here.
+    // If it is a return or a trap, even from an operand or the end of a block, we stop generation here.
     //  LLVM does not like having a return and then something else afterwards.
     if (is_last_return == true) {
       break;
@@ -264,40 +443,45 @@ void WasmFunction::Generate() {
   // For the last one, if it is not a return and our method has a result, this becomes our result.
   if (result_ != VOID) {
     if (is_last_return == false && last != nullptr) {
-      HandleReturn(last, builder);
+      HandleReturn(last, last_type, builder);
     }
-  } else {
+  } else if (is_last_return == false) {
     builder.CreateRetVoid();
   }
-}
 
-llvm::Value* WasmFunction::HandleReturn(llvm::Value* result, llvm::IRBuilder<>& builder) const {
-  // Get the type of the result: it might be void.
-  llvm::Type* result_type = result->getType();
+  // All the branches are there: the phis of the locals can be completed.
+  FinalizeLocals();
+}
 
-  if (result_type->isVoidTy()) {
-    // In this case, create a constant 0 and let the system handle it.
-    result = llvm::ConstantInt::get(llvm::getGlobalContext(), APInt(32, 0, false));
-  }
-  return builder.CreateRet(HandleSimpleTypeCasts(result, ConvertType(result_), false, builder));
+llvm::Value* WasmFunction::HandleReturn(llvm::Value* result, ETYPE type, llvm::IRBuilder<>& builder) const {
+  // The annotated type of the result might be void: it then becomes a 0.
+  return builder.CreateRet(ConvertValue(result, type, result_, false, builder));
 }
 
-llvm::AllocaInst* WasmFunction::GetVariable(const char* name) const {
-  std::map<std::string, llvm::AllocaInst*>::const_iterator it = map_values_.find(name);
+size_t WasmFunction::GetLocalIndex(Variable* var) const {
+  // The name resolution ran: a name left would have made the function invalid.
+  assert(var->IsString() == false);
+  size_t idx = var->GetIdx();
 
-  if (it == map_values_.end()) {
-    return nullptr;
-  }
+  assert(idx < ssa_.GetNbrLocals());
+  assert(has_local_base_ == false || idx != local_base_idx_);
+  return idx;
+}
 
-  return it->second;
+llvm::Value* WasmFunction::ReadLocal(Variable* var, llvm::IRBuilder<>& builder) {
+  return ssa_.Read(GetLocalIndex(var), builder.GetInsertBlock());
 }
 
-llvm::AllocaInst* WasmFunction::GetVariable(size_t idx) const {
-  if (idx < vector_values_.size()) {
-    return vector_values_[idx];
-  }
+void WasmFunction::WriteLocal(Variable* var, llvm::Value* value, llvm::IRBuilder<>& builder) {
+  size_t idx = GetLocalIndex(var);
+
+  // SetLocal already converted the value to the local's type.
+  assert(value->getType() == ssa_.GetType(idx));
+  ssa_.Write(idx, value, builder.GetInsertBlock());
+}
 
-  return nullptr;
+void WasmFunction::FinalizeLocals() {
+  ssa_.Finalize();
 }
 
 llvm::BasicBlock* WasmFunction::GetLabel(size_t from_last) {
@@ -312,24 +496,6 @@ llvm::BasicBlock* WasmFunction::GetLabel(size_t from_last) {
   return labels_[i];
 }
 
-llvm::BasicBlock* WasmFunction::GetLabel(const char* name) {
-  // First loop if we find it in the mapped association.
-  std::map<std::string, llvm::BasicBlock*>::const_iterator it;
-  it = mapped_labels_.find(name);
-
-  if (it != mapped_labels_.end()) {
-    return it->second;
-  }
-
-  for (auto elem : labels_) {
-    if (elem->getName() == name) {
-      return elem;
-    }
-  }
-
-  return nullptr;
-}
-
 void WasmFunction::MangleNames(WasmFile* file, WasmModule* module) {
   (void) file;
 
@@ -411,14 +577,3 @@ void WasmFunction::MangleFunctionName(WasmModule* module) {
   name_ = end_name;
 }
 
-bool WasmFunction::Walk(bool (*fct)(Expression*, void*), void* data) {
-  for (auto elem : ast_) {
-    fct(elem, data);
-
-    if (elem->Walk(fct, data) == false) {
-      return false;
-    }
-  }
-
-  return true;
-}
@@ -16,17 +16,21 @@
 #ifndef H_FUNCTION
 #define H_FUNCTION
 
+#include <algorithm>
+#include <atomic>
 #include <list>
 #include <vector>
 #include <sstream>
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 
 #include "debug.h"
 #include "function_field.h"
+#include "ssa_builder.h"
 
 using namespace llvm;
 
@@ -42,44 +46,79 @@ class WasmFunction {
   protected:
     std::string name_;
     Function* fct_;
+
+    // The C entry point of an exported function, fct_ being internal and fastcc.
+    Function* wrapper_;
     std::list<FunctionField*>* fields_;
     std::vector<ParamField*> params_;
     std::vector<Local*> locals_;
     WasmModule* module_;
 
     std::vector<llvm::BasicBlock*> labels_;
-    std::map<std::string, llvm::BasicBlock*> mapped_labels_;
 
-    // We have redundancy-ish here: since Wasm can do index or named, this helps make it
-    //   transparent and easier to maintain.
-    std::map<std::string, llvm::AllocaInst*> map_values_;
-    std::vector<llvm::AllocaInst*> vector_values_;
+    // The values of the parameters then the locals, by index or by name: no alloca, see SsaBuilder.
+    SsaBuilder ssa_;
 
     std::vector<Expression*> ast_;
     ETYPE result_;
 
+    // Set while the body is not parsed yet.
+    LazyBodyField* lazy_body_;
+
     std::map<llvm::BasicBlock*, NamedExpression*> named_exit_blocks_;
 
-    llvm::Value* local_base_;
+    // The base of the memory is a hidden local after all the others, see GetBaseMemory.
+    bool has_local_base_;
+    size_t local_base_idx_;
+
+    // Set if the source gave no name: the suffix is given back in source order, see SetAnonymousId.
+    bool anonymous_;
+
+    // Cleared by the type annotation pass if the body does not type check.
+    bool valid_;
+
+    // Cleared by the function attributes pass if no call of the function can grow the memory.
+    bool may_grow_memory_;
+
+    // Set for the exports listed by --vectorize.
+    bool force_vectorize_;
+
+    // Set by --fast-math: floating point operations may be reassociated and contracted.
+    bool fast_math_;
+
+    // The scope of the debug locations, nullptr without debug information.
+    llvm::DISubprogram* subprogram_;
 
     // Protected methods.
     void GetBaseMemory(llvm::IRBuilder<>& builder);
+    void GenerateExportWrapper();
 
   public:
     WasmFunction(std::list<FunctionField*>* f = nullptr, const std::string& s = "anonymous",
                  llvm::Function* fct = nullptr, WasmModule* module = nullptr, ETYPE result = VOID) :
-      name_(s), fct_(fct), fields_(f), module_(module), result_(result), local_base_(nullptr)
+      name_(s), fct_(fct), wrapper_(nullptr), fields_(f), module_(module), result_(result), lazy_body_(nullptr),
+      has_local_base_(false), local_base_idx_(0), anonymous_(false), valid_(true), may_grow_memory_(true),
+      force_vectorize_(false), fast_math_(false), subprogram_(nullptr)
       {
         // If anonymous, let's add a unique suffix.
         if (name_ == "anonymous") {
-          static int cnt = 0;
-          std::ostringstream oss;
-          oss << name_ << "_" << cnt;
-          cnt++;
-          name_ = oss.str();
+          // Atomic: functions can be created by concurrent parsers.
+          static std::atomic<int> cnt(0);
+          anonymous_ = true;
+          SetAnonymousId(cnt++);
         }
     }
 
+    bool IsAnonymous() const {
+      return anonymous_;
+    }
+
+    void SetAnonymousId(int id) {
+      std::ostringstream oss;
+      oss << "anonymous_" << id;
+      name_ = oss.str();
+    }
+
     void RegisterNamedExpression(llvm::BasicBlock* bb, NamedExpression* loop) {
       named_exit_blocks_[bb] = loop;
     }
@@ -94,8 +133,8 @@ class WasmFunction {
       return iter->second;
     }
 
-    void PushLabel(const std::string& name, llvm::BasicBlock* bb) {
-      mapped_labels_[name] = bb;
+    // The breaks find their label by index, see NameResolver.
+    void PushLabel(llvm::BasicBlock* bb) {
       labels_.push_back(bb);
     }
 
@@ -104,7 +143,6 @@ class WasmFunction {
     }
 
     llvm::BasicBlock* GetLabel(size_t from_last);
-    llvm::BasicBlock* GetLabel(const char* name);
 
     void SetName(const char* s) {
       name_ = s;
@@ -134,38 +172,138 @@ class WasmFunction {
       return fct_;
     }
 
-    llvm::Value* GetLocalBase() const {
-      return local_base_;
+    // What other modules call: only exports have a wrapper.
+    llvm::Function* GetExternalFunction() const {
+      if (wrapper_ != nullptr) {
+        return wrapper_;
+      }
+
+      return fct_;
     }
 
+    llvm::Value* GetLocalBase(llvm::IRBuilder<>& builder);
+    void SetLocalBase(llvm::Value* base, llvm::IRBuilder<>& builder);
+    void ReloadBaseMemory(llvm::IRBuilder<>& builder);
+
     ETYPE GetResult() const {
       return result_;
     }
 
+    void SetValid(bool valid) {
+      valid_ = valid;
+    }
+
+    bool IsValid() const {
+      return valid_;
+    }
+
+    void SetMayGrowMemory(bool may_grow_memory) {
+      may_grow_memory_ = may_grow_memory;
+    }
+
+    bool MayGrowMemory() const {
+      return may_grow_memory_;
+    }
+
+    void SetForceVectorize(bool force_vectorize) {
+      force_vectorize_ = force_vectorize;
+    }
+
+    bool GetForceVectorize() const {
+      return force_vectorize_;
+    }
+
+    void SetFastMath(bool fast_math) {
+      fast_math_ = fast_math;
+    }
+
+    bool GetFastMath() const {
+      return fast_math_;
+    }
+
+    // The llvm.loop hints of the loops of the function, nullptr if there are none.
+    llvm::MDNode* CreateLoopMetadata() const;
+
     WasmModule* GetModule() const {
       return module_;
     }
 
-    bool Walk(bool (*fct) (Expression*, void*), void* data);
+    std::list<FunctionField*>* GetFields() const {
+      return fields_;
+    }
+
+    const std::vector<ParamField*>& GetParams() const {
+      return params_;
+    }
+
+    const std::vector<Local*>& GetLocals() const {
+      return locals_;
+    }
+
+    // For passes needing new locals: they are numbered after all the others.
+    void AddLocal(Local* local) {
+      locals_.push_back(local);
+
+      if (fields_ != nullptr) {
+        fields_->push_back(new LocalField(local));
+      }
+    }
+
+    const std::vector<Expression*>& GetAST() const {
+      return ast_;
+    }
+
+    // For passes rewriting a top-level expression of the body.
+    void ReplaceExpression(Expression* old_expr, Expression* new_expr) {
+      std::replace(ast_.begin(), ast_.end(), old_expr, new_expr);
+    }
+
+    // For passes adding or removing top-level expressions.
+    void SetAST(const std::vector<Expression*>& ast) {
+      ast_ = ast;
+    }
+
+    bool IsBodyAvailable() const {
+      return lazy_body_ == nullptr;
+    }
+
+    void ParseBody();
+
+    // Every node of the body, in pre-order: stops as soon as fct returns false.
+    template <typename F>
+    bool Walk(F&& fct) {
+      for (auto elem : ast_) {
+        if (elem->Walk(fct) == false) {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    // What is generated next comes from this line of the .wast file, if known.
+    void SetDebugLocation(int line, llvm::IRBuilder<>& builder) const;
 
-    llvm::AllocaInst* GetVariable(const char* name) const;
-    llvm::AllocaInst* GetVariable(size_t idx) const;
+    size_t GetLocalIndex(Variable* var) const;
+    llvm::Value* ReadLocal(Variable* var, llvm::IRBuilder<>& builder);
+    void WriteLocal(Variable* var, llvm::Value* value, llvm::IRBuilder<>& builder);
 
-    llvm::AllocaInst* CreateAlloca(const char* name, llvm::Type* type, llvm::IRBuilder<>& builder, bool is_argument);
+    // Adds a local holding value in the current block: code generated outside of Generate then calls FinalizeLocals.
+    size_t DefineLocal(const char* name, llvm::Type* type, llvm::Value* value, llvm::IRBuilder<>& builder);
+    void FinalizeLocals();
 
-    void PopulateLocalHolders(llvm::IRBuilder<>& builder);
-    void PopulateAllocas(llvm::IRBuilder<>& builder);
-    llvm::AllocaInst* Allocate(const char* name, llvm::Type* type, llvm::IRBuilder<>& builder, bool is_argument = false);
+    void PopulateLocals(llvm::IRBuilder<>& builder);
 
     void Generate();
     void GeneratePrototype(WasmModule* module);
+    void GenerateLinkage(bool exported);
     void Populate();
 
     FunctionType* FindReturnType() const;
     void FindParams(std::vector<llvm::Type*>& params_) const;
 
     llvm::Type* GetReturnType() const;
-    llvm::Value* HandleReturn(llvm::Value* result, llvm::IRBuilder<>& builder) const;
+    llvm::Value* HandleReturn(llvm::Value* result, ETYPE type, llvm::IRBuilder<>& builder) const;
 
     void MangleNames(WasmFile* file, WasmModule* module);
     void MangleFunctionName(WasmModule* module);
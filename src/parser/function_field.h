@@ -16,6 +16,8 @@
 #ifndef H_FUNCTION_FIELD
 #define H_FUNCTION_FIELD
 
+#include <string>
+
 #include "enums.h"
 #include "expression.h"
 #include "local.h"
@@ -29,8 +31,28 @@
 class Expression;
 class Local;
 
+// The concrete field classes, used by classof.
+enum FieldKind {
+  FIELD_BASE,
+  FIELD_RESULT,
+  FIELD_PARAM,
+  FIELD_EXPRESSION,
+  FIELD_LAZY_BODY,
+  FIELD_LOCAL,
+};
+
 class FunctionField {
+  protected:
+    const FieldKind kind_;
+
   public:
+    FunctionField(FieldKind kind = FIELD_BASE) : kind_(kind) {
+    }
+
+    FieldKind GetKind() const {
+      return kind_;
+    }
+
     virtual void Dump(int tabs = 0) {
       BISON_TABBED_PRINT(tabs, "(Base Function Field)");
     }
@@ -45,10 +67,14 @@ class ResultField : public FunctionField {
     ETYPE type_;
 
   public:
-    ResultField() : type_(INT_32) {
+    static bool classof(const FunctionField* field) {
+      return field->GetKind() == FIELD_RESULT;
+    }
+
+    ResultField() : FunctionField(FIELD_RESULT), type_(INT_32) {
     }
 
-    ResultField(int value) : type_(static_cast<ETYPE> (value)) {
+    ResultField(int value) : FunctionField(FIELD_RESULT), type_(static_cast<ETYPE> (value)) {
     }
 
     ETYPE GetType() const {
@@ -65,10 +91,14 @@ class ParamField : public FunctionField {
     Local* local_;
 
   public:
-    ParamField() : local_(nullptr) {
+    static bool classof(const FunctionField* field) {
+      return field->GetKind() == FIELD_PARAM;
+    }
+
+    ParamField() : FunctionField(FIELD_PARAM), local_(nullptr) {
     }
 
-    ParamField(Local* l) : local_(l) {
+    ParamField(Local* l) : FunctionField(FIELD_PARAM), local_(l) {
     }
 
     Local* GetLocal() const {
@@ -89,10 +119,14 @@ class ExpressionField : public FunctionField {
     Expression* expression_;
 
   public:
-    ExpressionField() : expression_(nullptr) {
+    static bool classof(const FunctionField* field) {
+      return field->GetKind() == FIELD_EXPRESSION;
     }
 
-    ExpressionField(Expression* param) : expression_(param) {
+    ExpressionField() : FunctionField(FIELD_EXPRESSION), expression_(nullptr) {
+    }
+
+    ExpressionField(Expression* param) : FunctionField(FIELD_EXPRESSION), expression_(param) {
     }
 
     virtual void Dump(int tabs = 0) {
@@ -112,15 +146,86 @@ class ExpressionField : public FunctionField {
     }
 };
 
+/**
+ * Body of a function kept as its source text: the expressions are only parsed
+ *   if the function turns out to be needed, see WasmFunction::ParseBody
+ */
+class LazyBodyField : public FunctionField {
+  protected:
+    std::string text_;
+    const char* file_name_;
+    int line_;
+
+    // Set instead of the text when the body comes from the AST cache.
+    const char* records_;
+    size_t records_size_;
+    const char* strings_;
+
+  public:
+    static bool classof(const FunctionField* field) {
+      return field->GetKind() == FIELD_LAZY_BODY;
+    }
+
+    LazyBodyField(const std::string& text, const char* file_name, int line) :
+      FunctionField(FIELD_LAZY_BODY), text_(text), file_name_(file_name), line_(line),
+      records_(nullptr), records_size_(0), strings_(nullptr) {
+    }
+
+    LazyBodyField(const char* records, size_t records_size, const char* strings) :
+      FunctionField(FIELD_LAZY_BODY), file_name_(nullptr), line_(0),
+      records_(records), records_size_(records_size), strings_(strings) {
+    }
+
+    bool IsCached() const {
+      return records_ != nullptr;
+    }
+
+    const char* GetRecords() const {
+      return records_;
+    }
+
+    size_t GetRecordsSize() const {
+      return records_size_;
+    }
+
+    const char* GetStrings() const {
+      return strings_;
+    }
+
+    const std::string& GetText() const {
+      return text_;
+    }
+
+    const char* GetFileName() const {
+      return file_name_;
+    }
+
+    int GetLine() const {
+      return line_;
+    }
+
+    virtual void Dump(int tabs = 0) {
+      if (IsCached() == true) {
+        BISON_TABBED_PRINT(tabs, "(Cached body)");
+      } else {
+        BISON_TABBED_PRINT(tabs, "(Unparsed body from line %d)", line_);
+      }
+    }
+};
+
 class LocalField : public FunctionField {
   protected:
     Local* local_;
 
   public:
-    LocalField() : local_(nullptr) {
+    static bool classof(const FunctionField* field) {
+      return field->GetKind() == FIELD_LOCAL;
+    }
+
+    LocalField() : FunctionField(FIELD_LOCAL), local_(nullptr) {
     }
 
-    LocalField(Local* l) : local_(l) {
+    LocalField(Local* l) : FunctionField(FIELD_LOCAL), local_(l) {
     }
 
     Local* GetLocal() const {
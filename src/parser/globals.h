@@ -19,20 +19,40 @@
 
 #include <memory>
 
-#include "wasm_file.h"
-
+// Command line options: everything related to a given parse lives in the ParserContext.
 class Globals {
   protected:
-    int line_cnt_;
-    char* name_;
-    WasmFile* file_;
     bool disable_verif_opt_;
+    // Threads for the parser and the function passes.
+    int jobs_;
+    const char* ast_cache_directory_;
+    const char* pass_list_;
+    bool time_passes_;
+    bool static_memory_;
+    // Loop hints: the exports whose loops must be vectorized, 0 lets the cost model decide the others.
+    const char* vectorize_list_;
+    int vectorize_width_;
+    int interleave_count_;
+    // The .wast file, named by the debug locations.
+    const char* input_file_name_;
+    const char* remarks_file_;
+    // Relaxed floating point, for every function if the list is nullptr.
+    bool fast_math_;
+    const char* fast_math_list_;
+    // Denormals flushed to zero, around the exports or once for the process by wasm_llvm_init.
+    bool flush_denormals_;
+    const char* flush_denormals_list_;
+    bool flush_denormals_at_init_;
 
     static std::unique_ptr<Globals> g_variables_;
 
   public:
-    Globals() : line_cnt_(1), name_(nullptr), file_(nullptr),
-                disable_verif_opt_(false) {
+    Globals() : disable_verif_opt_(false), jobs_(1), ast_cache_directory_(nullptr),
+                pass_list_(nullptr), time_passes_(false), static_memory_(false),
+                vectorize_list_(nullptr), vectorize_width_(0), interleave_count_(0),
+                input_file_name_(nullptr), remarks_file_(nullptr),
+                fast_math_(false), fast_math_list_(nullptr),
+                flush_denormals_(false), flush_denormals_list_(nullptr), flush_denormals_at_init_(false) {
     }
 
     void DisableVerificationOptimization() {
@@ -43,28 +63,128 @@ class Globals {
       return disable_verif_opt_;
     }
 
-    void SetWasmFile(WasmFile* f) {
-      file_ = f;
+    void SetJobs(int jobs) {
+      jobs_ = jobs;
+    }
+
+    int GetJobs() const {
+      return jobs_;
+    }
+
+    void SetAstCacheDirectory(const char* directory) {
+      ast_cache_directory_ = directory;
+    }
+
+    // nullptr if there is no AST cache.
+    const char* GetAstCacheDirectory() const {
+      return ast_cache_directory_;
+    }
+
+    void SetPassList(const char* list) {
+      pass_list_ = list;
+    }
+
+    // nullptr for the default pipeline.
+    const char* GetPassList() const {
+      return pass_list_;
+    }
+
+    void EnableTimePasses() {
+      time_passes_ = true;
+    }
+
+    bool GetTimePasses() const {
+      return time_passes_;
+    }
+
+    void EnableStaticMemory() {
+      static_memory_ = true;
+    }
+
+    // Modules that never grow their memory get it as a global array.
+    bool GetStaticMemory() const {
+      return static_memory_;
+    }
+
+    void SetVectorizeList(const char* list) {
+      vectorize_list_ = list;
+    }
+
+    // Comma-separated export names, nullptr if none.
+    const char* GetVectorizeList() const {
+      return vectorize_list_;
+    }
+
+    void SetVectorizeWidth(int width) {
+      vectorize_width_ = width;
+    }
+
+    int GetVectorizeWidth() const {
+      return vectorize_width_;
+    }
+
+    void SetInterleaveCount(int count) {
+      interleave_count_ = count;
+    }
+
+    int GetInterleaveCount() const {
+      return interleave_count_;
+    }
+
+    void SetInputFileName(const char* file_name) {
+      input_file_name_ = file_name;
+    }
+
+    const char* GetInputFileName() const {
+      return input_file_name_;
+    }
+
+    void SetRemarksFile(const char* file_name) {
+      remarks_file_ = file_name;
+    }
+
+    // nullptr if there are no remarks: no debug locations are generated then.
+    const char* GetRemarksFile() const {
+      return remarks_file_;
+    }
+
+    void EnableFastMath(const char* list) {
+      fast_math_ = true;
+      fast_math_list_ = list;
+    }
+
+    bool GetFastMath() const {
+      return fast_math_;
+    }
+
+    // Comma-separated module and export names, nullptr for all of them.
+    const char* GetFastMathList() const {
+      return fast_math_list_;
     }
 
-    WasmFile* GetWasmFile() const {
-      return file_;
+    void EnableFlushDenormals(const char* list) {
+      flush_denormals_ = true;
+      flush_denormals_list_ = list;
     }
 
-    void IncrementLineCnt(int inc = 1) {
-      line_cnt_ += inc;
+    // The process-wide mode covers every module.
+    void EnableFlushDenormalsAtInit() {
+      flush_denormals_ = true;
+      flush_denormals_list_ = nullptr;
+      flush_denormals_at_init_ = true;
     }
 
-    int GetLineCnt() const {
-      return line_cnt_;
+    bool GetFlushDenormals() const {
+      return flush_denormals_;
     }
 
-    const char* GetFileName() const {
-      return name_;
+    // Comma-separated module names, nullptr for all of them.
+    const char* GetFlushDenormalsList() const {
+      return flush_denormals_list_;
     }
 
-    void SetFileName(char* name) {
-      name_ = name;
+    bool GetFlushDenormalsAtInit() const {
+      return flush_denormals_at_init_;
     }
 
     static Globals* Get() {
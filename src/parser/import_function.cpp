@@ -62,7 +62,7 @@ void WasmImportFunction::Populate(std::vector<llvm::Type*>& params) {
       const FunctionField* ff = *it;
 
       // Is it a result?
-      const ResultField* rf = dynamic_cast<const ResultField*>(ff);
+      const ResultField* rf = llvm::dyn_cast<ResultField>(ff);
       if (rf != nullptr) {
         // We only support one return.
         assert(result_ == VOID);
@@ -70,7 +70,7 @@ void WasmImportFunction::Populate(std::vector<llvm::Type*>& params) {
         result_ = rf->GetType();
       } else {
         // What about a parameter?
-        const ParamField* pf = dynamic_cast<const ParamField*>(ff);
+        const ParamField* pf = llvm::dyn_cast<ParamField>(ff);
 
         // In the case of an import function, it has to either be a result or a parameter...
         assert (pf != nullptr);
@@ -17,6 +17,7 @@
 #ifndef H_IMPORT_FUNCTION
 #define H_IMPORT_FUNCTION
 
+#include <atomic>
 #include <list>
 #include <string>
 #include <sstream>
@@ -57,10 +58,9 @@ class WasmImportFunction {
                        result_(VOID) {
       // If anonymous, let's add a unique suffix.
       if (internal_name_ == "imported_anonymous") {
-        static int cnt = 0;
+        static std::atomic<int> cnt(0);
         std::ostringstream oss;
-        oss << internal_name_ << "_" << cnt;
-        cnt++;
+        oss << internal_name_ << "_" << cnt++;
         internal_name_ = oss.str();
       }
     }
@@ -88,6 +88,18 @@ class WasmImportFunction {
     const std::string& GetName() {
       return internal_name_;
     }
+
+    const std::string& GetModuleName() const {
+      return module_name_;
+    }
+
+    const std::string& GetFunctionName() const {
+      return function_name_;
+    }
+
+    std::list<FunctionField*>* GetFields() const {
+      return fields_;
+    }
 };
 
 #endif
@@ -14,26 +14,24 @@
 // limitations under the License.
 */
 
+#include <algorithm>
+
+#include "binop.h"
+#include "expression.h"
 #include "memory.h"
 #include "function.h"
 
-llvm::Type* MemoryExpression::GetAddressType() const {
-  llvm::Type* type = nullptr;
-
+ETYPE MemoryExpression::GetAccessType() const {
   if (type_ == INT_32 || type_ == INT_64) {
     switch (size_) {
       case 8:
-        type = llvm::Type::getInt8Ty(llvm::getGlobalContext());
-        break;
+        return INT_8;
       case 16:
-        type = llvm::Type::getInt16Ty(llvm::getGlobalContext());
-        break;
+        return INT_16;
       case 32:
-        type = llvm::Type::getInt32Ty(llvm::getGlobalContext());
-        break;
+        return INT_32;
       case 64:
-        type = llvm::Type::getInt64Ty(llvm::getGlobalContext());
-        break;
+        return INT_64;
       default:
         assert(0);
         break;
@@ -41,115 +39,165 @@ llvm::Type* MemoryExpression::GetAddressType() const {
   } else {
     switch (size_) {
       case 32:
-        type = llvm::Type::getFloatTy(llvm::getGlobalContext());
-        break;
+        return FLOAT_32;
       case 64:
-        type = llvm::Type::getDoubleTy(llvm::getGlobalContext());
-        break;
+        return FLOAT_64;
       default:
         assert(0);
         break;
     }
   }
 
-  return type;
+  return VOID;
 }
 
-llvm::Value* MemoryExpression::GetPointer(WasmFunction*fct, llvm::IRBuilder<>& builder) const {
-  llvm::Type* ptr_type= nullptr;
+llvm::Type* MemoryExpression::GetAddressType() const {
+  return ConvertType(GetAccessType());
+}
 
-  if (type_ == INT_32 || type_ == INT_64) {
-    switch (size_) {
-      case 8:
-        ptr_type= llvm::Type::getInt8PtrTy(llvm::getGlobalContext());
-        break;
-      case 16:
-        ptr_type= llvm::Type::getInt16PtrTy(llvm::getGlobalContext());
-        break;
-      case 32:
-        ptr_type= llvm::Type::getInt32PtrTy(llvm::getGlobalContext());
-        break;
-      case 64:
-        ptr_type= llvm::Type::getInt64PtrTy(llvm::getGlobalContext());
-        break;
-      default:
-        assert(0);
-        break;
+// The memory base comes from malloc, or is a global aligned like it: no access needs more.
+static const uint64_t kMaxAlignment = 16;
+
+// Alignment, in bytes, of the values expr can take: what the computation guarantees, whatever the inputs.
+static uint64_t GetKnownAlignment(Expression* expr) {
+  switch (expr->GetKind()) {
+    case EXPR_CONST: {
+      Const* constant = llvm::cast<Const>(expr);
+
+      if (constant->GetType() != INT_32 && constant->GetType() != INT_64) {
+        return 1;
+      }
+
+      // The lowest set bit, 0 being aligned on anything.
+      uint64_t bits = constant->GetValue()->GetInteger();
+      return (bits == 0) ? kMaxAlignment : std::min(bits & -bits, kMaxAlignment);
     }
-  } else {
-    switch (size_) {
-      case 32:
-        ptr_type= llvm::Type::getFloatPtrTy(llvm::getGlobalContext());
-        break;
-      case 64:
-        ptr_type= llvm::Type::getDoublePtrTy(llvm::getGlobalContext());
-        break;
-      default:
-        assert(0);
-        break;
+    case EXPR_BINOP: {
+      Binop* binop = llvm::cast<Binop>(expr);
+      uint64_t left = GetKnownAlignment(binop->GetLeft());
+      uint64_t right = GetKnownAlignment(binop->GetRight());
+
+      switch (binop->GetOperation()->GetOperation()) {
+        case ADD_OPER:
+        case SUB_OPER:
+        case OR_OPER:
+          return std::min(left, right);
+        case AND_OPER:
+          // A mask clearing the low bits aligns whatever the other side is.
+          return std::max(left, right);
+        case MUL_OPER:
+          return std::min(left * right, kMaxAlignment);
+        case SHL_OPER: {
+          Const* count = llvm::dyn_cast<Const>(binop->GetRight());
+
+          if (count == nullptr) {
+            return left;
+          }
+
+          uint64_t shift = count->GetValue()->GetInteger() & 63;
+          return (shift >= 4) ? kMaxAlignment : std::min(left << shift, kMaxAlignment);
+        }
+        default:
+          return 1;
+      }
     }
+    default:
+      return 1;
+  }
+}
+
+unsigned MemoryExpression::GetAlignment() const {
+  unsigned natural = size_ / 8;
+
+  // Wasm allows any address: align= is only a hint, the code might not keep its promise.
+  //   The access is as aligned as its address computation guarantees.
+  uint64_t alignment = GetKnownAlignment(address_);
+
+  if (offset_ != 0) {
+    alignment = std::min(alignment, static_cast<uint64_t>(offset_ & -offset_));
   }
 
-  assert(ptr_type != nullptr);
+  // More than the natural alignment is of no use to the access.
+  return std::min(static_cast<unsigned>(alignment), natural);
+}
+
+llvm::Value* MemoryExpression::GenerateIndex(WasmFunction* fct, llvm::IRBuilder<>& builder) const {
+  // Create the index in the memory, in 64-bit.
+  llvm::Value* address_i = address_->Generate(fct, builder);
+
+  // An address that jumps away has no index: the terminator is handed back instead.
+  llvm::Value* terminator = GetTerminator(builder);
 
-  // Create the base address in the same right type.
-  llvm::Value* address_i = address_->Codegen(fct, builder);
-  llvm::Value* local_base = fct->GetLocalBase();
-  llvm::Type* type_64 = llvm::Type::getInt64Ty(llvm::getGlobalContext());
-  local_base = builder.CreatePtrToInt(local_base, type_64, "base");
+  if (terminator != nullptr) {
+    return terminator;
+  }
 
-  llvm::Type* address_type = address_i->getType();
-  assert(address_type->isIntegerTy() == true);
-  int bw = address_i->getType()->getIntegerBitWidth();
+  ETYPE address_type = address_->GetValueType();
+  assert(address_type != FLOAT_32 && address_type != FLOAT_64);
 
   // If not 64, transform it into 64.
-  if (bw != 64) {
-    address_i = HandleIntegerTypeCast(address_i, type_64, bw, 64, false, builder);
-  }
+  bool extended = (address_type != INT_64);
 
-  address_i = builder.CreateAdd(address_i, local_base, "start_add");
+  if (extended == true) {
+    address_i = ConvertValue(address_i, address_type, INT_64, false, builder);
+  }
 
-  // If we have an offset, add it here.
+  // If we have an offset, add it here: a zero-extended 32-bit address and a 32-bit offset cannot wrap in 64-bit.
   if (offset_ != 0) {
     int64_t offset64 = offset_;
     llvm::Value* offset = llvm::ConstantInt::get(llvm::getGlobalContext(), APInt(64, offset64, false));
 
-    address_i = builder.CreateAdd(address_i, offset, "with_offset");
+    if (extended == true) {
+      address_i = builder.CreateNUWAdd(address_i, offset, "with_offset");
+    } else {
+      address_i = builder.CreateAdd(address_i, offset, "with_offset");
+    }
   }
 
-  return builder.CreateIntToPtr(address_i, ptr_type, "ptr");
+  return address_i;
+}
+
+llvm::Value* MemoryExpression::GetPointer(WasmFunction* fct, llvm::Value* index, llvm::IRBuilder<>& builder) const {
+  // A GEP from the base keeps the provenance of the pointer: alias analysis and SCEV see through it,
+  //   and the addition folds in the addressing mode.
+  llvm::Type* char_type = llvm::Type::getInt8Ty(llvm::getGlobalContext());
+  llvm::Value* ptr = builder.CreateInBoundsGEP(char_type, fct->GetLocalBase(builder), index, "address");
+
+  return builder.CreateBitCast(ptr, GetAddressType()->getPointerTo(), "ptr");
 }
 
 llvm::Value* Load::ResizeIntegerIfNeed(llvm::Value* value,
-                                        llvm::Type* value_type,
                                         bool sign,
                                         llvm::IRBuilder<>& builder) {
-  // Get size differences.
-  size_t value_type_bw = value_type->getIntegerBitWidth();
-  size_t type_size = GetTypeSize(type_);
-
-  if (value_type_bw != type_size) {
-    // Then it depends on sign.
-    value = HandleIntegerTypeCast(value, ConvertType(type_),
-                                  value_type_bw,
-                                  type_size,
-                                  sign, builder);
-  }
-
-  return value;
+  // The memory holds size_ bits: the extension depends on sign.
+  return ConvertValue(value, GetAccessType(), type_, sign, builder);
 }
 
 llvm::Value* Load::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
-  llvm::Value* address = GetPointer(fct, builder);
+  llvm::Value* index = GenerateIndex(fct, builder);
+
+  if (GetTerminator(builder) != nullptr) {
+    return index;
+  }
+
+  llvm::Value* address = GetPointer(fct, index, builder);
 
   // Create the load.
-  llvm::Value* value = builder.CreateLoad(address, "load");
+  llvm::LoadInst* load = builder.CreateAlignedLoad(address, GetAlignment(), "load");
+
+  load->setMetadata(llvm::LLVMContext::MD_tbaa, fct->GetModule()->GetMemoryTBAA());
+
+  if (invariant_ == true) {
+    load->setMetadata(llvm::LLVMContext::MD_invariant_load, llvm::MDNode::get(llvm::getGlobalContext(), llvm::None));
+  }
+
+  llvm::Value* value = load;
 
   // Now we need to convert this load to a size potentially.
   switch (type_) {
     case INT_32:
     case INT_64:
-      value = ResizeIntegerIfNeed(value, value->getType(), sign_, builder);
+      value = ResizeIntegerIfNeed(value, sign_, builder);
       break;
     case FLOAT_32:
     case FLOAT_64:
@@ -164,40 +212,43 @@ llvm::Value* Load::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
 }
 
 llvm::Value* Store::ResizeIntegerIfNeed(llvm::Value* value,
-                                        llvm::Type* value_type,
+                                        ETYPE value_type,
                                         bool sign,
                                         llvm::IRBuilder<>& builder) {
-  // Get size differences.
-  size_t value_type_bw = value_type->getIntegerBitWidth();
-
-  if (value_type_bw != size_) {
-    // Then it depends on sign.
-    value = HandleIntegerTypeCast(value, GetAddressType(),
-                                  value_type_bw, size_,
-                                  sign, builder);
-  }
-
-  return value;
+  // Only size_ bits go to the memory.
+  return ConvertValue(value, value_type, GetAccessType(), sign, builder);
 }
 
 llvm::Value* Store::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
-  llvm::Value* address = GetPointer(fct, builder);
-  llvm::Value* original_value = value_->Codegen(fct, builder);
+  llvm::Value* index = GenerateIndex(fct, builder);
 
-  // Check if the type of what we are storing is the same type as what we have like size.
-  llvm::Type* value_type = original_value->getType();
+  if (GetTerminator(builder) != nullptr) {
+    return index;
+  }
 
-  llvm::Type::TypeID value_type_id = value_type->getTypeID();
+  llvm::Value* original_value = value_->Generate(fct, builder);
+
+  if (GetTerminator(builder) != nullptr) {
+    return original_value;
+  }
+
+  // The value might have grown the memory: only now is the base the right one.
+  llvm::Value* address = GetPointer(fct, index, builder);
+
+  // Check if the type of what we are storing is the same type as what we have like size.
+  ETYPE value_type = value_->GetValueType();
+  bool is_integer = (value_type != FLOAT_32 && value_type != FLOAT_64);
 
   // Handle integer a bit specially: we might want a resize.
   llvm::Value* value = original_value;
-  if (value_type_id == llvm::Type::IntegerTyID) {
+  if (is_integer == true) {
     value = ResizeIntegerIfNeed(value, value_type, sign_, builder);
   } else {
     assert(GetTypeSize(type_) == size_);
   }
 
-  builder.CreateStore(value, address, "store");
+  llvm::StoreInst* store = builder.CreateAlignedStore(value, address, GetAlignment());
+  store->setMetadata(llvm::LLVMContext::MD_tbaa, fct->GetModule()->GetMemoryTBAA());
   return original_value;
 }
 
@@ -206,23 +257,33 @@ llvm::Value* MemoryGrow::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder)
 
   std::vector<llvm::Value*> args;
 
-  // Get the module.
+  // Get the module: a memory growth keeps the memory dynamic.
   WasmModule* wasm_module = fct->GetModule();
+  assert(wasm_module->IsMemoryStatic() == false);
 
   llvm::Function* realloc_fct = wasm_module->GetReallocFunction();
 
-  llvm::GlobalVariable* base = wasm_module->GetBaseMemory();
-  llvm::Value* local_base = builder.CreateLoad(base, "local_base");
-  args.push_back(local_base);
+  // Generate the new size code: it might grow the memory itself, the base is read after it.
+  llvm::Value* new_size = expr_->Generate(fct, builder);
 
-  // Generate the new size code.
-  llvm::Value* new_size = expr_->Codegen(fct, builder);
-  llvm::Type* size_type = llvm::Type::getInt32Ty(getGlobalContext());
-  new_size = HandleSimpleTypeCasts(new_size, size_type, false, builder);
+  if (GetTerminator(builder) != nullptr) {
+    return new_size;
+  }
+
+  new_size = ConvertValue(new_size, expr_->GetValueType(), INT_32, false, builder);
+
+  args.push_back(fct->GetLocalBase(builder));
   args.push_back(new_size);
 
+  // The result is the previous size.
+  llvm::LoadInst* old_size = builder.CreateLoad(wasm_module->GetMemorySize(), "old_size");
+  old_size->setMetadata(llvm::LLVMContext::MD_tbaa, wasm_module->GetMemorySizeTBAA());
+
   llvm::Value* result = builder.CreateCall(realloc_fct, args, "grow");
 
-  // Finally, store back the new elements.
+  // Finally, store back the new elements: the memory might have moved.
   wasm_module->UpdateMemoryInformation(result, new_size, builder);
+  fct->SetLocalBase(result, builder);
+
+  return old_size;
 }
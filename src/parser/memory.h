@@ -82,15 +82,23 @@ class MemoryExpression : public Expression {
     ETYPE type_;
 
     uint32_t offset_;
+    // In bytes, as declared by align=, a power of 2: 0 if not declared. Only a hint, see GetAlignment.
     uint32_t align_;
 
+    void SerializeMemoryInformation(AstWriter& writer) const;
+
   public:
-    MemoryExpression(size_t size) : address_(nullptr), size_(size), sign_(0), type_(VOID),
-                                    offset_(0), align_(size) {
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() >= EXPR_LOAD && expr->GetKind() <= EXPR_STORE;
+    }
+
+    MemoryExpression(ExpressionKind kind, size_t size) : Expression(kind), address_(nullptr), size_(size), sign_(0), type_(VOID),
+                                    offset_(0), align_(0) {
     }
 
-    MemoryExpression(Expression* address = nullptr, size_t size = 0, bool sign = false, ETYPE type = VOID) : address_(address), size_(size), sign_(sign), type_(type),
-                      offset_(0), align_(size) {
+    MemoryExpression(ExpressionKind kind, Expression* address = nullptr, size_t size = 0, bool sign = false, ETYPE type = VOID) :
+                      Expression(kind), address_(address), size_(size), sign_(sign), type_(type),
+                      offset_(0), align_(0) {
     }
 
     void SetOffsetAlign(OffsetAlignInformation* oai) {
@@ -103,10 +111,19 @@ class MemoryExpression : public Expression {
       }
     }
 
+    void SetOffsetAlign(uint32_t offset, uint32_t align) {
+      offset_ = offset;
+      align_ = align;
+    }
+
     void SetType(ETYPE t) {
       type_ = t;
     }
 
+    ETYPE GetType() const {
+      return type_;
+    }
+
     void SetSign(bool b) {
       sign_ = b;
     }
@@ -115,10 +132,26 @@ class MemoryExpression : public Expression {
       address_ = address;
     }
 
+    Expression* GetAddress() const {
+      return address_;
+    }
+
     void SetSize(size_t size) {
       size_ = size;
     }
 
+    size_t GetSize() const {
+      return size_;
+    }
+
+    bool GetSign() const {
+      return sign_;
+    }
+
+    uint32_t GetOffset() const {
+      return offset_;
+    }
+
     virtual void Dump(int tabs) const {
       BISON_TABBED_PRINT(tabs, "(%s.memory operation", GetETypeName(type_));
 
@@ -131,8 +164,23 @@ class MemoryExpression : public Expression {
       BISON_PRINT(")");
     }
 
-    llvm::Value* GetPointer(WasmFunction* fct, llvm::IRBuilder<>& builder) const;
+    virtual bool ForEachChild(ChildFunction fct, void* data) const {
+      return CallOnChild(address_, fct, data);
+    }
+
+    virtual void ReplaceChild(Expression* old_child, Expression* new_child) {
+      assert(address_ == old_child);
+      address_ = new_child;
+    }
+
+    virtual void ResolveNames(NameResolver& resolver);
+
+    // The address is generated first: its code might grow the memory, so the base is only read by GetPointer.
+    llvm::Value* GenerateIndex(WasmFunction* fct, llvm::IRBuilder<>& builder) const;
+    llvm::Value* GetPointer(WasmFunction* fct, llvm::Value* index, llvm::IRBuilder<>& builder) const;
+    ETYPE GetAccessType() const;
     llvm::Type* GetAddressType() const;
+    unsigned GetAlignment() const;
 
     void UpdateSize() {
       if (size_ == 0) {
@@ -147,25 +195,51 @@ class Store : public MemoryExpression {
     Expression* value_;
 
     llvm::Value* ResizeIntegerIfNeed(llvm::Value* value,
-                                     llvm::Type* value_type,
+                                     ETYPE value_type,
                                      bool sign,
                                      llvm::IRBuilder<>& builder);
 
   public:
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_STORE;
+    }
+
     Store(Expression* add, Expression* value) :
-      MemoryExpression(add), value_(value) {
+      MemoryExpression(EXPR_STORE, add), value_(value) {
     }
 
-    Store() : MemoryExpression(), value_(nullptr) {
+    Store() : MemoryExpression(EXPR_STORE), value_(nullptr) {
     }
 
-    Store(size_t size) : MemoryExpression(size), value_(nullptr) {
+    Store(size_t size) : MemoryExpression(EXPR_STORE, size), value_(nullptr) {
     }
 
     void SetValue(Expression* value) {
       value_ = value;
     }
 
+    Expression* GetValue() const {
+      return value_;
+    }
+
+    virtual bool ForEachChild(ChildFunction fct, void* data) const {
+      return CallOnChild(address_, fct, data) &&
+             CallOnChild(value_, fct, data);
+    }
+
+    virtual void ReplaceChild(Expression* old_child, Expression* new_child) {
+      if (address_ == old_child) {
+        address_ = new_child;
+      } else {
+        assert(value_ == old_child);
+        value_ = new_child;
+      }
+    }
+
+    virtual void ResolveNames(NameResolver& resolver);
+
+    virtual void Serialize(AstWriter& writer) const;
+
     virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 
     virtual void Dump(int tabs) const {
@@ -197,19 +271,34 @@ class Store : public MemoryExpression {
 
 class Load : public MemoryExpression {
   protected:
+    // Set by the read-only memory pass: nothing can write where the load reads.
+    bool invariant_;
 
     llvm::Value* ResizeIntegerIfNeed(llvm::Value* value,
-                                     llvm::Type* value_type,
                                      bool sign,
                                      llvm::IRBuilder<>& builder);
 
   public:
-    Load() : MemoryExpression() {
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_LOAD;
+    }
+
+    Load() : MemoryExpression(EXPR_LOAD), invariant_(false) {
     }
 
-    Load(size_t size) : MemoryExpression(size) {
+    Load(size_t size) : MemoryExpression(EXPR_LOAD, size), invariant_(false) {
     }
 
+    void SetInvariant(bool invariant) {
+      invariant_ = invariant;
+    }
+
+    bool IsInvariant() const {
+      return invariant_;
+    }
+
+    virtual void Serialize(AstWriter& writer) const;
+
     virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 
     virtual void Dump(int tabs) const {
@@ -233,10 +322,27 @@ class Load : public MemoryExpression {
 
 class MemorySize : public Expression {
   public:
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_MEMORY_SIZE;
+    }
+
+    MemorySize() : Expression(EXPR_MEMORY_SIZE) {
+    }
+
+    virtual void Serialize(AstWriter& writer) const;
+
     virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
       WasmModule* module = fct->GetModule();
+
+      // A static memory never changes size.
+      if (module->IsMemoryStatic() == true) {
+        return llvm::ConstantInt::get(llvm::getGlobalContext(), APInt(32, module->GetMemory(), false));
+      }
+
       llvm::GlobalVariable* mem_size = module->GetMemorySize();
-      return builder.CreateLoad(mem_size, "mem_size");
+      llvm::LoadInst* size = builder.CreateLoad(mem_size, "mem_size");
+      size->setMetadata(llvm::LLVMContext::MD_tbaa, module->GetMemorySizeTBAA());
+      return size;
     }
 };
 
@@ -245,9 +351,30 @@ class MemoryGrow : public Expression {
     Expression* expr_;
 
   public:
-    MemoryGrow(Expression* expr) : expr_(expr) {
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_MEMORY_GROW;
+    }
+
+    MemoryGrow(Expression* expr) : Expression(EXPR_MEMORY_GROW), expr_(expr) {
     }
 
+    Expression* GetExpression() const {
+      return expr_;
+    }
+
+    virtual bool ForEachChild(ChildFunction fct, void* data) const {
+      return CallOnChild(expr_, fct, data);
+    }
+
+    virtual void ReplaceChild(Expression* old_child, Expression* new_child) {
+      assert(expr_ == old_child);
+      expr_ = new_child;
+    }
+
+    virtual void ResolveNames(NameResolver& resolver);
+
+    virtual void Serialize(AstWriter& writer) const;
+
     virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 };
 
@@ -16,10 +16,14 @@
 #include <string>
 #include <iostream>
 #include <list>
+#include <set>
+#include <sstream>
+#include <string.h>
 
 #include "debug.h"
 #include "function.h"
 #include "globals.h"
+#include "memory.h"
 #include "module.h"
 #include "wasm_file.h"
 #include "utility.h"
@@ -27,6 +31,11 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/MC/SubtargetFeature.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/TargetRegistry.h"
 
 llvm::Function* WasmModule::GetOrCreateIntrinsic(llvm::Intrinsic::ID id, ETYPE type) {
   llvm::Module* module = file_->GetIntrinsicModule();
@@ -89,11 +98,162 @@ llvm::Function* WasmModule::GetWasmAssertTrapFunction() {
   return fct;
 }
 
+static llvm::TargetMachine* CreateHostTargetMachine() {
+  llvm::InitializeNativeTarget();
+
+  std::string triple = llvm::sys::getProcessTriple();
+  std::string error;
+  const llvm::Target* target = llvm::TargetRegistry::lookupTarget(triple, error);
+
+  if (target == nullptr) {
+    BISON_PRINT("No target for %s: %s\n", triple.c_str(), error.c_str());
+    return nullptr;
+  }
+
+  // The output is compiled by llc on the same machine: use everything it has.
+  llvm::SubtargetFeatures features;
+  llvm::StringMap<bool> host_features;
+
+  if (llvm::sys::getHostCPUFeatures(host_features) == true) {
+    for (auto& feature : host_features) {
+      features.AddFeature(feature.first(), feature.second);
+    }
+  }
+
+  return target->createTargetMachine(triple, llvm::sys::getHostCPUName(), features.getString(), llvm::TargetOptions());
+}
+
+static llvm::TargetMachine* GetHostTargetMachine() {
+  // Shared by all the modules.
+  static llvm::TargetMachine* target_machine = CreateHostTargetMachine();
+  return target_machine;
+}
+
+static bool HostHasMxcsr() {
+  llvm::TargetMachine* target_machine = GetHostTargetMachine();
+
+  if (target_machine == nullptr) {
+    return false;
+  }
+
+  llvm::Triple::ArchType arch = target_machine->getTargetTriple().getArch();
+  return arch == llvm::Triple::x86 || arch == llvm::Triple::x86_64;
+}
+
+// The flush to zero (FTZ) and denormals are zero (DAZ) bits of MXCSR.
+static const uint32_t kMxcsrFlushDenormals = 0x8040;
+
+llvm::Value* WasmModule::GenerateFlushDenormals(llvm::IRBuilder<>& builder) {
+  if (HostHasMxcsr() == false) {
+    return nullptr;
+  }
+
+  // MXCSR is only read and written through memory.
+  llvm::Type* i32 = llvm::Type::getInt32Ty(llvm::getGlobalContext());
+  llvm::Value* slot = builder.CreateAlloca(i32, nullptr, "mxcsr");
+  llvm::Value* slot_ptr = builder.CreateBitCast(slot, llvm::Type::getInt8PtrTy(llvm::getGlobalContext()));
+
+  builder.CreateCall(llvm::Intrinsic::getDeclaration(module_, llvm::Intrinsic::x86_sse_stmxcsr), slot_ptr);
+  llvm::Value* old_mxcsr = builder.CreateLoad(slot, "old_mxcsr");
+
+  builder.CreateStore(builder.CreateOr(old_mxcsr, kMxcsrFlushDenormals), slot);
+  builder.CreateCall(llvm::Intrinsic::getDeclaration(module_, llvm::Intrinsic::x86_sse_ldmxcsr), slot_ptr);
+
+  return old_mxcsr;
+}
+
+void WasmModule::GenerateRestoreDenormals(llvm::Value* mxcsr, llvm::IRBuilder<>& builder) {
+  if (mxcsr == nullptr) {
+    return;
+  }
+
+  llvm::Value* slot = builder.CreateAlloca(mxcsr->getType(), nullptr, "mxcsr");
+  builder.CreateStore(mxcsr, slot);
+
+  llvm::Value* slot_ptr = builder.CreateBitCast(slot, llvm::Type::getInt8PtrTy(llvm::getGlobalContext()));
+  builder.CreateCall(llvm::Intrinsic::getDeclaration(module_, llvm::Intrinsic::x86_sse_ldmxcsr), slot_ptr);
+}
+
+static void SplitNames(const char* list, std::set<std::string>& names) {
+  if (list != nullptr) {
+    std::istringstream iss(list);
+    std::string name;
+
+    while (std::getline(iss, name, ',')) {
+      names.insert(name);
+    }
+  }
+}
+
 void WasmModule::Generate() {
+  // Only the exports are called from outside of the module.
+  std::set<WasmFunction*> exported;
+
+  // Some of them might have their loops vectorized whatever the cost.
+  std::set<std::string> forced;
+  SplitNames(Globals::Get()->GetVectorizeList(), forced);
+
+  // Relaxed floating point is asked for the whole module or for some of its exports.
+  std::set<std::string> fast_math;
+  const char* fast_math_list = Globals::Get()->GetFastMathList();
+  SplitNames(fast_math_list, fast_math);
+
+  bool module_fast_math = Globals::Get()->GetFastMath() == true &&
+                          (fast_math_list == nullptr || fast_math.find(name_) != fast_math.end());
+
+  for (auto elem : exports_) {
+    WasmFunction* fct = GetExportedFunction(elem);
+    exported.insert(fct);
+
+    if (forced.find(elem->GetName()) != forced.end()) {
+      fct->SetForceVectorize(true);
+    }
+
+    if (fast_math.find(elem->GetName()) != fast_math.end()) {
+      fct->SetFastMath(true);
+    }
+  }
+
+  if (module_fast_math == true) {
+    for (auto it : functions_) {
+      it->SetFastMath(true);
+    }
+  }
+
+  // Denormals are flushed for whole modules: their functions only run under the exports.
+  std::set<std::string> flushing;
+  const char* flushing_list = Globals::Get()->GetFlushDenormalsList();
+  SplitNames(flushing_list, flushing);
+
+  flush_denormals_ = Globals::Get()->GetFlushDenormals() == true &&
+                     (flushing_list == nullptr || flushing.find(name_) != flushing.end());
+
+  // The MXCSR switch is the only way to get there: LLVM 3.7 has no denormal function attribute.
+  if (flush_denormals_ == true && HostHasMxcsr() == false) {
+    BISON_PRINT("Cannot flush the denormals of %s: the host has no MXCSR\n", name_.c_str());
+  }
+
+  // Set the linkage before generating any call: a call uses the calling convention of its callee.
+  for (auto it : functions_) {
+    WasmFunction& fct = *it;
+
+    // Unreachable functions stay declarations: they cannot be internal.
+    if (fct.IsBodyAvailable() == false) {
+      continue;
+    }
+
+    fct.GenerateLinkage(exported.find(it) != exported.end());
+  }
+
   // For each function, go from here to LLVM.
   for (auto it : functions_) {
     WasmFunction& fct = *it;
 
+    // Unreachable functions never had their body parsed: they stay declarations.
+    if (fct.IsBodyAvailable() == false) {
+      continue;
+    }
+
     fct.Generate();
 
     if (Globals::Get()->GetDisableVerificationOptimization() == false) {
@@ -104,14 +264,16 @@ void WasmModule::Generate() {
     }
   }
 
+  if (debug_builder_ != nullptr) {
+    debug_builder_->finalize();
+  }
+
   if (Globals::Get()->GetDisableVerificationOptimization() == false) {
     // Run the optimizations.
     fpm_->run(*module_);
 
-    for (auto it : functions_) {
-      WasmFunction& fct = *it;
-      assert((llvm::verifyFunction(*fct.GetFunction(), &llvm::outs()) == false));
-    }
+    // They can remove the internal functions once inlined: check the whole module.
+    assert((llvm::verifyModule(*module_, &llvm::outs()) == false));
   }
 
   // Handle now the exports.
@@ -119,22 +281,7 @@ void WasmModule::Generate() {
 
   for (auto elem : exports_) {
     const std::string& name = elem->GetName();
-    Variable* var = elem->GetVariable();
-
-    WasmFunction* fct = nullptr;
-    if (var->IsString()) {
-      fct = GetWasmFunction(var->GetString(), false);
-    } else {
-      size_t idx = var->GetIdx();
-      assert(idx < vector_functions_.size());
-      fct = vector_functions_[idx];
-    }
-
-    if (fct == nullptr) {
-      BISON_PRINT("Handling Export: Could not find %s\n", var->GetString());
-    }
-    assert(fct != nullptr);
-    exported_functions[name] = fct;
+    exported_functions[name] = GetExportedFunction(elem);
   }
 
   // Clear the old map and the vector functions.
@@ -147,10 +294,43 @@ void WasmModule::Generate() {
   map_functions_ = exported_functions;
 }
 
+WasmFunction* WasmModule::GetExportedFunction(WasmExport* exp) const {
+  Variable* var = exp->GetVariable();
+
+  WasmFunction* fct = nullptr;
+  if (var->IsString()) {
+    fct = GetWasmFunction(var->GetString(), false);
+  } else {
+    size_t idx = var->GetIdx();
+    assert(idx < vector_functions_.size());
+    fct = vector_functions_[idx];
+  }
+
+  if (fct == nullptr) {
+    BISON_PRINT("Handling Export: Could not find %s\n", var->GetString());
+  }
+  assert(fct != nullptr);
+
+  return fct;
+}
+
+void WasmModule::GetExportedFunctions(std::vector<WasmFunction*>& fcts) const {
+  for (auto elem : exports_) {
+    fcts.push_back(GetExportedFunction(elem));
+  }
+}
+
 void WasmModule::Initialize() {
   // Make the module, which holds all the code.
   module_ = new llvm::Module(name_.c_str(), llvm::getGlobalContext());
 
+  target_machine_ = GetHostTargetMachine();
+
+  if (target_machine_ != nullptr) {
+    module_->setTargetTriple(target_machine_->getTargetTriple().str());
+    module_->setDataLayout(*target_machine_->getDataLayout());
+  }
+
   for (auto it : functions_) {
     map_functions_[it->GetName()] = it;
     vector_functions_.push_back(it);
@@ -161,22 +341,59 @@ void WasmModule::Initialize() {
     vector_import_functions_.push_back(it);
   }
 
+  // The remarks are keyed by the lines of the .wast file.
+  if (Globals::Get()->GetRemarksFile() != nullptr) {
+    GenerateDebugInfo();
+  }
+
   // Create a new pass manager attached to it.
   fpm_ = new legacy::PassManager();
 
+  // Without the costs of the target, the vectorizers assume there are no vector registers.
+  if (target_machine_ != nullptr) {
+    fpm_->add(llvm::createTargetTransformInfoWrapperPass(target_machine_->getTargetIRAnalysis()));
+  }
+
   llvm::PassManagerBuilder pmb;
   pmb.OptLevel = 3;
+  pmb.LoopVectorize = true;
+  pmb.SLPVectorize = true;
   pmb.populateModulePassManager(*fpm_);
 
-  // Now generate the memory base.
-  GenerateMemoryBasedCode();
-
   // Generate the prototypes.
   for (auto it : functions_) {
     it->GeneratePrototype(this);
   }
 }
 
+void WasmModule::GenerateDebugInfo() {
+  const char* file_name = Globals::Get()->GetInputFileName();
+
+  if (file_name == nullptr) {
+    file_name = name_.c_str();
+  }
+
+  // Line tables are enough to map the instructions back to the expressions.
+  debug_builder_ = new llvm::DIBuilder(*module_);
+  debug_builder_->createCompileUnit(llvm::dwarf::DW_LANG_C, file_name, ".", "llvm_wasm", true, "", 0,
+                                    llvm::StringRef(), llvm::DIBuilder::LineTablesOnly);
+  debug_file_ = debug_builder_->createFile(file_name, ".");
+
+  module_->addModuleFlag(llvm::Module::Warning, "Debug Info Version", llvm::DEBUG_METADATA_VERSION);
+}
+
+llvm::DISubprogram* WasmModule::CreateSubprogram(llvm::Function* fct, const std::string& name, int line) {
+  if (debug_builder_ == nullptr) {
+    return nullptr;
+  }
+
+  llvm::DISubroutineType* type = debug_builder_->createSubroutineType(debug_file_, debug_builder_->getOrCreateTypeArray(llvm::None));
+
+  return debug_builder_->createFunction(debug_file_, name, fct->getName(), debug_file_, line, type,
+                                        fct->hasInternalLinkage(), true, line,
+                                        llvm::DINode::FlagPrototyped, true, fct);
+}
+
 std::string WasmModule::GetMemoryBaseFunctionName() const {
   std::ostringstream oss;
   oss << "set_" << name_ << "_memory_base";
@@ -225,9 +442,104 @@ void WasmModule::GenerateMemoryGlobals() {
   );
 }
 
+void WasmModule::GenerateTBAA() {
+  llvm::MDBuilder builder(llvm::getGlobalContext());
+
+  // Siblings under one root: the stores to the memory do not clobber the base and size globals.
+  llvm::MDNode* root = builder.createTBAARoot("wasm TBAA");
+  llvm::MDNode* memory = builder.createTBAAScalarTypeNode("linear memory", root);
+  llvm::MDNode* base = builder.createTBAAScalarTypeNode("memory base", root);
+  llvm::MDNode* size = builder.createTBAAScalarTypeNode("memory size", root);
+
+  tbaa_memory_ = builder.createTBAAStructTagNode(memory, memory, 0);
+  tbaa_base_ = builder.createTBAAStructTagNode(base, base, 0);
+  tbaa_size_ = builder.createTBAAStructTagNode(size, size, 0);
+}
+
+bool WasmModule::CanUseStaticMemory() const {
+  if (Globals::Get()->GetStaticMemory() == false || memory_ == -1) {
+    return false;
+  }
+
+  // Only the functions with a body are generated: the others cannot grow the memory.
+  for (auto fct : functions_) {
+    if (fct->IsBodyAvailable() == true) {
+      bool grows = (fct->Walk([](Expression* expr) {
+        return llvm::isa<MemoryGrow>(expr) == false;
+      }) == false);
+
+      if (grows == true) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+void WasmModule::GenerateStaticMemory() {
+  // The segments are the initializer: their bytes up to the end of the last one, then zeros.
+  std::vector<uint8_t> data;
+
+  if (segments_ != nullptr) {
+    for (auto segment : *segments_) {
+      size_t start = segment->GetStart();
+      size_t length = segment->GetLength();
+
+      assert(start + length <= static_cast<size_t>(memory_));
+
+      if (data.size() < start + length) {
+        data.resize(start + length, 0);
+      }
+
+      if (length > 0) {
+        memcpy(&data[start], segment->GetData(), length);
+      }
+    }
+  }
+
+  std::vector<llvm::Constant*> parts;
+
+  if (data.empty() == false) {
+    parts.push_back(llvm::ConstantDataArray::get(llvm::getGlobalContext(), data));
+  }
+
+  if (data.size() < static_cast<size_t>(memory_)) {
+    llvm::Type* char_type = llvm::Type::getInt8Ty(llvm::getGlobalContext());
+    llvm::ArrayType* zeros_type = llvm::ArrayType::get(char_type, memory_ - data.size());
+    parts.push_back(llvm::ConstantAggregateZero::get(zeros_type));
+  }
+
+  llvm::Constant* init = llvm::ConstantStruct::getAnon(llvm::getGlobalContext(), parts, true);
+
+  // Only this module's functions see it.
+  llvm::GlobalVariable* memory = new llvm::GlobalVariable(
+    *module_,
+    init->getType(),
+    false,
+    llvm::GlobalValue::InternalLinkage,
+    init,
+    name_ + "_memory"
+  );
+
+  // Like malloc: the natural alignment of the accesses holds from the base.
+  memory->setAlignment(16);
+
+  static_memory_base_ = llvm::ConstantExpr::getBitCast(memory, llvm::Type::getInt8PtrTy(llvm::getGlobalContext()));
+}
+
 void WasmModule::GenerateMemoryBasedCode() {
-  GenerateMemoryGlobals();
-  GenerateMemoryBaseFunction();
+  GenerateTBAA();
+
+  // Without growth, no allocation and no base to load: the segments are copied at compile time.
+  static_memory_ = CanUseStaticMemory();
+
+  if (static_memory_ == true) {
+    GenerateStaticMemory();
+  } else {
+    GenerateMemoryGlobals();
+    GenerateMemoryBaseFunction();
+  }
 }
 
 
@@ -265,8 +577,11 @@ void WasmModule::GenerateMemoryBaseFunction() {
 }
 
 void WasmModule::UpdateMemoryInformation(llvm::Value* base, llvm::Value* size, llvm::IRBuilder<>& builder) const {
-  builder.CreateStore(base, memory_pointer_, false);
-  builder.CreateStore(size, memory_size_, false);
+  llvm::StoreInst* store = builder.CreateStore(base, memory_pointer_, false);
+  store->setMetadata(llvm::LLVMContext::MD_tbaa, tbaa_base_);
+
+  store = builder.CreateStore(size, memory_size_, false);
+  store->setMetadata(llvm::LLVMContext::MD_tbaa, tbaa_size_);
 }
 
 void WasmModule::HandleSegments(llvm::IRBuilder<>& builder, llvm::Instruction* malloc_result) {
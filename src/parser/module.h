@@ -18,6 +18,7 @@
 
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Analysis/Passes.h"
+#include "llvm/IR/DIBuilder.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
@@ -27,10 +28,12 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/Scalar.h"
 
 #include "export.h"
 
+#include <atomic>
 #include <list>
 #include <map>
 #include <vector>
@@ -53,6 +56,13 @@ class WasmModule {
     llvm::legacy::PassManager* fpm_;
     WasmFile* file_;
 
+    // The host: the vectorizers need its costs, nullptr if LLVM does not know it.
+    llvm::TargetMachine* target_machine_;
+
+    // Line tables for the .wast file, only built for the remarks.
+    llvm::DIBuilder* debug_builder_;
+    llvm::DIFile* debug_file_;
+
     // Created during building.
     std::list<WasmFunction*> functions_;
     std::list<WasmExport*> exports_;
@@ -83,30 +93,53 @@ class WasmModule {
     llvm::Function* memory_allocator_fct_;
     llvm::Function* realloc_fct_;
 
+    // Set by --flush-denormals: the module computes with FTZ and DAZ.
+    bool flush_denormals_;
+
+    // A memory that never grows is a global array: its address is the base.
+    bool static_memory_;
+    llvm::Constant* static_memory_base_;
+
+    // TBAA tags: accesses to the linear memory, its base, and its size never alias each other.
+    llvm::MDNode* tbaa_memory_;
+    llvm::MDNode* tbaa_base_;
+    llvm::MDNode* tbaa_size_;
+
     int line_;
 
     WasmFunction* InternalGetWasmFunction(const char* name, bool check_file, unsigned int line) const;
     void GenerateMemoryGlobals();
+    void GenerateTBAA();
     void GenerateMemoryBaseFunction();
     void HandleSegments(llvm::IRBuilder<>& builder, llvm::Instruction* malloc_result);
-    void GenerateMemoryBasedCode();
+    bool CanUseStaticMemory() const;
+    void GenerateStaticMemory();
+    void GenerateDebugInfo();
 
   public:
     WasmModule(llvm::Module* module = nullptr, llvm::legacy::PassManager* fpm = nullptr, WasmFile* file = nullptr) :
-      module_(module), fpm_(fpm), file_(file),
+      module_(module), fpm_(fpm), file_(file), target_machine_(nullptr),
+      debug_builder_(nullptr), debug_file_(nullptr),
       memory_(-1), max_memory_(~0), segments_(nullptr),
       memory_pointer_(nullptr), memory_size_(nullptr),
       memory_allocator_fct_(nullptr), realloc_fct_(nullptr),
+      flush_denormals_(false), static_memory_(false), static_memory_base_(nullptr),
+      tbaa_memory_(nullptr), tbaa_base_(nullptr), tbaa_size_(nullptr),
       line_(0) {
-        static int cnt = 0;
-        std::ostringstream oss;
-        oss << "wasm_module_" << cnt;
-        cnt++;
-        name_ = oss.str();
+        // Atomic: modules can be created by concurrent parsers.
+        static std::atomic<int> cnt(0);
+        SetId(cnt++);
+    }
+
+    // Only valid before Initialize: the names are used to create the llvm::Module.
+    void SetId(int id) {
+      std::ostringstream oss;
+      oss << "wasm_module_" << id;
+      name_ = oss.str();
 
-        std::ostringstream hash_oss;;
-        hash_oss << "wm_" << cnt << "_";
-        hash_name_ = hash_oss.str();
+      std::ostringstream hash_oss;
+      hash_oss << "wm_" << id + 1 << "_";
+      hash_name_ = hash_oss.str();
     }
 
     void SetLine(int line) {
@@ -117,6 +150,32 @@ class WasmModule {
       return line_;
     }
 
+    // Set by the type annotation pass: a module with an invalid function gets no code.
+    bool IsValid() const {
+      for (auto fct : functions_) {
+        if (fct->IsValid() == false) {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    // Give the anonymous functions their suffix in source order, starting at id: returns the next one.
+    int RenumberAnonymousFunctions(int id) {
+      // Functions are kept in reverse source order.
+      for (auto it = functions_.rbegin(); it != functions_.rend(); it++) {
+        WasmFunction* wf = *it;
+
+        if (wf->IsAnonymous() == true) {
+          wf->SetAnonymousId(id);
+          id++;
+        }
+      }
+
+      return id;
+    }
+
     void AddFunction(WasmFunction* wf) {
       functions_.push_front(wf);
     }
@@ -137,6 +196,18 @@ class WasmModule {
       return module_;
     }
 
+    llvm::TargetMachine* GetTargetMachine() const {
+      return target_machine_;
+    }
+
+    bool IsFlushingDenormals() const {
+      return flush_denormals_;
+    }
+
+    // MXCSR handling: the old value to restore, nullptr if the host has no MXCSR.
+    llvm::Value* GenerateFlushDenormals(llvm::IRBuilder<>& builder);
+    void GenerateRestoreDenormals(llvm::Value* mxcsr, llvm::IRBuilder<>& builder);
+
     void SetWasmFile(WasmFile* f) {
       file_ = f;
     }
@@ -181,6 +252,26 @@ class WasmModule {
       return memory_size_;
     }
 
+    bool IsMemoryStatic() const {
+      return static_memory_;
+    }
+
+    llvm::Constant* GetStaticMemoryBase() const {
+      return static_memory_base_;
+    }
+
+    llvm::MDNode* GetMemoryTBAA() const {
+      return tbaa_memory_;
+    }
+
+    llvm::MDNode* GetBaseMemoryTBAA() const {
+      return tbaa_base_;
+    }
+
+    llvm::MDNode* GetMemorySizeTBAA() const {
+      return tbaa_size_;
+    }
+
     const std::string& GetHashName() const {
       return hash_name_;
     }
@@ -189,15 +280,40 @@ class WasmModule {
       return functions_;
     }
 
+    const std::list<WasmExport*>& GetExports() const {
+      return exports_;
+    }
+
+    const std::list<WasmImportFunction*>& GetImportFunctions() const {
+      return import_functions_;
+    }
+
+    std::list<Segment*>* GetSegments() const {
+      return segments_;
+    }
+
+    uint64_t GetMaxMemory() const {
+      return max_memory_;
+    }
+
     llvm::Function* GetReallocFunction();
+
+    // nullptr without debug information.
+    llvm::DISubprogram* CreateSubprogram(llvm::Function* fct, const std::string& name, int line);
     std::string GetMemoryBaseFunctionName() const;
     std::string GetMemoryBaseName() const;
     std::string GetMemorySizeName() const;
 
+    WasmFunction* GetExportedFunction(WasmExport* exp) const;
+    void GetExportedFunctions(std::vector<WasmFunction*>& fcts) const;
+
     void Generate();
     void Dump();
     void Initialize();
 
+    // Once the reachable bodies are parsed: they say if the memory can be static.
+    void GenerateMemoryBasedCode();
+
     WasmFunction* GetWasmFunction(const char* name, bool check_file = true, unsigned int line = ~0) const;
     WasmFunction* GetWasmFunction(const std::string& name, bool check_file = true, unsigned int line = ~0) const;
     WasmFunction* GetWasmFunction(size_t idx) const;
@@ -0,0 +1,257 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "binop.h"
+#include "expression.h"
+#include "function.h"
+#include "memory.h"
+#include "module.h"
+#include "name_resolver.h"
+#include "switch_expression.h"
+
+NameResolver::NameResolver(WasmFunction* fct) : fct_(fct) {
+  // The locals are indexed in the same order as the function defines them:
+  //   first the exploded parameters, then the locals.
+  size_t idx = 0;
+  SymbolTable* table = SymbolTable::Get();
+
+  for (auto pf : fct->GetParams()) {
+    for (auto elem : pf->GetLocal()->GetList()) {
+      if (elem->GetName() != nullptr) {
+        locals_[table->Intern(elem->GetName())] = idx;
+      }
+      idx++;
+    }
+  }
+
+  for (auto local : fct->GetLocals()) {
+    for (auto elem : local->GetList()) {
+      if (elem->GetName() != nullptr) {
+        locals_[table->Intern(elem->GetName())] = idx;
+      }
+      idx++;
+    }
+  }
+}
+
+void NameResolver::PushLabel(Variable* var) {
+  if (var != nullptr && var->IsString()) {
+    labels_.push_back(var->GetSymbol());
+  } else {
+    labels_.push_back(SymbolTable::kNoSymbol);
+  }
+}
+
+void NameResolver::PushLabel(const char* name) {
+  if (name != nullptr) {
+    labels_.push_back(SymbolTable::Get()->Intern(name));
+  } else {
+    labels_.push_back(SymbolTable::kNoSymbol);
+  }
+}
+
+void NameResolver::ResolveLocal(Variable* var) const {
+  if (var == nullptr || var->IsString() == false) {
+    return;
+  }
+
+  auto it = locals_.find(var->GetSymbol());
+
+  // If not found, leave it be: the code generation will complain about it.
+  if (it != locals_.end()) {
+    var->Resolve(it->second);
+  }
+}
+
+void NameResolver::ResolveLabel(Variable* var) const {
+  if (var == nullptr || var->IsString() == false) {
+    return;
+  }
+
+  // Find the innermost label with that name, the index is the distance from the top.
+  Symbol symbol = var->GetSymbol();
+  size_t size = labels_.size();
+
+  for (size_t i = 0; i < size; i++) {
+    if (labels_[size - 1 - i] == symbol) {
+      var->Resolve(i);
+      return;
+    }
+  }
+}
+
+// Expression resolution methods: the children are handled in the same order as the code generation
+//   and the labels are pushed and popped at the same moments.
+void Unop::ResolveNames(NameResolver& resolver) {
+  only_->ResolveNames(resolver);
+}
+
+void Binop::ResolveNames(NameResolver& resolver) {
+  left_->ResolveNames(resolver);
+  right_->ResolveNames(resolver);
+}
+
+void GetLocal::ResolveNames(NameResolver& resolver) {
+  resolver.ResolveLocal(var_);
+}
+
+void SetLocal::ResolveNames(NameResolver& resolver) {
+  resolver.ResolveLocal(var_);
+  value_->ResolveNames(resolver);
+}
+
+void IfExpression::ResolveNames(NameResolver& resolver) {
+  cond_->ResolveNames(resolver);
+  true_cond_->ResolveNames(resolver);
+
+  if (false_cond_ != nullptr) {
+    false_cond_->ResolveNames(resolver);
+  }
+}
+
+void CallExpression::ResolveParams(NameResolver& resolver) {
+  if (params_ != nullptr) {
+    for (auto elem : *params_) {
+      elem->ResolveNames(resolver);
+    }
+  }
+}
+
+void CallExpression::ResolveNames(NameResolver& resolver) {
+  ResolveParams(resolver);
+
+  // Remember the callee, the lookup goes through the module and potentially the file.
+  callee_ = FindCallee(resolver.GetFunction());
+}
+
+void CallImportExpression::ResolveNames(NameResolver& resolver) {
+  ResolveParams(resolver);
+
+  import_ = FindImport(resolver.GetFunction());
+}
+
+void ReturnExpression::ResolveNames(NameResolver& resolver) {
+  result_->ResolveNames(resolver);
+}
+
+void LoopExpression::ResolveNames(NameResolver& resolver) {
+  // Same order as the code generation: exit label first, then the loop label.
+  resolver.PushLabel(exit_name_);
+  resolver.PushLabel(var_);
+
+  for (auto expr : *loop_) {
+    expr->ResolveNames(resolver);
+  }
+
+  resolver.PopLabel();
+  resolver.PopLabel();
+}
+
+void LabelExpression::ResolveNames(NameResolver& resolver) {
+  resolver.PushLabel(var_);
+
+  expr_->ResolveNames(resolver);
+
+  resolver.PopLabel();
+}
+
+void BreakExpression::ResolveNames(NameResolver& resolver) {
+  resolver.ResolveLabel(var_);
+
+  if (expr_ != nullptr) {
+    expr_->ResolveNames(resolver);
+  }
+}
+
+void BreakIfExpression::ResolveNames(NameResolver& resolver) {
+  resolver.ResolveLabel(var_);
+
+  if (expr_ != nullptr) {
+    expr_->ResolveNames(resolver);
+  }
+
+  if (cond_ != nullptr) {
+    cond_->ResolveNames(resolver);
+  }
+}
+
+void BlockExpression::ResolveNames(NameResolver& resolver) {
+  resolver.PushLabel(name_);
+
+  for (auto expr : *list_) {
+    expr->ResolveNames(resolver);
+  }
+
+  resolver.PopLabel();
+}
+
+void SelectExpression::ResolveNames(NameResolver& resolver) {
+  cond_->ResolveNames(resolver);
+  first_->ResolveNames(resolver);
+  second_->ResolveNames(resolver);
+}
+
+void MemoryExpression::ResolveNames(NameResolver& resolver) {
+  if (address_ != nullptr) {
+    address_->ResolveNames(resolver);
+  }
+}
+
+void Store::ResolveNames(NameResolver& resolver) {
+  MemoryExpression::ResolveNames(resolver);
+
+  if (value_ != nullptr) {
+    value_->ResolveNames(resolver);
+  }
+}
+
+void MemoryGrow::ResolveNames(NameResolver& resolver) {
+  expr_->ResolveNames(resolver);
+}
+
+void CaseExpression::ResolveNames(NameResolver& resolver) {
+  for (auto expr : *list_) {
+    expr->ResolveNames(resolver);
+  }
+}
+
+void SwitchExpression::ResolveNames(NameResolver& resolver) {
+  // The cases, the table expressions, and the default are generated under the switch label.
+  resolver.PushLabel(name_);
+
+  for (auto elem : *cases_) {
+    elem->ResolveNames(resolver);
+  }
+
+  for (auto elem : *index_table_) {
+    ExpressionCaseDefinition* expr = llvm::dyn_cast_or_null<ExpressionCaseDefinition>(elem);
+
+    if (expr != nullptr) {
+      expr->GetExpression()->ResolveNames(resolver);
+    }
+  }
+
+  ExpressionCaseDefinition* default_expr = llvm::dyn_cast_or_null<ExpressionCaseDefinition>(default_);
+
+  if (default_expr != nullptr) {
+    default_expr->GetExpression()->ResolveNames(resolver);
+  }
+
+  resolver.PopLabel();
+
+  // The selector is generated once the label is popped.
+  selector_->ResolveNames(resolver);
+}
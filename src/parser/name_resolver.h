@@ -0,0 +1,61 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#ifndef H_NAME_RESOLVER
+#define H_NAME_RESOLVER
+
+#include <unordered_map>
+#include <vector>
+
+#include "symbol_table.h"
+
+// Forward declarations.
+class Variable;
+class WasmFunction;
+
+/**
+ * The name resolver rewrites the named references of a function body into indices:
+ *   - Local names become the index of the local in the function's SSA builder,
+ *   - Label names become the distance from the top of the label stack.
+ *
+ * The label stack is maintained as the expressions are traversed and must mirror
+ *   what the code generation pushes and pops.
+ */
+class NameResolver {
+  protected:
+    WasmFunction* fct_;
+
+    std::unordered_map<Symbol, size_t> locals_;
+    std::vector<Symbol> labels_;
+
+  public:
+    NameResolver(WasmFunction* fct);
+
+    WasmFunction* GetFunction() const {
+      return fct_;
+    }
+
+    void PushLabel(Variable* var);
+    void PushLabel(const char* name);
+
+    void PopLabel() {
+      labels_.pop_back();
+    }
+
+    void ResolveLocal(Variable* var) const;
+    void ResolveLabel(Variable* var) const;
+};
+
+#endif
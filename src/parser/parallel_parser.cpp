@@ -0,0 +1,185 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <algorithm>
+#include <thread>
+
+#include "debug.h"
+#include "parallel_parser.h"
+#include "parser_context.h"
+#include "wasm_file.h"
+
+bool ParallelParser::PreScan() {
+  // Find the top-level forms, skipping comments and strings so that their parentheses do not count.
+  size_t size = buffer_.size();
+  size_t start = 0;
+  int start_line = 0;
+  int line = 1;
+  int depth = 0;
+
+  for (size_t i = 0; i < size; i++) {
+    char c = buffer_[i];
+
+    switch (c) {
+      case '\n':
+        line++;
+        break;
+      case ';':
+        // Line comment: go to the end of the line, the newline itself is handled by the loop.
+        if (i + 1 < size && buffer_[i + 1] == ';') {
+          while (i + 1 < size && buffer_[i + 1] != '\n') {
+            i++;
+          }
+        }
+        break;
+      case '"':
+        // Skip the string, an escaped character is skipped with its backslash.
+        for (i++; i < size && buffer_[i] != '"'; i++) {
+          if (buffer_[i] == '\\') {
+            i++;
+          }
+
+          if (i < size && buffer_[i] == '\n') {
+            line++;
+          }
+        }
+
+        if (i >= size) {
+          return false;
+        }
+        break;
+      case '(': {
+        // Block comment.
+        if (i + 1 < size && buffer_[i + 1] == ';') {
+          size_t end = buffer_.find(";)", i + 2);
+
+          if (end == std::string::npos) {
+            return false;
+          }
+
+          line += std::count(buffer_.begin() + i, buffer_.begin() + end, '\n');
+          i = end + 1;
+          break;
+        }
+
+        if (depth == 0) {
+          start = i;
+          start_line = line;
+        }
+
+        depth++;
+        break;
+      }
+      case ')':
+        depth--;
+
+        if (depth < 0) {
+          return false;
+        }
+
+        if (depth == 0) {
+          forms_.push_back(TopLevelForm(start, i + 1, start_line));
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  return depth == 0;
+}
+
+void ParallelParser::SplitInChunks(std::vector<std::pair<size_t, size_t> >& chunks) const {
+  // Each chunk is a range of forms [first, last) of about the same number of characters.
+  size_t total = forms_.back().end_ - forms_.front().start_;
+  size_t target = total / jobs_ + 1;
+  size_t max = forms_.size();
+  size_t first = 0;
+
+  for (size_t i = 0; i < max; i++) {
+    size_t size = forms_[i].end_ - forms_[first].start_;
+
+    if (size >= target || i == max - 1) {
+      chunks.push_back(std::make_pair(first, i + 1));
+      first = i + 1;
+    }
+  }
+}
+
+WasmFile* ParallelParser::ParseChunk(size_t first, size_t last) const {
+  const TopLevelForm& first_form = forms_[first];
+  const TopLevelForm& last_form = forms_[last - 1];
+
+  // The context starts at the line of the first form: line numbers are the same as a full parse.
+  ParserContext context(file_name_, first_form.line_);
+
+  if (context.Parse(buffer_.c_str() + first_form.start_, last_form.end_ - first_form.start_) == false) {
+    return nullptr;
+  }
+
+  return context.GetWasmFile();
+}
+
+WasmFile* ParallelParser::Parse() {
+  // If the pre-scan fails or if there is not enough work, parse everything in one go:
+  //   errors will be reported as usual.
+  if (jobs_ < 2 || PreScan() == false || forms_.size() < 2) {
+    ParserContext context(file_name_);
+
+    if (context.Parse(buffer_.c_str(), buffer_.size()) == false) {
+      return nullptr;
+    }
+
+    return context.GetWasmFile();
+  }
+
+  std::vector<std::pair<size_t, size_t> > chunks;
+  SplitInChunks(chunks);
+
+  size_t nbr_chunks = chunks.size();
+  std::vector<WasmFile*> files(nbr_chunks, nullptr);
+  std::vector<std::thread> threads;
+
+  BISON_PRINT("Parsing %lu forms in %lu chunks\n", forms_.size(), nbr_chunks);
+
+  for (size_t i = 0; i < nbr_chunks; i++) {
+    threads.push_back(std::thread([this, &files, &chunks, i]() {
+      files[i] = ParseChunk(chunks[i].first, chunks[i].second);
+    }));
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (auto file : files) {
+    if (file == nullptr) {
+      return nullptr;
+    }
+  }
+
+  // Stitch everything back in source order.
+  WasmFile* result = files[0];
+
+  for (size_t i = 1; i < nbr_chunks; i++) {
+    result->Append(files[i]);
+  }
+
+  // The naming counters were incremented in whatever order the threads went: make it deterministic.
+  result->RenumberInSourceOrder();
+
+  return result;
+}
@@ -0,0 +1,65 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#ifndef H_PARALLEL_PARSER
+#define H_PARALLEL_PARSER
+
+#include <string>
+#include <vector>
+
+// Forward declaration.
+class WasmFile;
+
+// A top-level form of the input: module, assertion, or invoke.
+struct TopLevelForm {
+  size_t start_;
+  size_t end_;
+  int line_;
+
+  TopLevelForm(size_t start, size_t end, int line) :
+    start_(start), end_(end), line_(line) {
+  }
+};
+
+/**
+ * Parse an input using multiple threads: a pre-scan finds the top-level forms by
+ *   parenthesis matching, the forms are split in contiguous chunks, and each chunk is parsed
+ *   by its own reentrant parser. The chunk results are then stitched back into one WasmFile
+ *   in source order.
+ */
+class ParallelParser {
+  protected:
+    const char* file_name_;
+    int jobs_;
+
+    // The whole input, owned by the caller.
+    const std::string& buffer_;
+    std::vector<TopLevelForm> forms_;
+
+    bool PreScan();
+    void SplitInChunks(std::vector<std::pair<size_t, size_t> >& chunks) const;
+    WasmFile* ParseChunk(size_t first, size_t last) const;
+
+  public:
+    ParallelParser(const char* file_name, const std::string& buffer, int jobs) :
+      file_name_(file_name), jobs_(jobs), buffer_(buffer) {
+    }
+
+    // Returns nullptr if the parse failed.
+    WasmFile* Parse();
+};
+
+#endif
@@ -0,0 +1,131 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#ifndef H_PARSER_CONTEXT
+#define H_PARSER_CONTEXT
+
+#include <stdio.h>
+
+#include <list>
+
+// Forward declaration.
+class FunctionField;
+class WasmFile;
+
+/**
+ * Everything the lexer and the parser need for one input: each parse has its own context,
+ *   meaning multiple inputs can be parsed at the same time from different threads.
+ */
+class ParserContext {
+  protected:
+    // Name of the input, used for error reporting.
+    const char* file_name_;
+    int line_cnt_;
+
+    // Function bodies are kept as text by the lexer when lazy_bodies_ is set;
+    //   function_depth_ is the parenthesis depth inside the current function, -1 outside of one.
+    bool lazy_bodies_;
+    int function_depth_;
+
+    // A body parse starts with a token selecting the body rule of the grammar.
+    bool body_start_;
+
+    // Result of the parse.
+    WasmFile* file_;
+    std::list<FunctionField*>* body_fields_;
+
+  public:
+    ParserContext(const char* file_name = nullptr, int first_line = 1) :
+      file_name_(file_name), line_cnt_(first_line),
+      lazy_bodies_(true), function_depth_(-1), body_start_(false),
+      file_(nullptr), body_fields_(nullptr) {
+    }
+
+    const char* GetFileName() const {
+      return file_name_;
+    }
+
+    void IncrementLineCnt(int inc = 1) {
+      line_cnt_ += inc;
+    }
+
+    int GetLineCnt() const {
+      return line_cnt_;
+    }
+
+    void SetLazyBodies(bool lazy) {
+      lazy_bodies_ = lazy;
+    }
+
+    void EnterFunction() {
+      if (lazy_bodies_ == true) {
+        function_depth_ = 0;
+      }
+    }
+
+    // True if an opening parenthesis starts a field of the current function.
+    bool AtFunctionField() const {
+      return function_depth_ == 0;
+    }
+
+    void OpenParenthesis() {
+      if (function_depth_ >= 0) {
+        function_depth_++;
+      }
+    }
+
+    void CloseParenthesis() {
+      if (function_depth_ >= 0) {
+        function_depth_--;
+      }
+    }
+
+    bool TakeBodyStart() {
+      bool res = body_start_;
+      body_start_ = false;
+      return res;
+    }
+
+    void SetBodyFields(std::list<FunctionField*>* fields) {
+      body_fields_ = fields;
+    }
+
+    std::list<FunctionField*>* GetBodyFields() const {
+      return body_fields_;
+    }
+
+    void SetWasmFile(WasmFile* f) {
+      file_ = f;
+    }
+
+    WasmFile* GetWasmFile() const {
+      return file_;
+    }
+
+    // Parse methods: return true on success, the result is then available via GetWasmFile.
+    //   They are implemented in the lexer file since they need the scanner's internals.
+    bool Parse(FILE* input);
+    bool Parse(const char* buffer, size_t length);
+
+    // Parse the text of a LazyBodyField, the result is then available via GetBodyFields.
+    bool ParseBody(const char* buffer, size_t length) {
+      lazy_bodies_ = false;
+      body_start_ = true;
+      return Parse(buffer, length);
+    }
+};
+
+#endif
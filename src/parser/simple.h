@@ -17,6 +17,7 @@
 #define H_SIMPLE
 
 #include "debug.h"
+#include "symbol_table.h"
 #include "utility.h"
 
 /**
@@ -27,6 +28,7 @@ class Variable {
   protected:
     size_t idx_;
     char* s_;
+    Symbol symbol_;
 
     bool is_string_;
 
@@ -37,7 +39,7 @@ class Variable {
     }
 
   public:
-    Variable(int64_t t) {
+    Variable(int64_t t) : symbol_(SymbolTable::kNoSymbol) {
       idx_ = t;
       is_string_ = false;
 
@@ -48,11 +50,13 @@ class Variable {
 
     Variable(char* v) : idx_(0) {
       s_ = strdup(v);
+      symbol_ = SymbolTable::Get()->Intern(s_);
       is_string_ = true;
     }
 
     Variable(const char* v) : idx_(0) {
       s_ = strdup(v);
+      symbol_ = SymbolTable::Get()->Intern(s_);
       is_string_ = true;
     }
 
@@ -68,6 +72,17 @@ class Variable {
       return idx_;
     }
 
+    Symbol GetSymbol() const {
+      return symbol_;
+    }
+
+    // Name resolution found what the string refers to: from now on, use the index.
+    //   The string is kept for dumping and naming purposes.
+    void Resolve(size_t idx) {
+      idx_ = idx;
+      is_string_ = false;
+    }
+
     void Dump(int tabs = 0) const {
       BISON_TABBED_PRINT(tabs, "%s", s_);
     }
@@ -0,0 +1,184 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
+
+#include "ssa_builder.h"
+
+size_t SsaBuilder::AddLocal(const char* name, llvm::Type* type) {
+  size_t idx = types_.size();
+
+  types_.push_back(type);
+  names_.push_back(name != nullptr ? name : "local");
+
+  return idx;
+}
+
+llvm::Value*& SsaBuilder::GetDefinition(size_t idx, llvm::BasicBlock* bb) {
+  std::vector<llvm::Value*>& definitions = definitions_[bb];
+
+  if (definitions.size() < types_.size()) {
+    definitions.resize(types_.size(), nullptr);
+  }
+
+  return definitions[idx];
+}
+
+llvm::PHINode* SsaBuilder::CreatePhi(size_t idx, llvm::BasicBlock* bb) {
+  llvm::PHINode* phi = nullptr;
+
+  // At the top of the block, with the other phis.
+  if (bb->empty() == true) {
+    phi = llvm::PHINode::Create(types_[idx], 0, names_[idx], bb);
+  } else {
+    phi = llvm::PHINode::Create(types_[idx], 0, names_[idx], &bb->front());
+  }
+
+  phis_.insert(phi);
+  incomplete_phis_.push_back(std::make_pair(phi, idx));
+  return phi;
+}
+
+void SsaBuilder::Write(size_t idx, llvm::Value* value, llvm::BasicBlock* bb) {
+  // Code after a jump is dead: it must not change what the successors see.
+  if (bb->getTerminator() != nullptr) {
+    return;
+  }
+
+  GetDefinition(idx, bb) = value;
+}
+
+llvm::Value* SsaBuilder::Read(size_t idx, llvm::BasicBlock* bb) {
+  llvm::Value*& definition = GetDefinition(idx, bb);
+
+  // The block's predecessors are not all known yet: the phi is completed by Finalize.
+  if (definition == nullptr) {
+    definition = CreatePhi(idx, bb);
+  }
+
+  return definition;
+}
+
+llvm::Value* SsaBuilder::ReadAtEnd(size_t idx, llvm::BasicBlock* bb) {
+  // A single predecessor gives its value: walk up to a definition or a merge point.
+  std::vector<llvm::BasicBlock*> chain;
+  std::set<llvm::BasicBlock*> visited;
+  llvm::Value* value = nullptr;
+
+  while (value == nullptr) {
+    value = GetDefinition(idx, bb);
+
+    if (value != nullptr) {
+      break;
+    }
+
+    chain.push_back(bb);
+    visited.insert(bb);
+
+    llvm::BasicBlock* pred = bb->getSinglePredecessor();
+
+    // Merge points, unreachable blocks, and unreachable cycles of single predecessors get a phi.
+    if (pred == nullptr || visited.find(pred) != visited.end()) {
+      value = CreatePhi(idx, bb);
+    } else {
+      bb = pred;
+    }
+  }
+
+  // The blocks of the chain do not write the local: their value is the same.
+  for (auto elem : chain) {
+    GetDefinition(idx, elem) = value;
+  }
+
+  return value;
+}
+
+void SsaBuilder::RemoveTrivialPhis() {
+  std::vector<llvm::PHINode*> worklist(phis_.begin(), phis_.end());
+  std::set<llvm::PHINode*> removed;
+
+  while (worklist.empty() == false) {
+    llvm::PHINode* phi = worklist.back();
+    worklist.pop_back();
+
+    if (removed.find(phi) != removed.end()) {
+      continue;
+    }
+
+    // Trivial if it only merges itself and one other value.
+    llvm::Value* same = nullptr;
+    bool trivial = true;
+
+    for (unsigned i = 0; i < phi->getNumIncomingValues(); i++) {
+      llvm::Value* op = phi->getIncomingValue(i);
+
+      if (op == same || op == phi) {
+        continue;
+      }
+
+      if (same != nullptr) {
+        trivial = false;
+        break;
+      }
+
+      same = op;
+    }
+
+    if (trivial == false) {
+      continue;
+    }
+
+    // No value at all: the block is unreachable.
+    if (same == nullptr) {
+      same = llvm::UndefValue::get(phi->getType());
+    }
+
+    // The phis using this one might become trivial in turn.
+    for (auto user : phi->users()) {
+      llvm::PHINode* user_phi = llvm::dyn_cast<llvm::PHINode>(user);
+
+      if (user_phi != nullptr && user_phi != phi && phis_.find(user_phi) != phis_.end()) {
+        worklist.push_back(user_phi);
+      }
+    }
+
+    phi->replaceAllUsesWith(same);
+    phi->eraseFromParent();
+    removed.insert(phi);
+  }
+}
+
+void SsaBuilder::Finalize() {
+  // Filling a phi can create others in the predecessors: no iterator on the vector.
+  for (size_t i = 0; i < incomplete_phis_.size(); i++) {
+    llvm::PHINode* phi = incomplete_phis_[i].first;
+    size_t idx = incomplete_phis_[i].second;
+    llvm::BasicBlock* bb = phi->getParent();
+
+    // One entry per edge: a switch can have several to the same block.
+    for (auto it = llvm::pred_begin(bb); it != llvm::pred_end(bb); ++it) {
+      llvm::BasicBlock* pred = *it;
+      phi->addIncoming(ReadAtEnd(idx, pred), pred);
+    }
+  }
+
+  RemoveTrivialPhis();
+
+  incomplete_phis_.clear();
+  phis_.clear();
+  definitions_.clear();
+}
@@ -0,0 +1,73 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#ifndef H_SSA_BUILDER
+#define H_SSA_BUILDER
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Type.h"
+#include "llvm/IR/Value.h"
+
+/**
+ * Puts the locals of a function in SSA form while its code is generated, after Braun et al.:
+ *   each block keeps the last value written to each local, a read without one gets a phi at the top
+ *   of its block. The predecessors of the blocks are only all known once the function is generated:
+ *   Finalize then fills the phis from the values at the end of the predecessors, following the
+ *   single predecessors without new phis, and removes the phis that merge a single value.
+ */
+class SsaBuilder {
+  protected:
+    std::vector<llvm::Type*> types_;
+    std::vector<std::string> names_;
+
+    // The current value of each local in each block, nullptr until the block reads or writes it.
+    std::map<llvm::BasicBlock*, std::vector<llvm::Value*> > definitions_;
+
+    // The phis waiting for their operands, with their local.
+    std::vector<std::pair<llvm::PHINode*, size_t> > incomplete_phis_;
+    std::set<llvm::PHINode*> phis_;
+
+    llvm::Value*& GetDefinition(size_t idx, llvm::BasicBlock* bb);
+    llvm::PHINode* CreatePhi(size_t idx, llvm::BasicBlock* bb);
+    llvm::Value* ReadAtEnd(size_t idx, llvm::BasicBlock* bb);
+    void RemoveTrivialPhis();
+
+  public:
+    // Locals are numbered in order, the name is optional: it only names the phis.
+    size_t AddLocal(const char* name, llvm::Type* type);
+
+    size_t GetNbrLocals() const {
+      return types_.size();
+    }
+
+    llvm::Type* GetType(size_t idx) const {
+      return types_[idx];
+    }
+
+    void Write(size_t idx, llvm::Value* value, llvm::BasicBlock* bb);
+    llvm::Value* Read(size_t idx, llvm::BasicBlock* bb);
+
+    // Once no branch is added anymore.
+    void Finalize();
+};
+
+#endif
@@ -34,7 +34,7 @@ llvm::Value* CaseExpression::Codegen(llvm::Value* last, SwitchExpression* switch
   llvm::BasicBlock* case_block = BasicBlock::Create(llvm::getGlobalContext(), s_name.c_str(), fct->GetFunction());
 
   if (is_first == false) {
-    if (last == nullptr || (dynamic_cast<TerminatorInst*>(last) == nullptr)) {
+    if (last == nullptr || llvm::isa<TerminatorInst>(last) == false) {
       builder.CreateBr(case_block);
     }
   }
@@ -47,7 +47,12 @@ llvm::Value* CaseExpression::Codegen(llvm::Value* last, SwitchExpression* switch
 
   llvm::Value* res = nullptr;
   for (auto expr : *list_) {
-    res = expr->Codegen(fct, builder);
+    res = expr->Generate(fct, builder);
+
+    // Like in a block, the rest would be generated after a terminator.
+    if (expr->IsTerminator() == true) {
+      break;
+    }
   }
 
   return res;
@@ -56,7 +61,7 @@ llvm::Value* CaseExpression::Codegen(llvm::Value* last, SwitchExpression* switch
 llvm::BasicBlock* SwitchExpression::HandleDefault(std::map<std::string, llvm::BasicBlock*>& association, WasmFunction* fct, llvm::IRBuilder<>& builder) const {
   // So the default block can be defined by a case node or an expression node.
 
-  VariableCaseDefinition* variable_def = dynamic_cast<VariableCaseDefinition*>(default_);
+  VariableCaseDefinition* variable_def = llvm::dyn_cast_or_null<VariableCaseDefinition>(default_);
 
   if (variable_def != nullptr) {
     // Then return the pointer from the association, it should have been created.
@@ -64,7 +69,7 @@ llvm::BasicBlock* SwitchExpression::HandleDefault(std::map<std::string, llvm::Ba
   }
 
   // Otherwise we have a ExpressionCaseDefinition.
-  ExpressionCaseDefinition* expr_case = dynamic_cast<ExpressionCaseDefinition*>(default_);
+  ExpressionCaseDefinition* expr_case = llvm::dyn_cast_or_null<ExpressionCaseDefinition>(default_);
   assert(expr_case != nullptr);
 
   Expression* expr = expr_case->GetExpression();
@@ -74,7 +79,7 @@ llvm::BasicBlock* SwitchExpression::HandleDefault(std::map<std::string, llvm::Ba
   builder.SetInsertPoint(default_code);
 
   // Now generate the code.
-  expr->Codegen(fct, builder);
+  expr->Generate(fct, builder);
 
   // Now return the block.
   return default_code;
@@ -128,7 +133,7 @@ llvm::Value* SwitchExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& bui
   llvm::BasicBlock* exit_block = BasicBlock::Create(llvm::getGlobalContext(), name, fct->GetFunction());
 
   // Push it.
-  fct->PushLabel(name, exit_block);
+  fct->PushLabel(exit_block);
   fct->RegisterNamedExpression(exit_block, this);
 
   // Start by generating the cases.
@@ -154,11 +159,11 @@ llvm::Value* SwitchExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& bui
     }
 
     // For the last case, we fall out the switch.
-    if (last_result == nullptr || (dynamic_cast<TerminatorInst*>(last_result) == nullptr)) {
+    if (last_result == nullptr || llvm::isa<TerminatorInst>(last_result) == false) {
       builder.CreateBr(exit_block);
 
       if (last_result != nullptr) {
-        AddIncomingPhi(last_result, builder.GetInsertBlock());
+        AddIncomingPhi(last_result, cases_->back()->GetValueType(), builder.GetInsertBlock());
       }
     }
   }
@@ -167,7 +172,7 @@ llvm::Value* SwitchExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& bui
   for (std::list<CaseDefinition*>::iterator index_it = index_table_->begin();
                                             index_it != index_table_->end();
                                             index_it++) {
-    ExpressionCaseDefinition* expr = dynamic_cast<ExpressionCaseDefinition*>(*index_it);
+    ExpressionCaseDefinition* expr = llvm::dyn_cast_or_null<ExpressionCaseDefinition>(*index_it);
 
     if (expr != nullptr) {
       // Ok we have this block to generate.
@@ -192,7 +197,7 @@ llvm::Value* SwitchExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& bui
   builder.SetInsertPoint(switch_block);
 
   // Create the switch.
-  llvm::Value* value = selector_->Codegen(fct, builder);
+  llvm::Value* value = selector_->Generate(fct, builder);
 
   SwitchInst* switch_inst = builder.CreateSwitch(value, default_block, cases_->size());
 
@@ -209,7 +214,7 @@ llvm::Value* SwitchExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& bui
         index_it++) {
       llvm::ConstantInt* case_value = llvm::ConstantInt::get(llvm::getGlobalContext(), APInt(32, i, false));
 
-      VariableCaseDefinition* var = dynamic_cast<VariableCaseDefinition*>(*index_it);
+      VariableCaseDefinition* var = llvm::dyn_cast_or_null<VariableCaseDefinition>(*index_it);
       assert(var != nullptr);
 
       llvm::BasicBlock* bb = association[var->GetString()];
@@ -245,6 +250,39 @@ llvm::Value* SwitchExpression::Codegen(WasmFunction* fct, llvm::IRBuilder<>& bui
   // Now set ourselves to the exit_block.
   builder.SetInsertPoint(exit_block);
 
-  llvm::Value* res = HandlePhiNodes(builder);
+  llvm::Value* res = HandlePhiNodes(value_type_, builder);
   return res;
 }
+
+void SwitchExpression::ReplaceChild(Expression* old_child, Expression* new_child) {
+  if (selector_ == old_child) {
+    selector_ = new_child;
+    return;
+  }
+
+  // Same order as GetChildren: the index table, the default, then the cases.
+  if (index_table_ != nullptr) {
+    for (auto elem : *index_table_) {
+      ExpressionCaseDefinition* ecd = llvm::dyn_cast_or_null<ExpressionCaseDefinition>(elem);
+
+      if (ecd != nullptr && ecd->GetExpression() == old_child) {
+        ecd->SetExpression(new_child);
+        return;
+      }
+    }
+  }
+
+  ExpressionCaseDefinition* default_expr = llvm::dyn_cast_or_null<ExpressionCaseDefinition>(default_);
+
+  if (default_expr != nullptr && default_expr->GetExpression() == old_child) {
+    default_expr->SetExpression(new_child);
+    return;
+  }
+
+  // A case can only be replaced by another case.
+  if (cases_ != nullptr) {
+    CaseExpression* old_case = llvm::cast<CaseExpression>(old_child);
+    CaseExpression* new_case = llvm::cast<CaseExpression>(new_child);
+    std::replace(cases_->begin(), cases_->end(), old_case, new_case);
+  }
+}
@@ -21,8 +21,25 @@
 
 #include "base_expression.h"
 
+// The concrete case definition classes, used by classof.
+enum CaseDefinitionKind {
+  CASE_DEFINITION_BASE,
+  CASE_DEFINITION_VARIABLE,
+  CASE_DEFINITION_EXPRESSION,
+};
+
 class CaseDefinition {
+  protected:
+    const CaseDefinitionKind kind_;
+
   public:
+    CaseDefinition(CaseDefinitionKind kind = CASE_DEFINITION_BASE) : kind_(kind) {
+    }
+
+    CaseDefinitionKind GetKind() const {
+      return kind_;
+    }
+
     virtual void Dump() {
     }
 };
@@ -32,7 +49,11 @@ class VariableCaseDefinition : public CaseDefinition {
     Variable* var_;
 
   public:
-    VariableCaseDefinition(Variable* var) : var_(var) {
+    static bool classof(const CaseDefinition* def) {
+      return def->GetKind() == CASE_DEFINITION_VARIABLE;
+    }
+
+    VariableCaseDefinition(Variable* var) : CaseDefinition(CASE_DEFINITION_VARIABLE), var_(var) {
     }
 
     virtual void Dump() {
@@ -41,6 +62,10 @@ class VariableCaseDefinition : public CaseDefinition {
     const char* GetString() const {
       return var_->GetString();
     }
+
+    Variable* GetVariable() const {
+      return var_;
+    }
 };
 
 class ExpressionCaseDefinition : public CaseDefinition {
@@ -48,15 +73,23 @@ class ExpressionCaseDefinition : public CaseDefinition {
     Expression* expr_;
 
   public:
+    static bool classof(const CaseDefinition* def) {
+      return def->GetKind() == CASE_DEFINITION_EXPRESSION;
+    }
+
     virtual void Dump() {
     }
 
-    ExpressionCaseDefinition(Expression* expr) : expr_(expr) {
+    ExpressionCaseDefinition(Expression* expr) : CaseDefinition(CASE_DEFINITION_EXPRESSION), expr_(expr) {
     }
 
     Expression* GetExpression() const {
       return expr_;
     }
+
+    void SetExpression(Expression* expr) {
+      expr_ = expr;
+    }
 };
 
 class CaseExpression : public Expression {
@@ -65,14 +98,34 @@ class CaseExpression : public Expression {
     std::list<Expression*>* list_;
 
   public:
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_CASE;
+    }
+
     CaseExpression(const char* id, std::list<Expression*>* list) :
-      id_(id), list_(list) {
+      Expression(EXPR_CASE), id_(id), list_(list) {
     }
 
     const char* GetIdentifier() const {
       return id_;
     }
 
+    std::list<Expression*>* GetList() const {
+      return list_;
+    }
+
+    virtual bool ForEachChild(ChildFunction fct, void* data) const {
+      return CallOnChildren(list_, fct, data);
+    }
+
+    virtual void ReplaceChild(Expression* old_child, Expression* new_child) {
+      ReplaceInList(list_, old_child, new_child);
+    }
+
+    virtual void ResolveNames(NameResolver& resolver);
+
+    virtual void Serialize(AstWriter& writer) const;
+
     llvm::Value* Codegen(llvm::Value* last, SwitchExpression* switch_expr, WasmFunction* fct, llvm::IRBuilder<>& builder, bool is_first);
 };
 
@@ -94,14 +147,56 @@ class SwitchExpression : public Expression, public NamedExpression {
                                      WasmFunction* fct, llvm::IRBuilder<>& builder);
 
   public:
+    static bool classof(const Expression* expr) {
+      return expr->GetKind() == EXPR_SWITCH;
+    }
+
     SwitchExpression(const char* name, Expression* selector,
                      std::list<CaseDefinition*>* index_table,
                      CaseDefinition* default_case,
                      std::list<CaseExpression*>* cases) :
-                     name_(name), selector_(selector), index_table_(index_table),
+                     Expression(EXPR_SWITCH), name_(name), selector_(selector), index_table_(index_table),
                      default_(default_case), cases_(cases) {
     }
 
+    Expression* GetSelector() const {
+      return selector_;
+    }
+
+    std::list<CaseExpression*>* GetCases() const {
+      return cases_;
+    }
+
+    virtual bool ForEachChild(ChildFunction fct, void* data) const {
+      if (CallOnChild(selector_, fct, data) == false) {
+        return false;
+      }
+
+      if (index_table_ != nullptr) {
+        for (auto elem : *index_table_) {
+          ExpressionCaseDefinition* ecd = llvm::dyn_cast_or_null<ExpressionCaseDefinition>(elem);
+
+          if (ecd != nullptr && fct(ecd->GetExpression(), data) == false) {
+            return false;
+          }
+        }
+      }
+
+      ExpressionCaseDefinition* default_expr = llvm::dyn_cast_or_null<ExpressionCaseDefinition>(default_);
+
+      if (default_expr != nullptr && fct(default_expr->GetExpression(), data) == false) {
+        return false;
+      }
+
+      return CallOnChildren(cases_, fct, data);
+    }
+
+    virtual void ReplaceChild(Expression* old_child, Expression* new_child);
+
+    virtual void ResolveNames(NameResolver& resolver);
+
+    virtual void Serialize(AstWriter& writer) const;
+
     virtual llvm::Value* Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder);
 
     void RegisterGeneratedCase(const char* name, llvm::BasicBlock* bb) {
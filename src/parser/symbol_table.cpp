@@ -0,0 +1,49 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "symbol_table.h"
+
+// Created eagerly so that parser threads never race on its creation.
+std::unique_ptr<SymbolTable> SymbolTable::g_table_(new SymbolTable());
+
+Symbol SymbolTable::Intern(const char* name) {
+  std::lock_guard<std::mutex> guard(lock_);
+
+  auto it = symbols_.find(name);
+
+  if (it != symbols_.end()) {
+    return it->second;
+  }
+
+  // New symbol: the key of the map owns the characters, names_ just points to them.
+  Symbol symbol = names_.size();
+  auto res = symbols_.insert(std::make_pair(std::string(name), symbol));
+  names_.push_back(res.first->first.c_str());
+
+  return symbol;
+}
+
+Symbol SymbolTable::Find(const char* name) const {
+  std::lock_guard<std::mutex> guard(lock_);
+
+  auto it = symbols_.find(name);
+
+  if (it == symbols_.end()) {
+    return kNoSymbol;
+  }
+
+  return it->second;
+}
@@ -0,0 +1,72 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#ifndef H_SYMBOL_TABLE
+#define H_SYMBOL_TABLE
+
+#include <stdint.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Interned strings: every identifier of the source gets a dense integer, comparisons
+ *   and lookups are then integer based instead of string based.
+ *
+ * The table is shared by all parsers, accesses are protected by a lock.
+ */
+
+typedef uint32_t Symbol;
+
+class SymbolTable {
+  protected:
+    std::unordered_map<std::string, Symbol> symbols_;
+    std::vector<const char*> names_;
+    mutable std::mutex lock_;
+
+    static std::unique_ptr<SymbolTable> g_table_;
+
+  public:
+    // Symbol used for anything that is not named.
+    static const Symbol kNoSymbol = ~0u;
+
+    Symbol Intern(const char* name);
+    Symbol Find(const char* name) const;
+
+    const char* GetName(Symbol symbol) const {
+      std::lock_guard<std::mutex> guard(lock_);
+
+      if (symbol < names_.size()) {
+        return names_[symbol];
+      }
+
+      return nullptr;
+    }
+
+    size_t GetNumSymbols() const {
+      std::lock_guard<std::mutex> guard(lock_);
+      return names_.size();
+    }
+
+    // Created with the static objects, before any parser thread.
+    static SymbolTable* Get() {
+      return g_table_.get();
+    }
+};
+
+#endif
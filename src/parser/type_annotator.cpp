@@ -0,0 +1,430 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "function.h"
+#include "import_function.h"
+#include "type_annotator.h"
+
+// Wasm has no booleans: as far as the checks go, a comparison is an i32.
+static ETYPE GetWasmType(ETYPE type) {
+  return type == INT_1 ? INT_32 : type;
+}
+
+static bool IsComparison(OPERATION op) {
+  switch (op) {
+    case EQ_OPER:
+    case NE_OPER:
+    case LE_OPER:
+    case LT_OPER:
+    case GE_OPER:
+    case GT_OPER:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Same as the code generation and the name resolution: the switch selector is outside of the switch's label.
+static size_t GetPushedLabels(Expression* expr) {
+  switch (expr->GetKind()) {
+    case EXPR_LOOP:
+      return 2;
+    case EXPR_LABEL:
+    case EXPR_BLOCK:
+    case EXPR_SWITCH:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+// What AnnotateChild gets: the child to skip is the switch selector, already annotated.
+struct AnnotatedChildren {
+  TypeAnnotator* annotator;
+  Expression* skipped;
+};
+
+TypeAnnotator::TypeAnnotator(WasmFunction* fct) : fct_(fct), nbr_errors_(0) {
+  for (auto param : fct->GetParams()) {
+    AddLocals(param->GetLocal());
+  }
+
+  for (auto local : fct->GetLocals()) {
+    AddLocals(local);
+  }
+}
+
+void TypeAnnotator::AddLocals(const Local* local) {
+  for (auto elem : local->GetList()) {
+    local_types_.push_back(elem->GetType());
+
+    if (elem->GetName() != nullptr) {
+      named_local_types_[elem->GetName()] = elem->GetType();
+    }
+  }
+}
+
+void TypeAnnotator::AddLocal(const char* name, ETYPE type) {
+  local_types_.push_back(type);
+  named_local_types_[name] = type;
+}
+
+bool TypeAnnotator::FindLocalType(const Variable* var, ETYPE& type) const {
+  if (var == nullptr) {
+    return false;
+  }
+
+  if (var->IsString() == true) {
+    auto it = named_local_types_.find(var->GetString());
+
+    if (it == named_local_types_.end()) {
+      return false;
+    }
+
+    type = it->second;
+    return true;
+  }
+
+  if (var->GetIdx() >= local_types_.size()) {
+    return false;
+  }
+
+  type = local_types_[var->GetIdx()];
+  return true;
+}
+
+void TypeAnnotator::Error(const char* what, ETYPE type, ETYPE expected) {
+  BISON_PRINT("Type mismatch in %s: %s is %s instead of %s\n", fct_->GetName().c_str(), what,
+              GetETypeName(type), GetETypeName(expected));
+  nbr_errors_++;
+}
+
+// Nodes without a value are not checked: they only show up where the value is not used.
+void TypeAnnotator::Check(ETYPE expected, Expression* operand, const char* what) {
+  if (operand == nullptr) {
+    return;
+  }
+
+  ETYPE type = operand->GetValueType();
+
+  if (expected != VOID && type != VOID && GetWasmType(expected) != GetWasmType(type)) {
+    Error(what, type, expected);
+  }
+}
+
+// The type two values merge to: no value takes the other's type, a comparison is widened to the other integer.
+ETYPE TypeAnnotator::Merge(ETYPE merged, ETYPE type, const char* what) {
+  if (type == VOID) {
+    return merged;
+  }
+
+  if (merged == VOID) {
+    return type;
+  }
+
+  if (GetWasmType(merged) != GetWasmType(type)) {
+    Error(what, type, merged);
+    return merged;
+  }
+
+  return (merged == INT_1) ? type : merged;
+}
+
+void TypeAnnotator::MergeLabel(Variable* var, Expression* value) {
+  if (var == nullptr) {
+    return;
+  }
+
+  // The name resolution did not find the label: neither will the code generation.
+  if (var->IsString() == true || var->GetIdx() >= labels_.size()) {
+    BISON_PRINT("Unknown label in %s\n", fct_->GetName().c_str());
+    nbr_errors_++;
+    return;
+  }
+
+  if (value == nullptr) {
+    return;
+  }
+
+  ETYPE& merged = labels_[labels_.size() - 1 - var->GetIdx()];
+  merged = Merge(merged, value->GetValueType(), "break value");
+}
+
+// The last value of a list goes to its merge point, unless the code generation stopped at a terminator.
+ETYPE TypeAnnotator::MergeFallthrough(ETYPE merged, std::list<Expression*>* list) {
+  if (list == nullptr || list->empty() == true) {
+    return merged;
+  }
+
+  for (auto expr : *list) {
+    if (expr->IsTerminator() == true) {
+      return merged;
+    }
+  }
+
+  return Merge(merged, list->back()->GetValueType(), "fall through value");
+}
+
+bool TypeAnnotator::AnnotateChild(Expression* child, void* data) {
+  AnnotatedChildren* children = static_cast<AnnotatedChildren*>(data);
+
+  if (child != children->skipped) {
+    children->annotator->Annotate(child);
+  }
+
+  return true;
+}
+
+void TypeAnnotator::Annotate(Expression* expr) {
+  AnnotatedChildren children = {this, nullptr};
+
+  if (SwitchExpression* switch_expr = llvm::dyn_cast<SwitchExpression>(expr)) {
+    children.skipped = switch_expr->GetSelector();
+    Annotate(children.skipped);
+  }
+
+  size_t pushed = GetPushedLabels(expr);
+  labels_.insert(labels_.end(), pushed, VOID);
+
+  expr->ForEachChild(AnnotateChild, &children);
+
+  // The named expressions read the types merged in their labels: pop them after the visit.
+  Visit(expr);
+
+  labels_.resize(labels_.size() - pushed);
+}
+
+// Nops and unreachables.
+void TypeAnnotator::VisitExpression(Expression* expr) {
+  expr->SetValueType(VOID);
+}
+
+// The scripts pass their messages and functions around as pointers.
+void TypeAnnotator::VisitStringExpression(StringExpression* expr) {
+  expr->SetValueType(PTR_32);
+}
+
+void TypeAnnotator::VisitValueExpression(ValueExpression* expr) {
+  expr->SetValueType(PTR_32);
+}
+
+void TypeAnnotator::VisitConst(Const* expr) {
+  expr->SetValueType(expr->GetType());
+}
+
+void TypeAnnotator::VisitUnop(Unop* expr) {
+  Operation* op = expr->GetOperation();
+  ConversionOperation* conversion = dynamic_cast<ConversionOperation*>(op);
+
+  Check(conversion != nullptr ? conversion->GetSrc() : op->GetType(), expr->GetOnly(), "unary operand");
+  expr->SetValueType(op->GetType());
+}
+
+void TypeAnnotator::VisitBinop(Binop* expr) {
+  Expression* left = expr->GetLeft();
+  Expression* right = expr->GetRight();
+  Operation* op = expr->GetOperation();
+  ETYPE type = op->GetType();
+
+  if (type == VOID) {
+    // The script assertions leave the type to their operands.
+    type = GetWasmType(Merge(left->GetValueType(), right->GetValueType(), "right operand"));
+    op->SetType(type);
+  } else {
+    Check(type, left, "left operand");
+    Check(type, right, "right operand");
+  }
+
+  expr->SetValueType(IsComparison(op->GetOperation()) ? INT_1 : type);
+}
+
+void TypeAnnotator::VisitGetLocal(GetLocal* expr) {
+  ETYPE type = VOID;
+
+  if (FindLocalType(expr->GetVariable(), type) == false) {
+    BISON_PRINT("Unknown local read in %s\n", fct_->GetName().c_str());
+    nbr_errors_++;
+  }
+
+  expr->SetValueType(type);
+}
+
+// The code generation converts the value to the local's type and returns it.
+void TypeAnnotator::VisitSetLocal(SetLocal* expr) {
+  Expression* value = expr->GetValue();
+  ETYPE type = VOID;
+
+  if (FindLocalType(expr->GetVariable(), type) == true) {
+    Check(type, value, "stored local");
+  } else {
+    BISON_PRINT("Unknown local written in %s\n", fct_->GetName().c_str());
+    nbr_errors_++;
+    type = value->GetValueType();
+  }
+
+  expr->SetValueType(type);
+}
+
+void TypeAnnotator::VisitIfExpression(IfExpression* expr) {
+  Expression* false_side = expr->GetFalse();
+
+  if (false_side == nullptr) {
+    expr->SetValueType(VOID);
+    return;
+  }
+
+  ETYPE true_type = expr->GetTrue()->GetValueType();
+  ETYPE false_type = false_side->GetValueType();
+
+  // Without a merge, the result is the side not leaving.
+  if (expr->ShouldMerge() == false) {
+    expr->SetValueType(true_type != VOID ? true_type : false_type);
+    return;
+  }
+
+  expr->SetValueType(Merge(true_type, false_type, "if's false side"));
+}
+
+void TypeAnnotator::VisitBreakIfExpression(BreakIfExpression* expr) {
+  MergeLabel(expr->GetVariable(), expr->GetExpression());
+  expr->SetValueType(VOID);
+}
+
+void TypeAnnotator::VisitCallExpression(CallExpression* expr) {
+  WasmFunction* callee = expr->GetCallee(fct_);
+
+  std::vector<ETYPE> param_types;
+
+  for (auto param : callee->GetParams()) {
+    for (auto elem : param->GetLocal()->GetList()) {
+      param_types.push_back(elem->GetType());
+    }
+  }
+
+  // The functions built directly in LLVM, like the script's trap handler, have no Wasm parameters to check.
+  llvm::Function* llvm_fct = callee->GetFunction();
+
+  if (llvm_fct == nullptr || llvm_fct->arg_size() == param_types.size()) {
+    std::vector<Expression*> args;
+    expr->GetChildren(args);
+
+    if (args.size() != param_types.size()) {
+      BISON_PRINT("Call to %s in %s has %zu arguments instead of %zu\n", callee->GetName().c_str(),
+                  fct_->GetName().c_str(), args.size(), param_types.size());
+      nbr_errors_++;
+    } else {
+      for (size_t i = 0; i < args.size(); i++) {
+        Check(param_types[i], args[i], "argument");
+      }
+    }
+  }
+
+  expr->SetValueType(callee->GetResult());
+}
+
+void TypeAnnotator::VisitCallImportExpression(CallImportExpression* expr) {
+  WasmImportFunction* wif = expr->GetImport(fct_);
+
+  if (wif == nullptr) {
+    BISON_PRINT("Unknown import called in %s\n", fct_->GetName().c_str());
+    nbr_errors_++;
+    expr->SetValueType(VOID);
+    return;
+  }
+
+  expr->SetValueType(wif->GetResult());
+}
+
+void TypeAnnotator::VisitReturnExpression(ReturnExpression* expr) {
+  Check(fct_->GetResult(), expr->GetResult(), "returned value");
+  expr->SetValueType(VOID);
+}
+
+// The loop's value leaves through its exit label, pushed before the loop's own.
+void TypeAnnotator::VisitLoopExpression(LoopExpression* expr) {
+  ETYPE exit_type = labels_[labels_.size() - 2];
+  expr->SetValueType(MergeFallthrough(exit_type, expr->GetList()));
+}
+
+void TypeAnnotator::VisitLabelExpression(LabelExpression* expr) {
+  Expression* value = expr->GetExpression();
+  ETYPE type = labels_.back();
+
+  if (value != nullptr && value->IsTerminator() == false) {
+    type = Merge(type, value->GetValueType(), "fall through value");
+  }
+
+  expr->SetValueType(type);
+}
+
+void TypeAnnotator::VisitBreakExpression(BreakExpression* expr) {
+  MergeLabel(expr->GetVariable(), expr->GetExpression());
+  expr->SetValueType(VOID);
+}
+
+// The blocks converting their value, like the inlined calls, have it by construction.
+void TypeAnnotator::VisitBlockExpression(BlockExpression* expr) {
+  ETYPE type = MergeFallthrough(labels_.back(), expr->GetList());
+
+  if (expr->GetMergeType() != VOID) {
+    type = expr->GetMergeType();
+  }
+
+  expr->SetValueType(type);
+}
+
+void TypeAnnotator::VisitSelectExpression(SelectExpression* expr) {
+  Check(INT_32, expr->GetCondition(), "select's condition");
+
+  ETYPE first_type = expr->GetFirst()->GetValueType();
+  expr->SetValueType(Merge(first_type, expr->GetSecond()->GetValueType(), "select's second operand"));
+}
+
+void TypeAnnotator::VisitLoad(Load* expr) {
+  expr->SetValueType(expr->GetType());
+}
+
+// The code generation returns the stored value.
+void TypeAnnotator::VisitStore(Store* expr) {
+  Expression* value = expr->GetValue();
+  Check(expr->GetType(), value, "stored value");
+  expr->SetValueType(value->GetValueType());
+}
+
+void TypeAnnotator::VisitMemorySize(MemorySize* expr) {
+  expr->SetValueType(INT_32);
+}
+
+void TypeAnnotator::VisitMemoryGrow(MemoryGrow* expr) {
+  Check(INT_32, expr->GetExpression(), "grown size");
+  expr->SetValueType(INT_32);
+}
+
+// The switch falls out of its last case: that is the only case value it uses.
+void TypeAnnotator::VisitCaseExpression(CaseExpression* expr) {
+  expr->SetValueType(MergeFallthrough(VOID, expr->GetList()));
+}
+
+void TypeAnnotator::VisitSwitchExpression(SwitchExpression* expr) {
+  std::list<CaseExpression*>* cases = expr->GetCases();
+  ETYPE type = labels_.back();
+
+  if (cases != nullptr && cases->empty() == false) {
+    type = Merge(type, cases->back()->GetValueType(), "last case's value");
+  }
+
+  expr->SetValueType(type);
+}
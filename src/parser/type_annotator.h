@@ -0,0 +1,99 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#ifndef H_TYPE_ANNOTATOR
+#define H_TYPE_ANNOTATOR
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "expression_visitor.h"
+
+// Forward declarations.
+class Local;
+class Variable;
+class WasmFunction;
+
+/**
+ * The type annotator stamps every node of a function body with the type of the value its code
+ *   generation produces: the code generation only switches on it. Comparisons are INT_1, like in
+ *   the generated code, and the nodes producing no value are VOID.
+ *
+ * The children are typed before their parent. The label stack mirrors what the code generation
+ *   pushes and pops: each label merges the types of the values breaking to it.
+ */
+class TypeAnnotator : public ExpressionVisitor<TypeAnnotator> {
+  protected:
+    WasmFunction* fct_;
+    std::vector<ETYPE> local_types_;
+    std::map<std::string, ETYPE> named_local_types_;
+
+    // The merged type of each label, the innermost last.
+    std::vector<ETYPE> labels_;
+
+    size_t nbr_errors_;
+
+    void AddLocals(const Local* local);
+    bool FindLocalType(const Variable* var, ETYPE& type) const;
+
+    void Error(const char* what, ETYPE type, ETYPE expected);
+    void Check(ETYPE expected, Expression* operand, const char* what);
+    ETYPE Merge(ETYPE merged, ETYPE type, const char* what);
+
+    void MergeLabel(Variable* var, Expression* value);
+    ETYPE MergeFallthrough(ETYPE merged, std::list<Expression*>* list);
+
+    static bool AnnotateChild(Expression* child, void* data);
+
+  public:
+    TypeAnnotator(WasmFunction* fct);
+
+    // For the functions built directly, like the script's.
+    void AddLocal(const char* name, ETYPE type);
+
+    size_t GetNbrErrors() const {
+      return nbr_errors_;
+    }
+
+    void Annotate(Expression* expr);
+
+    void VisitExpression(Expression* expr);
+    void VisitConst(Const* expr);
+    void VisitUnop(Unop* expr);
+    void VisitStringExpression(StringExpression* expr);
+    void VisitValueExpression(ValueExpression* expr);
+    void VisitBinop(Binop* expr);
+    void VisitGetLocal(GetLocal* expr);
+    void VisitSetLocal(SetLocal* expr);
+    void VisitIfExpression(IfExpression* expr);
+    void VisitBreakIfExpression(BreakIfExpression* expr);
+    void VisitCallExpression(CallExpression* expr);
+    void VisitCallImportExpression(CallImportExpression* expr);
+    void VisitReturnExpression(ReturnExpression* expr);
+    void VisitLoopExpression(LoopExpression* expr);
+    void VisitLabelExpression(LabelExpression* expr);
+    void VisitBreakExpression(BreakExpression* expr);
+    void VisitBlockExpression(BlockExpression* expr);
+    void VisitSelectExpression(SelectExpression* expr);
+    void VisitLoad(Load* expr);
+    void VisitStore(Store* expr);
+    void VisitMemorySize(MemorySize* expr);
+    void VisitMemoryGrow(MemoryGrow* expr);
+    void VisitCaseExpression(CaseExpression* expr);
+    void VisitSwitchExpression(SwitchExpression* expr);
+};
+
+#endif
@@ -98,7 +98,13 @@ llvm::Value* Unop::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
     assert(intrinsic_fct != nullptr);
 
     std::vector<Value*> arg;
-    arg.push_back(only_->Codegen(fct, builder));
+    llvm::Value* value = GenerateOperand(fct, builder);
+
+    if (GetTerminator(builder) != nullptr) {
+      return value;
+    }
+
+    arg.push_back(value);
 
     if (extra_true_arg) {
       llvm::Value* val_true = llvm::ConstantInt::get(llvm::getGlobalContext(), APInt(1, 0, false));
@@ -107,7 +113,12 @@ llvm::Value* Unop::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
 
     return builder.CreateCall(intrinsic_fct, arg, "calltmp");
   } else {
-    llvm::Value* rv = only_->Codegen(fct, builder);
+    llvm::Value* rv = GenerateOperand(fct, builder);
+
+    if (GetTerminator(builder) != nullptr) {
+      return rv;
+    }
+
     ETYPE type = operation_->GetType();
 
     switch (op) {
@@ -141,6 +152,23 @@ llvm::Value* Unop::Codegen(WasmFunction* fct, llvm::IRBuilder<>& builder) {
   }
 }
 
+llvm::Value* Unop::GenerateOperand(WasmFunction* fct, llvm::IRBuilder<>& builder) {
+  llvm::Value* value = only_->Generate(fct, builder);
+
+  // Nothing to widen after a jump: the terminator goes back to Codegen.
+  llvm::Value* terminator = GetTerminator(builder);
+
+  if (terminator != nullptr) {
+    return terminator;
+  }
+
+  // A comparison is widened to the integer the operation expects.
+  ConversionOperation* conversion = dynamic_cast<ConversionOperation*>(operation_);
+  ETYPE type = (conversion != nullptr) ? conversion->GetSrc() : operation_->GetType();
+
+  return ConvertValue(value, only_->GetValueType(), type, false, builder);
+}
+
 void Unop::Dump(int tabs) const {
   BISON_TABBED_PRINT(tabs, "(");
 
@@ -160,16 +188,11 @@ void Unop::Dump(int tabs) const {
   BISON_PRINT(")");
 }
 
-bool Unop::Walk(bool (*fct)(Expression*, void*), void* data) {
-  assert(fct != nullptr);
-
-  if (fct(this, data) == false) {
-    return false;
-  }
-
-  if (only_ != nullptr) {
-    return only_->Walk(fct, data);
-  }
+bool Unop::ForEachChild(ChildFunction fct, void* data) const {
+  return CallOnChild(only_, fct, data);
+}
 
-  return true;
+void Unop::ReplaceChild(Expression* old_child, Expression* new_child) {
+  assert(only_ == old_child);
+  only_ = new_child;
 }
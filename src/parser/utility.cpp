@@ -313,13 +313,6 @@ llvm::Value* HandleTypeCasts(llvm::Value* value, llvm::Type* src_type, llvm::Typ
   }
 }
 
-llvm::Value* HandleSimpleTypeCasts(llvm::Value* value, llvm::Type* dest_type, bool sign, llvm::IRBuilder<>& builder) {
-  // Major issue here is casting if need be.
-  // First: Get the result and function types.
-  llvm::Type* src_type = value->getType();
-  return HandleTypeCasts(value, src_type, dest_type, sign, builder);
-}
-
 llvm::Value* HandleIntegerTypeCast(llvm::Value* value, llvm::Type* dest_type, int src_bw, int dest_bw, bool sign, llvm::IRBuilder<>& builder) {
   if (src_bw < dest_bw) {
     if (sign) {
@@ -338,6 +331,19 @@ llvm::Value* HandleIntegerTypeCast(llvm::Value* value, llvm::Type* dest_type, in
   return nullptr;
 }
 
+llvm::Value* ConvertValue(llvm::Value* value, ETYPE src, ETYPE dest, bool sign, llvm::IRBuilder<>& builder) {
+  if (src == dest || dest == VOID) {
+    return value;
+  }
+
+  // Nothing becomes a 0, like what a function returns when its body has no value.
+  if (src == VOID || value == nullptr) {
+    return llvm::Constant::getNullValue(ConvertType(dest));
+  }
+
+  return HandleTypeCasts(value, ConvertType(src), ConvertType(dest), sign, builder);
+}
+
 ETYPE ConvertType2ETYPE(llvm::Type* type) {
   llvm::Type::TypeID type_id = type->getTypeID();
 
@@ -379,20 +385,21 @@ const char* GetTypeName(llvm::Type* type) {
   return GetETypeName(ConvertType2ETYPE(type));
 }
 
-llvm::Value* TransformCondition(llvm::Value* value, llvm::IRBuilder<>& builder) {
-  llvm::Type* type = value->getType();
-
-  if (type->isIntegerTy(1) == false) {
-    if (type->isFloatingPointTy()) {
-      llvm::Value* zero = llvm::ConstantFP::get(llvm::getGlobalContext(), llvm::APFloat(0.0));;
+// The type is the annotated one: no need to look at the LLVM value.
+llvm::Value* TransformCondition(llvm::Value* value, ETYPE type, llvm::IRBuilder<>& builder) {
+  switch (type) {
+    case INT_1:
+      // Nothing to be done.
+      return value;
+    case FLOAT_32:
+    case FLOAT_64: {
+      llvm::Value* zero = llvm::ConstantFP::get(ConvertType(type), 0.0);
       // Not sure ordered is what we want but let us assume for now.
       return builder.CreateFCmpONE(value, zero, "cmp_zero");
-    } else {
-      llvm::Value* zero = llvm::ConstantInt::get(llvm::getGlobalContext(), llvm::APInt(type->getIntegerBitWidth(), 0, false));
+    }
+    default: {
+      llvm::Value* zero = llvm::ConstantInt::get(ConvertType(type), 0);
       return builder.CreateICmpNE(value, zero, "cmp_zero");
     }
   }
-
-  // Nothing to be done.
-  return value;
 }
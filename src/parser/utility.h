@@ -31,10 +31,12 @@ llvm::Type* ConvertType(ETYPE type);
 size_t GetTypeSize(ETYPE type);
 
 // Code generation for type conversion.
-llvm::Value* HandleSimpleTypeCasts(llvm::Value* value, llvm::Type* dest_type, bool sign, llvm::IRBuilder<>& builder);
 llvm::Value* HandleTypeCasts(llvm::Value* value, llvm::Type* src_type, llvm::Type* dest_type, bool sign, llvm::IRBuilder<>& builder);
 
 llvm::Value* HandleIntegerTypeCast(llvm::Value* value, llvm::Type* dest_type, int result_bw, int dest_bw, bool sign, llvm::IRBuilder<>& builder);
 
-llvm::Value* TransformCondition(llvm::Value* value, llvm::IRBuilder<>& builder);
+// Conversion between the annotated types of two nodes, see TypeAnnotator.
+llvm::Value* ConvertValue(llvm::Value* value, ETYPE src, ETYPE dest, bool sign, llvm::IRBuilder<>& builder);
+
+llvm::Value* TransformCondition(llvm::Value* value, ETYPE type, llvm::IRBuilder<>& builder);
 #endif
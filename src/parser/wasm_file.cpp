@@ -14,6 +14,11 @@
 // limitations under the License.
 */
 
+#include <set>
+
+#include "expression.h"
+#include "expression_visitor.h"
+#include "globals.h"
 #include "wasm_file.h"
 
 void WasmFile::GenerateInitializeModules() {
@@ -42,6 +47,11 @@ void WasmFile::GenerateInitializeModules() {
   llvm::IRBuilder<> builder(getGlobalContext());
   builder.SetInsertPoint(bb);
 
+  // Every module then runs with the denormals flushed, nothing restores the mode.
+  if (Globals::Get()->GetFlushDenormalsAtInit() == true) {
+    glue_module_->GenerateFlushDenormals(builder);
+  }
+
   // Now if we have some, we have work.
   if (fcts.size() > 0) {
     std::vector<Value*> args;
@@ -86,4 +96,68 @@ void WasmFile::Initialize() {
     // Initialize everything.
     module->Initialize();
   }
+
+  // Now that every function is known, get the bodies that are needed.
+  ParseReachableBodies();
+
+  // Then the memories: whether they can grow depends on the bodies.
+  for (auto module : modules_) {
+    module->GenerateMemoryBasedCode();
+  }
+}
+
+// Collects the callees of a function in the work list.
+class CalleeCollector : public ExpressionVisitor<CalleeCollector, bool> {
+  protected:
+    WasmFunction* fct_;
+    std::vector<WasmFunction*>& work_list_;
+
+  public:
+    CalleeCollector(WasmFunction* fct, std::vector<WasmFunction*>& work_list) :
+      fct_(fct), work_list_(work_list) {
+    }
+
+    bool VisitExpression(Expression* expr) {
+      (void) expr;
+      return true;
+    }
+
+    bool VisitCallExpression(CallExpression* call) {
+      work_list_.push_back(call->GetCallee(fct_));
+      return true;
+    }
+
+    // Imported functions have no body and no callee: the visitor would otherwise
+    //   fall back to VisitCallExpression.
+    bool VisitCallImportExpression(CallImportExpression* call) {
+      (void) call;
+      return true;
+    }
+};
+
+void WasmFile::ParseReachableBodies() {
+  // The exports are the only entry points: anything else is reached by calls.
+  std::vector<WasmFunction*> work_list;
+
+  for (auto module : modules_) {
+    module->GetExportedFunctions(work_list);
+  }
+
+  std::set<WasmFunction*> visited;
+
+  while (work_list.empty() == false) {
+    WasmFunction* fct = work_list.back();
+    work_list.pop_back();
+
+    if (visited.insert(fct).second == false) {
+      continue;
+    }
+
+    fct->ParseBody();
+
+    CalleeCollector collector(fct, work_list);
+    fct->Walk([&collector](Expression* expr) {
+      return collector.Visit(expr);
+    });
+  }
 }
@@ -40,6 +40,31 @@ class WasmFile {
       script_.AddScriptElem(wse);
     }
 
+    // Move the content of a file parsed from a later part of the source into this one.
+    void Append(WasmFile* later) {
+      // Modules are kept in reverse source order: later ones go first.
+      for (auto module : later->modules_) {
+        module->SetWasmFile(this);
+      }
+      modules_.insert(modules_.begin(), later->modules_.begin(), later->modules_.end());
+      later->modules_.clear();
+
+      script_.Append(later->script_);
+    }
+
+    // Give back the names a single sequential parse would have given.
+    void RenumberInSourceOrder() {
+      int id = 0;
+      int anonymous_id = 0;
+      for (auto it = modules_.rbegin(); it != modules_.rend(); it++) {
+        (*it)->SetId(id);
+        anonymous_id = (*it)->RenumberAnonymousFunctions(anonymous_id);
+        id++;
+      }
+
+      script_.Renumber();
+    }
+
     void Print() {
       for (auto module : modules_) {
         module->Print();
@@ -67,10 +92,14 @@ class WasmFile {
     }
 
     void Initialize();
+    void ParseReachableBodies();
 
     void Generate() {
       for (auto module : modules_) {
-        module->Generate();
+        // Its functions are not all typed: only the declarations are printed.
+        if (module->IsValid() == true) {
+          module->Generate();
+        }
       }
 
       script_.Generate(this);
@@ -99,6 +128,10 @@ class WasmFile {
       return modules_;
     }
 
+    const WasmScript& GetScript() const {
+      return script_;
+    }
+
     WasmModule* GetAssertModule() {
       if (script_module_ == nullptr) {
         llvm::Module* module =
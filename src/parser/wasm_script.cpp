@@ -14,6 +14,7 @@
 // limitations under the License.
 */
 #include "binop.h"
+#include "type_annotator.h"
 #include "wasm_script.h"
 #include "wasm_file.h"
 
@@ -35,7 +36,7 @@ static CallExpression* HandleAssert(WasmModule* wasm_module, WasmScriptElem* ele
 
   // Depending on the type of the assert type, we either call it directly
   //   or go via a handler and pass the wasm_assert method.
-  if (dynamic_cast<WasmAssertReturn*>(elem) != nullptr) {
+  if (llvm::isa<WasmAssertReturn>(elem)) {
     // In this case, we can handle it as if it's just an invoke.
     return HandleInvoke(elem);
   } else {
@@ -89,15 +90,20 @@ void WasmScript::GenerateGeneralScriptCalls(WasmFile* file) {
   WasmFunction* wasm_fct = new WasmFunction(nullptr, name, fct, wasm_module, INT_32);
   const char* result_name = "result";
   Variable* result = new Variable(result_name);
-  wasm_fct->Allocate(result_name,
-                         llvm::Type::getInt32Ty(llvm::getGlobalContext()),
-                         builder);
+  size_t result_idx = wasm_fct->DefineLocal(result_name, result_type, Constant::getNullValue(result_type), builder);
+
+  // No name resolution runs on this code: give the local its index directly.
+  result->Resolve(result_idx);
+
+  // The code generation needs the types of the expressions built below.
+  TypeAnnotator annotator(wasm_fct);
+  annotator.AddLocal(result_name, INT_32);
 
   // Now generate our IR and then use our codegen for it.
   for (auto elem : script_elems_) {
     Expression* expr = nullptr;
 
-    if (dynamic_cast<WasmInvoke*>(elem) != nullptr) {
+    if (llvm::isa<WasmInvoke>(elem)) {
       expr = HandleInvoke(elem);
     } else {
       CallExpression* call = HandleAssert(wasm_module, elem);
@@ -121,7 +127,8 @@ void WasmScript::GenerateGeneralScriptCalls(WasmFile* file) {
     }
 
     // Now we can generate it.
-    expr->Codegen(wasm_fct, builder);
+    annotator.Annotate(expr);
+    expr->Generate(wasm_fct, builder);
 
     delete expr, expr = nullptr;
   }
@@ -130,7 +137,10 @@ void WasmScript::GenerateGeneralScriptCalls(WasmFile* file) {
       new ValueHolder(-1));
   ReturnExpression* return_expr = new ReturnExpression(one);
 
-  return_expr->Codegen(wasm_fct, builder);
+  annotator.Annotate(return_expr);
+  return_expr->Generate(wasm_fct, builder);
 
   delete return_expr, return_expr = nullptr;
+
+  wasm_fct->FinalizeLocals();
 }
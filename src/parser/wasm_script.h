@@ -36,6 +36,27 @@ class WasmScript {
       script_elems_.push_front(a);
     }
 
+    // Used when stitching parsed files together: the elements of later come after ours.
+    void Append(WasmScript& later) {
+      for (auto elem : later.script_elems_) {
+        script_elems_.push_back(elem);
+      }
+      later.script_elems_.clear();
+    }
+
+    // Elements are in source order.
+    void Renumber() {
+      int id = 0;
+      for (auto elem : script_elems_) {
+        elem->SetId(id);
+        id++;
+      }
+    }
+
+    const std::deque<WasmScriptElem*>& GetScriptElems() const {
+      return script_elems_;
+    }
+
     void Dump() const {
       for(auto elem : script_elems_) {
         elem->Dump();
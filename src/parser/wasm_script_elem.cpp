@@ -21,21 +21,22 @@
 #include "llvm/IR/Intrinsics.h"
 
 #include "binop.h"
+#include "type_annotator.h"
 #include "wasm_script_elem.h"
 #include "wasm_file.h"
 
 void WasmAssertReturnNan::Codegen(WasmFile* file) {
   // Just one thing before we do anything. Find out if the caller was 64-bit or not.
-  ReturnExpression* return_expr = dynamic_cast<ReturnExpression*>(expr_);
+  ReturnExpression* return_expr = llvm::dyn_cast_or_null<ReturnExpression>(expr_);
   assert(return_expr != nullptr);
 
-  IfExpression* if_expr = dynamic_cast<IfExpression*>(return_expr->GetResult());
+  IfExpression* if_expr = llvm::dyn_cast_or_null<IfExpression>(return_expr->GetResult());
   assert(if_expr!= nullptr);
 
-  Binop* binop = dynamic_cast<Binop*>(if_expr->GetCondition());
+  Binop* binop = llvm::dyn_cast_or_null<Binop>(if_expr->GetCondition());
   assert(binop != nullptr);
 
-  CallExpression* call = dynamic_cast<CallExpression*>(binop->GetLeft());
+  CallExpression* call = llvm::dyn_cast_or_null<CallExpression>(binop->GetLeft());
   assert(call != nullptr);
 
   Variable* var = call->GetVariable();
@@ -83,7 +84,10 @@ void WasmInvoke::Codegen(WasmFile* file) {
 
   wasm_module->AddFunctionAndRegister(wasm_fct);
 
-  expr_->Codegen(wasm_fct, builder);
+  TypeAnnotator annotator(wasm_fct);
+  annotator.Annotate(expr_);
+
+  expr_->Generate(wasm_fct, builder);
 
   // Invoke from scripts have no return, so let's add a return void. Assertions below have that
   builder.CreateRetVoid();
@@ -114,14 +118,25 @@ void WasmAssertReturn::Codegen(WasmFile* file) {
 
   wasm_module->AddFunctionAndRegister(wasm_fct);
 
-  llvm::Value* value = expr_->Codegen(wasm_fct, builder);
+  TypeAnnotator annotator(wasm_fct);
+  annotator.Annotate(expr_);
+
+  llvm::Value* value = expr_->Generate(wasm_fct, builder);
 
   // If we have a value and it is not a terminator instruction, create the return.
-  if (value != nullptr && dynamic_cast<TerminatorInst*>(value) == nullptr) {
+  if (value != nullptr && llvm::isa<TerminatorInst>(value) == false) {
     builder.CreateRet(value);
   }
 }
 
+void WasmAssertInvalid::Codegen(WasmFile* file) {
+  // The type annotation pass already ran on the module: only its verdict is left.
+  int result = (module_->IsValid() == false) ? -1 : line_;
+
+  expr_ = new Const(INT_32, new ValueHolder(result));
+  WasmAssertReturn::Codegen(file);
+}
+
 void WasmAssertTrap::Codegen(WasmFile* file) {
   // TODO: this does not work: FPE will always trap and I don't see how to solve it right now.
   // This method has no parameters.
@@ -145,6 +160,9 @@ void WasmAssertTrap::Codegen(WasmFile* file) {
 
   wasm_module->AddFunctionAndRegister(wasm_fct);
 
-  llvm::Value* res = expr_->Codegen(wasm_fct, builder);
+  TypeAnnotator annotator(wasm_fct);
+  annotator.Annotate(expr_);
+
+  llvm::Value* res = expr_->Generate(wasm_fct, builder);
   builder.CreateRet(res);
 }
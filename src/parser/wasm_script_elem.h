@@ -26,32 +26,49 @@
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Transforms/Scalar.h"
 
+#include <atomic>
 #include <list>
 #include <sstream>
 
 #include "expression.h"
 
-// Forward declaration.
+// Forward declarations.
 class WasmFile;
+class WasmModule;
+
+// The concrete script element classes, used by classof.
+//   Classes with subclasses cover a contiguous range.
+enum ScriptElemKind {
+  SCRIPT_ELEM_BASE,
+  SCRIPT_ELEM_ASSERT_RETURN,
+  SCRIPT_ELEM_ASSERT_RETURN_NAN,
+  SCRIPT_ELEM_ASSERT_INVALID,
+  SCRIPT_ELEM_INVOKE,
+  SCRIPT_ELEM_ASSERT_TRAP,
+};
 
 class WasmScriptElem {
   protected:
+    const ScriptElemKind kind_;
     Expression* expr_;
     std::string name_;
     std::string mangled_name_;
     int line_;
 
   public:
-    WasmScriptElem(Expression* expr) : expr_(expr), name_(""), mangled_name_(""), line_(0) {
+    WasmScriptElem(Expression* expr, ScriptElemKind kind = SCRIPT_ELEM_BASE) : kind_(kind), expr_(expr), name_(""), mangled_name_(""), line_(0) {
       // Asserts really don't have names but we will want one to call these.
-      static int cnt = 0;
+      //   The counter is atomic since script elements can be created by concurrent parsers.
+      static std::atomic<int> cnt(0);
+      SetId(cnt++);
+    }
+
+    void SetId(int id) {
       std::ostringstream oss;
       oss << "wasm_script_elem_";
 
       // Finally, add the counter.
-      oss << cnt;
-
-      cnt++;
+      oss << id;
 
       name_ = oss.str();
 
@@ -59,6 +76,10 @@ class WasmScriptElem {
       mangled_name_ = name_;
     }
 
+    ScriptElemKind GetKind() const {
+      return kind_;
+    }
+
     void SetLine(int line) {
       line_ = line;
     }
@@ -67,6 +88,10 @@ class WasmScriptElem {
       return line_;
     }
 
+    Expression* GetExpression() const {
+      return expr_;
+    }
+
     virtual void Codegen(WasmFile* file) {
       (void) file;
       BISON_PRINT("No codegen for this script element: %s\n", name_.c_str());
@@ -91,7 +116,11 @@ class WasmScriptElem {
 
 class WasmAssertReturn : public WasmScriptElem {
   public:
-    WasmAssertReturn(Expression* expr) : WasmScriptElem(expr) {
+    static bool classof(const WasmScriptElem* elem) {
+      return elem->GetKind() >= SCRIPT_ELEM_ASSERT_RETURN && elem->GetKind() <= SCRIPT_ELEM_ASSERT_INVALID;
+    }
+
+    WasmAssertReturn(Expression* expr, ScriptElemKind kind = SCRIPT_ELEM_ASSERT_RETURN) : WasmScriptElem(expr, kind) {
     }
 
     virtual void Codegen(WasmFile* file);
@@ -99,7 +128,11 @@ class WasmAssertReturn : public WasmScriptElem {
 
 class WasmInvoke : public WasmScriptElem {
   public:
-    WasmInvoke(Expression* expr) : WasmScriptElem(expr) {
+    static bool classof(const WasmScriptElem* elem) {
+      return elem->GetKind() == SCRIPT_ELEM_INVOKE;
+    }
+
+    WasmInvoke(Expression* expr) : WasmScriptElem(expr, SCRIPT_ELEM_INVOKE) {
     }
 
     virtual void Codegen(WasmFile* file);
@@ -107,10 +140,45 @@ class WasmInvoke : public WasmScriptElem {
 
 class WasmAssertReturnNan : public WasmAssertReturn {
   public:
-    WasmAssertReturnNan(Expression* expr) : WasmAssertReturn(expr) {
+    static bool classof(const WasmScriptElem* elem) {
+      return elem->GetKind() == SCRIPT_ELEM_ASSERT_RETURN_NAN;
+    }
+
+    WasmAssertReturnNan(Expression* expr) : WasmAssertReturn(expr, SCRIPT_ELEM_ASSERT_RETURN_NAN) {
+    }
+
+    virtual void Codegen(WasmFile* file);
+};
+
+// The module is part of the file, the passes decide if it is valid: the generated function
+//   then returns -1, like a successful assert return, and the line otherwise.
+class WasmAssertInvalid : public WasmAssertReturn {
+  protected:
+    WasmModule* module_;
+    std::string error_msg_;
+
+  public:
+    static bool classof(const WasmScriptElem* elem) {
+      return elem->GetKind() == SCRIPT_ELEM_ASSERT_INVALID;
+    }
+
+    WasmAssertInvalid(WasmModule* module, const char* error_msg) :
+      WasmAssertReturn(nullptr, SCRIPT_ELEM_ASSERT_INVALID), module_(module), error_msg_(error_msg) {
+    }
+
+    WasmModule* GetModule() const {
+      return module_;
+    }
+
+    const std::string& GetErrorMessage() const {
+      return error_msg_;
     }
 
     virtual void Codegen(WasmFile* file);
+
+    virtual void Dump(int tabs = 0) const {
+      BISON_TABBED_PRINT(tabs, "(Assert invalid %s: %s)\n", name_.c_str(), error_msg_.c_str());
+    }
 };
 
 class WasmAssertTrap : public WasmScriptElem {
@@ -118,8 +186,12 @@ class WasmAssertTrap : public WasmScriptElem {
     std::string error_msg_;
 
   public:
+    static bool classof(const WasmScriptElem* elem) {
+      return elem->GetKind() == SCRIPT_ELEM_ASSERT_TRAP;
+    }
+
     WasmAssertTrap(Expression* expr) :
-      WasmScriptElem(expr) {
+      WasmScriptElem(expr, SCRIPT_ELEM_ASSERT_TRAP) {
     }
 
     virtual void Codegen(WasmFile* file);
@@ -0,0 +1,551 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <algorithm>
+#include <set>
+
+#include "analysis.h"
+#include "expression_visitor.h"
+#include "function.h"
+#include "wasm_file.h"
+
+// Records one edge per call to a function with a body.
+class WasmCallGraphBuilder : public ExpressionVisitor<WasmCallGraphBuilder, bool> {
+  protected:
+    WasmFunction* fct_;
+    std::vector<WasmFunction*>& callees_;
+
+  public:
+    WasmCallGraphBuilder(WasmFunction* fct, std::vector<WasmFunction*>& callees) :
+      fct_(fct), callees_(callees) {
+    }
+
+    bool VisitExpression(Expression* expr) {
+      (void) expr;
+      return true;
+    }
+
+    bool VisitCallExpression(CallExpression* call) {
+      callees_.push_back(call->GetCallee(fct_));
+      return true;
+    }
+
+    bool VisitCallImportExpression(CallImportExpression* call) {
+      (void) call;
+      return true;
+    }
+};
+
+WasmCallGraph::WasmCallGraph(WasmFile* file) {
+  for (auto module : file->GetWasmModules()) {
+    for (auto fct : module->GetWasmFunctions()) {
+      if (fct->IsBodyAvailable() == false) {
+        continue;
+      }
+
+      std::vector<WasmFunction*>& callees = callees_[fct];
+      WasmCallGraphBuilder builder(fct, callees);
+
+      fct->Walk([&builder](Expression* expr) {
+        return builder.Visit(expr);
+      });
+
+      for (auto callee : callees) {
+        callers_[callee].push_back(fct);
+      }
+    }
+  }
+}
+
+const std::vector<WasmFunction*>& WasmCallGraph::Find(const std::map<WasmFunction*, std::vector<WasmFunction*> >& map,
+                                                  WasmFunction* fct) const {
+  static const std::vector<WasmFunction*> empty;
+  auto it = map.find(fct);
+
+  if (it == map.end()) {
+    return empty;
+  }
+
+  return it->second;
+}
+
+// Tarjan's strongly connected components over the call graph: a function is recursive if its component has
+//   several functions, or if it calls itself.
+class RecursionFinder {
+  protected:
+    const WasmCallGraph& call_graph_;
+    std::map<WasmFunction*, size_t> indices_;
+    std::map<WasmFunction*, size_t> low_links_;
+    std::vector<WasmFunction*> stack_;
+    std::set<WasmFunction*> on_stack_;
+
+  public:
+    std::set<WasmFunction*> recursive_;
+
+    RecursionFinder(const WasmCallGraph& call_graph) : call_graph_(call_graph) {
+    }
+
+    void Visit(WasmFunction* fct) {
+      if (indices_.find(fct) != indices_.end()) {
+        return;
+      }
+
+      size_t index = indices_.size();
+      indices_[fct] = index;
+      low_links_[fct] = index;
+      stack_.push_back(fct);
+      on_stack_.insert(fct);
+
+      for (auto callee : call_graph_.GetCallees(fct)) {
+        if (callee == fct) {
+          recursive_.insert(fct);
+        }
+
+        if (indices_.find(callee) == indices_.end()) {
+          Visit(callee);
+          low_links_[fct] = std::min(low_links_[fct], low_links_[callee]);
+        } else if (on_stack_.find(callee) != on_stack_.end()) {
+          low_links_[fct] = std::min(low_links_[fct], indices_[callee]);
+        }
+      }
+
+      // The root of a component pops it.
+      if (low_links_[fct] == index) {
+        std::vector<WasmFunction*> component;
+        WasmFunction* elem = nullptr;
+
+        do {
+          elem = stack_.back();
+          stack_.pop_back();
+          on_stack_.erase(elem);
+          component.push_back(elem);
+        } while (elem != fct);
+
+        if (component.size() > 1) {
+          recursive_.insert(component.begin(), component.end());
+        }
+      }
+    }
+};
+
+// Integer divisions are plain LLVM divisions: dividing by 0, or the smallest signed value by -1, traps in the hardware.
+static bool MayTrap(Binop* binop) {
+  Operation* operation = binop->GetOperation();
+  ETYPE type = operation->GetType();
+  OPERATION op = operation->GetOperation();
+
+  if ((type != INT_32 && type != INT_64) || (op != DIV_OPER && op != REM_OPER)) {
+    return false;
+  }
+
+  Const* divisor = llvm::dyn_cast<Const>(binop->GetRight());
+
+  if (divisor == nullptr || divisor->GetType() != type) {
+    return true;
+  }
+
+  uint64_t bits = divisor->GetValue()->GetInteger();
+  uint64_t minus_one = (type == INT_32) ? 0xffffffffull : ~0ull;
+
+  if (type == INT_32) {
+    bits = static_cast<uint32_t>(bits);
+  }
+
+  return bits == 0 || (operation->GetSignedOrOrdered() == true && bits == minus_one);
+}
+
+unsigned SideEffects::GetLocalEffects(WasmFunction* fct) {
+  unsigned effects = 0;
+
+  fct->Walk([&effects](Expression* expr) {
+    switch (expr->GetKind()) {
+      case EXPR_LOAD:
+      case EXPR_MEMORY_SIZE:
+        effects |= READS_MEMORY;
+        break;
+      case EXPR_STORE:
+        effects |= READS_MEMORY | WRITES_MEMORY;
+        break;
+      case EXPR_MEMORY_GROW:
+        effects |= READS_MEMORY | WRITES_MEMORY | GROWS_MEMORY;
+        break;
+      case EXPR_CALL_IMPORT:
+        effects |= READS_MEMORY | WRITES_MEMORY | CALLS_IMPORT | MAY_TRAP | GROWS_MEMORY;
+        break;
+      case EXPR_UNREACHABLE:
+        effects |= MAY_TRAP;
+        break;
+      case EXPR_BINOP:
+        if (MayTrap(llvm::cast<Binop>(expr)) == true) {
+          effects |= MAY_TRAP;
+        }
+        break;
+      default:
+        break;
+    }
+
+    return true;
+  });
+
+  return effects;
+}
+
+// Without a return, the top-level expressions all run: one trapping or calling a function that never returns is enough.
+bool SideEffects::NeverReturns(WasmFunction* fct) const {
+  bool has_return = (fct->Walk([](Expression* expr) {
+    return llvm::isa<ReturnExpression>(expr) == false;
+  }) == false);
+
+  if (has_return == true) {
+    return false;
+  }
+
+  for (auto expr : fct->GetAST()) {
+    if (llvm::isa<Unreachable>(expr) == true) {
+      return true;
+    }
+
+    CallExpression* call = llvm::dyn_cast<CallExpression>(expr);
+
+    if (call != nullptr && llvm::isa<CallImportExpression>(call) == false &&
+        (GetEffects(call->GetCallee(fct)) & NEVER_RETURNS) != 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void SideEffects::FindRecursion(const WasmCallGraph& call_graph) {
+  RecursionFinder finder(call_graph);
+
+  for (auto& elem : effects_) {
+    finder.Visit(elem.first);
+  }
+
+  for (auto& elem : effects_) {
+    // An import can call back into any function of the file.
+    if ((elem.second & CALLS_IMPORT) != 0 || finder.recursive_.find(elem.first) != finder.recursive_.end()) {
+      elem.second |= MAY_RECURSE;
+    }
+  }
+}
+
+SideEffects::SideEffects(WasmFile* file, const WasmCallGraph& call_graph) {
+  std::vector<WasmFunction*> functions;
+
+  for (auto module : file->GetWasmModules()) {
+    for (auto fct : module->GetWasmFunctions()) {
+      if (fct->IsBodyAvailable() == true) {
+        functions.push_back(fct);
+        effects_[fct] = GetLocalEffects(fct);
+      }
+    }
+  }
+
+  // The callees' effects are the caller's: iterate until nothing changes.
+  bool changed = true;
+
+  while (changed == true) {
+    changed = false;
+
+    for (auto fct : functions) {
+      unsigned effects = effects_[fct];
+
+      for (auto callee : call_graph.GetCallees(fct)) {
+        effects |= GetEffects(callee) & ~(MAY_RECURSE | NEVER_RETURNS);
+      }
+
+      if (effects != effects_[fct]) {
+        effects_[fct] = effects;
+        changed = true;
+      }
+    }
+  }
+
+  FindRecursion(call_graph);
+
+  // Same for the functions that never return: starting from none of them only finds the sure ones.
+  changed = true;
+
+  while (changed == true) {
+    changed = false;
+
+    for (auto fct : functions) {
+      if ((effects_[fct] & NEVER_RETURNS) == 0 && NeverReturns(fct) == true) {
+        effects_[fct] |= NEVER_RETURNS;
+        changed = true;
+      }
+    }
+  }
+}
+
+// Unsigned range [first, last] of an address computation, if it is bounded: lookup tables are usually
+//   indexed by a masked, shifted or narrow-loaded value. A 32-bit computation that might wrap is not.
+static bool GetAddressRange(Expression* expr, uint64_t& first, uint64_t& last) {
+  static const uint64_t kMax32 = 0xffffffffull;
+
+  switch (expr->GetKind()) {
+    case EXPR_CONST: {
+      Const* constant = llvm::cast<Const>(expr);
+      uint64_t bits = constant->GetValue()->GetInteger();
+
+      switch (constant->GetType()) {
+        case INT_32:
+          first = last = static_cast<uint32_t>(bits);
+          return true;
+        case INT_64:
+          first = last = bits;
+          return true;
+        default:
+          return false;
+      }
+    }
+    case EXPR_LOAD: {
+      Load* load = llvm::cast<Load>(expr);
+
+      if (load->GetType() != INT_32 || load->GetSign() == true || load->GetSize() >= 32) {
+        return false;
+      }
+
+      first = 0;
+      last = (1ull << load->GetSize()) - 1;
+      return true;
+    }
+    case EXPR_BINOP: {
+      Binop* binop = llvm::cast<Binop>(expr);
+      Operation* operation = binop->GetOperation();
+
+      if (operation->GetType() != INT_32) {
+        return false;
+      }
+
+      uint64_t left_first, left_last, right_first, right_last;
+      bool left = GetAddressRange(binop->GetLeft(), left_first, left_last);
+      bool right = GetAddressRange(binop->GetRight(), right_first, right_last);
+
+      switch (operation->GetOperation()) {
+        case AND_OPER:
+          // Either side bounds the result.
+          if (left == false && right == false) {
+            return false;
+          }
+
+          first = 0;
+          last = std::min(left ? left_last : kMax32, right ? right_last : kMax32);
+          return true;
+        case REM_OPER:
+          if (operation->GetSignedOrOrdered() == true || right == false || right_first == 0) {
+            return false;
+          }
+
+          first = 0;
+          last = std::min(left ? left_last : kMax32, right_last - 1);
+          return true;
+        case ADD_OPER:
+          if (left == false || right == false || left_last + right_last > kMax32) {
+            return false;
+          }
+
+          first = left_first + right_first;
+          last = left_last + right_last;
+          return true;
+        case MUL_OPER:
+          if (left == false || right == false || (left_last != 0 && right_last > kMax32 / left_last)) {
+            return false;
+          }
+
+          first = left_first * right_first;
+          last = left_last * right_last;
+          return true;
+        case SHL_OPER:
+          // The shift count is taken modulo 32: only a constant one is known.
+          if (left == false || right == false || right_first != right_last || right_last >= 32 ||
+              (left_last << right_last) > kMax32) {
+            return false;
+          }
+
+          first = left_first << right_last;
+          last = left_last << right_last;
+          return true;
+        default:
+          return false;
+      }
+    }
+    default:
+      return false;
+  }
+}
+
+bool ReadOnlyMemory::GetAccessRange(MemoryExpression* mem, uint64_t& first, uint64_t& last) {
+  if (GetAddressRange(mem->GetAddress(), first, last) == false) {
+    return false;
+  }
+
+  first += mem->GetOffset();
+  last += mem->GetOffset() + mem->GetSize() / 8 - 1;
+  return true;
+}
+
+bool ReadOnlyMemory::GetConstantAddress(MemoryExpression* mem, uint64_t& address) {
+  // Only a Const: a folded load drops its address computation, which could have side effects.
+  if (llvm::isa<Const>(mem->GetAddress()) == false) {
+    return false;
+  }
+
+  uint64_t last;
+
+  if (GetAddressRange(mem->GetAddress(), address, last) == false) {
+    return false;
+  }
+
+  // The addresses are unsigned.
+  address += mem->GetOffset();
+  return true;
+}
+
+void ReadOnlyMemory::RemoveBytes(uint64_t first, uint64_t last) {
+  bytes_.erase(bytes_.lower_bound(first), bytes_.upper_bound(last));
+}
+
+ReadOnlyMemory::ReadOnlyMemory(WasmModule* module) : written_anywhere_(false) {
+  std::list<Segment*>* segments = module->GetSegments();
+
+  if (segments != nullptr) {
+    // In order: the segments are copied in the memory one after the other.
+    for (auto segment : *segments) {
+      const char* data = segment->GetData();
+      int length = segment->GetLength();
+
+      for (int i = 0; i < length; i++) {
+        bytes_[static_cast<uint64_t>(segment->GetStart()) + i] = static_cast<uint8_t>(data[i]);
+      }
+    }
+  }
+
+  for (auto fct : module->GetWasmFunctions()) {
+    // Only the unreachable functions are left unparsed: they are never generated.
+    if (fct->IsBodyAvailable() == false) {
+      continue;
+    }
+
+    fct->Walk([this](Expression* expr) {
+      Store* store = llvm::dyn_cast<Store>(expr);
+
+      if (store == nullptr && llvm::isa<MemoryGrow>(expr) == false) {
+        return true;
+      }
+
+      uint64_t first, last;
+
+      if (store != nullptr && GetAccessRange(store, first, last) == true) {
+        written_.push_back(std::make_pair(first, last));
+        RemoveBytes(first, last);
+        return true;
+      }
+
+      written_anywhere_ = true;
+      bytes_.clear();
+      return true;
+    });
+  }
+}
+
+bool ReadOnlyMemory::IsReadOnly(uint64_t first, uint64_t last) const {
+  if (written_anywhere_ == true) {
+    return false;
+  }
+
+  for (auto& range : written_) {
+    if (range.first <= last && first <= range.second) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool ReadOnlyMemory::GetValue(uint64_t address, uint64_t size, uint64_t& value) const {
+  value = 0;
+
+  // Little-endian: the first byte is the lowest.
+  for (uint64_t i = 0; i < size; i++) {
+    auto it = bytes_.find(address + i);
+
+    if (it == bytes_.end()) {
+      return false;
+    }
+
+    value |= static_cast<uint64_t>(it->second) << (8 * i);
+  }
+
+  return true;
+}
+
+const WasmCallGraph& WasmAnalysisManager::GetCallGraph() {
+  std::lock_guard<std::mutex> guard(lock_);
+
+  if (call_graph_ == nullptr) {
+    call_graph_ = new WasmCallGraph(file_);
+  }
+
+  return *call_graph_;
+}
+
+const SideEffects& WasmAnalysisManager::GetSideEffects() {
+  // Taken before the lock: GetCallGraph locks too.
+  const WasmCallGraph& call_graph = GetCallGraph();
+
+  std::lock_guard<std::mutex> guard(lock_);
+
+  if (side_effects_ == nullptr) {
+    side_effects_ = new SideEffects(file_, call_graph);
+  }
+
+  return *side_effects_;
+}
+
+const ReadOnlyMemory& WasmAnalysisManager::GetReadOnlyMemory(WasmModule* module) {
+  std::lock_guard<std::mutex> guard(lock_);
+  auto it = read_only_memories_.find(module);
+
+  if (it != read_only_memories_.end()) {
+    return *it->second;
+  }
+
+  ReadOnlyMemory* memory = new ReadOnlyMemory(module);
+  read_only_memories_[module] = memory;
+  return *memory;
+}
+
+void WasmAnalysisManager::InvalidateAll(unsigned preserved) {
+  std::lock_guard<std::mutex> guard(lock_);
+
+  if ((preserved & CALL_GRAPH_ANALYSIS) == 0) {
+    delete call_graph_, call_graph_ = nullptr;
+  }
+
+  if ((preserved & SIDE_EFFECT_ANALYSIS) == 0) {
+    delete side_effects_, side_effects_ = nullptr;
+  }
+
+  if ((preserved & READ_ONLY_MEMORY_ANALYSIS) == 0) {
+    for (auto& elem : read_only_memories_) {
+      delete elem.second;
+    }
+    read_only_memories_.clear();
+  }
+}
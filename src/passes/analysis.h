@@ -0,0 +1,164 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#ifndef H_ANALYSIS
+#define H_ANALYSIS
+
+#include <stdint.h>
+
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Forward declaration.
+class MemoryExpression;
+class WasmFile;
+class WasmFunction;
+class WasmModule;
+
+// The analyses, as bits: passes use them to say what they preserve.
+enum AnalysisKind {
+  CALL_GRAPH_ANALYSIS = 1 << 0,
+  SIDE_EFFECT_ANALYSIS = 1 << 1,
+  READ_ONLY_MEMORY_ANALYSIS = 1 << 2,
+};
+
+static const unsigned kNoAnalysis = 0;
+static const unsigned kAllAnalyses = CALL_GRAPH_ANALYSIS | SIDE_EFFECT_ANALYSIS | READ_ONLY_MEMORY_ANALYSIS;
+
+// Callers and callees of every function with a body, calls to imports are not edges.
+class WasmCallGraph {
+  protected:
+    std::map<WasmFunction*, std::vector<WasmFunction*> > callees_;
+    std::map<WasmFunction*, std::vector<WasmFunction*> > callers_;
+
+    const std::vector<WasmFunction*>& Find(const std::map<WasmFunction*, std::vector<WasmFunction*> >& map,
+                                           WasmFunction* fct) const;
+
+  public:
+    WasmCallGraph(WasmFile* file);
+
+    // One entry per call site: a function called twice shows up twice.
+    const std::vector<WasmFunction*>& GetCallees(WasmFunction* fct) const {
+      return Find(callees_, fct);
+    }
+
+    const std::vector<WasmFunction*>& GetCallers(WasmFunction* fct) const {
+      return Find(callers_, fct);
+    }
+};
+
+// What a function might do when called, its callees included: SideEffects bits.
+enum SideEffect {
+  READS_MEMORY = 1 << 0,
+  // Stores, and growing the memory.
+  WRITES_MEMORY = 1 << 1,
+  // Imports are opaque: they can do all of the above, and call back into the file.
+  CALLS_IMPORT = 1 << 2,
+  MAY_TRAP = 1 << 3,
+  // The function is in a cycle of the call graph.
+  MAY_RECURSE = 1 << 4,
+  // The function traps or calls a function that never returns, on all its paths.
+  NEVER_RETURNS = 1 << 5,
+  // The memory might move: the callers reload its base.
+  GROWS_MEMORY = 1 << 6,
+};
+
+// Side effects of the functions with a body, propagated over the call graph until nothing changes.
+class SideEffects {
+  protected:
+    std::map<WasmFunction*, unsigned> effects_;
+
+    static unsigned GetLocalEffects(WasmFunction* fct);
+    bool NeverReturns(WasmFunction* fct) const;
+    void FindRecursion(const WasmCallGraph& call_graph);
+
+  public:
+    SideEffects(WasmFile* file, const WasmCallGraph& call_graph);
+
+    // Functions without a body might do anything.
+    unsigned GetEffects(WasmFunction* fct) const {
+      auto it = effects_.find(fct);
+      return it != effects_.end() ? it->second : READS_MEMORY | WRITES_MEMORY | CALLS_IMPORT | MAY_TRAP | MAY_RECURSE | GROWS_MEMORY;
+    }
+};
+
+/**
+ * Bytes of a module's memory that no store of the module can overwrite: the segments are the only
+ *   known content of the memory, the rest comes from malloc. A store whose address is bounded only
+ *   writes its range, any other store or a memory growth might write anywhere. Imports only see offsets
+ *   in the memory, not its base: they cannot write to it.
+ */
+class ReadOnlyMemory {
+  protected:
+    // The image of the segments, later segments overwriting earlier ones, minus the written bytes.
+    std::map<uint64_t, uint8_t> bytes_;
+
+    // The [first, last] byte ranges the stores might write.
+    std::vector<std::pair<uint64_t, uint64_t> > written_;
+    bool written_anywhere_;
+
+    void RemoveBytes(uint64_t first, uint64_t last);
+
+  public:
+    ReadOnlyMemory(WasmModule* module);
+
+    // The [first, last] bytes a memory operation might access, offset included, if its address is bounded.
+    static bool GetAccessRange(MemoryExpression* mem, uint64_t& first, uint64_t& last);
+
+    // The address of a memory operation, offset included, if it is a constant.
+    static bool GetConstantAddress(MemoryExpression* mem, uint64_t& address);
+
+    // No store of the module writes any of [first, last]: loads from there always read the initial content.
+    bool IsReadOnly(uint64_t first, uint64_t last) const;
+
+    // Gets the little-endian value of [address, address + size) if all its bytes are read-only.
+    bool GetValue(uint64_t address, uint64_t size, uint64_t& value) const;
+};
+
+/**
+ * Computes the analyses on demand and keeps them until a pass invalidates them:
+ *   after each module or file pass, and after each run of consecutive function passes,
+ *   the driver drops what the passes do not declare as preserved. The analyses are all
+ *   file or module-wide: function passes running concurrently only compute them, the caches are locked.
+ */
+class WasmAnalysisManager {
+  protected:
+    WasmFile* file_;
+    std::mutex lock_;
+
+    WasmCallGraph* call_graph_;
+    SideEffects* side_effects_;
+    std::map<WasmModule*, ReadOnlyMemory*> read_only_memories_;
+
+  public:
+    WasmAnalysisManager(WasmFile* file) : file_(file), call_graph_(nullptr), side_effects_(nullptr) {
+    }
+
+    ~WasmAnalysisManager() {
+      InvalidateAll(kNoAnalysis);
+    }
+
+    const WasmCallGraph& GetCallGraph();
+    const SideEffects& GetSideEffects();
+    const ReadOnlyMemory& GetReadOnlyMemory(WasmModule* module);
+
+    // Only called between passes, from the driver's thread.
+    void InvalidateAll(unsigned preserved);
+};
+
+#endif
@@ -16,30 +16,58 @@
 
 // File contains very basic passes.
 #include "basic.h"
+#include "expression_visitor.h"
 #include "function.h"
 
-static bool FindUnreachable(Expression* expr, void* ptr_b) {
-  bool* result = static_cast<bool*>(ptr_b);
+// Walk callback: the result says if the walk continues.
+class UnreachableFinder : public ExpressionVisitor<UnreachableFinder, bool> {
+  protected:
+    bool found_;
 
-  // If we have an if, we don't know, set it back to true.
-  if (dynamic_cast<IfExpression*>(expr) != nullptr) {
-    *result = false;
+  public:
+    UnreachableFinder() : found_(false) {
+    }
 
-    // Stop walking.
-    return false;
-  }
+    bool Found() const {
+      return found_;
+    }
 
-  // Test for unreachable.
-  if (dynamic_cast<Unreachable*>(expr) != nullptr) {
-    *result = true;
-  }
+    bool VisitExpression(Expression* expr) {
+      (void) expr;
+
+      // Continue walking.
+      return true;
+    }
 
-  // Continue walking.
-  return true;
+    bool VisitIfExpression(IfExpression* expr) {
+      (void) expr;
+
+      // If we have an if, we don't know, set it back to false and stop walking.
+      found_ = false;
+      return false;
+    }
+
+    bool VisitUnreachable(Unreachable* expr) {
+      (void) expr;
+
+      found_ = true;
+      return true;
+    }
+};
+
+static bool FindUnreachable(Expression* expr) {
+  UnreachableFinder finder;
+
+  expr->Walk([&finder](Expression* elem) {
+    return finder.Visit(elem);
+  });
+
+  return finder.Found();
 }
 
 static void HandleIfUnreachable(Expression* expr) {
-  IfExpression* if_expr = dynamic_cast<IfExpression*>(expr);
+  IfExpression* if_expr = llvm::dyn_cast<IfExpression>(expr);
+
   if (if_expr != nullptr) {
     Expression* true_expr = if_expr->GetTrue();
     Expression* false_expr = if_expr->GetFalse();
@@ -48,11 +76,8 @@ static void HandleIfUnreachable(Expression* expr) {
       // We want to know if there is an unreachable directly in these blocks.
       //   This is not perfect because if there is a complex CFG here,
       //   this won't solve it yet.
-      bool true_has_unreachable = false;
-      true_expr->Walk(FindUnreachable, &true_has_unreachable);
-
-      bool false_has_unreachable = false;
-      false_expr->Walk(FindUnreachable, &false_has_unreachable);
+      bool true_has_unreachable = FindUnreachable(true_expr);
+      bool false_has_unreachable = FindUnreachable(false_expr);
 
       if (true_has_unreachable != false_has_unreachable) {
         if_expr->SetShouldMerge(false);
@@ -61,14 +86,14 @@ static void HandleIfUnreachable(Expression* expr) {
   }
 }
 
-static bool HandleUnreachable(Expression* expr, void* data) {
-  HandleIfUnreachable(expr);
-
-  // Continue walking.
-  return true;
-}
-
 void UnreachablePass::Run(WasmFunction* fct, void* data) {
+  (void) data;
+
   // Walk the function's AST looking for unreachable nodes.
-  fct->Walk(HandleUnreachable, data);
+  fct->Walk([](Expression* expr) {
+    HandleIfUnreachable(expr);
+
+    // Continue walking.
+    return true;
+  });
 }
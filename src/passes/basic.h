@@ -26,6 +26,23 @@ class UnreachablePass : public WasmPass {
       return "Unreachable pass";
     }
 
+    virtual const char* GetOptionName() const {
+      return "unreachable";
+    }
+
+    virtual void GetDependencies(std::vector<std::string>& dependencies) const {
+      dependencies.push_back("name-resolution");
+    }
+
+    virtual bool IsFunctionLocal() const {
+      return true;
+    }
+
+    // The pass only sets the if merge flags: every analysis is preserved.
+    virtual unsigned GetPreservedAnalyses() const {
+      return kAllAnalyses;
+    }
+
     // Unreachable only needs to have the run method.
     virtual void Run(WasmFunction* fct, void* data);
 };
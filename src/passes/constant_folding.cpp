@@ -0,0 +1,727 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include <cmath>
+#include <vector>
+
+#include "binop.h"
+#include "constant_folding.h"
+#include "expression_visitor.h"
+#include "function.h"
+
+// Integer constants are handled as their zero-extended bits, whatever the sign of the operation.
+static bool GetIntegerConstant(Expression* expr, ETYPE type, uint64_t& value) {
+  Const* constant = llvm::dyn_cast<Const>(expr);
+
+  if (constant == nullptr || constant->GetType() != type) {
+    return false;
+  }
+
+  uint64_t bits = constant->GetValue()->GetInteger();
+
+  switch (type) {
+    case INT_1:
+      value = bits & 1;
+      return true;
+    case INT_32:
+      value = static_cast<uint32_t>(bits);
+      return true;
+    case INT_64:
+      value = bits;
+      return true;
+    default:
+      return false;
+  }
+}
+
+static bool GetFloatConstant(Expression* expr, float& value) {
+  Const* constant = llvm::dyn_cast<Const>(expr);
+
+  if (constant == nullptr || constant->GetType() != FLOAT_32) {
+    return false;
+  }
+
+  value = constant->GetValue()->GetFloat();
+  return true;
+}
+
+static bool GetFloatConstant(Expression* expr, double& value) {
+  Const* constant = llvm::dyn_cast<Const>(expr);
+
+  if (constant == nullptr || constant->GetType() != FLOAT_64) {
+    return false;
+  }
+
+  value = constant->GetValue()->GetDouble();
+  return true;
+}
+
+// Conditions are integers, the comparisons give an INT_1.
+static bool GetConstantCondition(Expression* expr, bool& value) {
+  Const* constant = llvm::dyn_cast<Const>(expr);
+  uint64_t bits;
+
+  if (constant == nullptr || GetIntegerConstant(constant, constant->GetType(), bits) == false) {
+    return false;
+  }
+
+  value = (bits != 0);
+  return true;
+}
+
+static Const* CreateInteger(ETYPE type, uint64_t value) {
+  // Const::Codegen truncates to the width of the type.
+  return new Const(type, new ValueHolder(static_cast<int64_t>(value)));
+}
+
+static Const* CreateFloat(float value) {
+  return new Const(FLOAT_32, new ValueHolder(value));
+}
+
+static Const* CreateFloat(double value) {
+  return new Const(FLOAT_64, new ValueHolder(value));
+}
+
+// Same predicates as the code generation: signed or unsigned comparisons.
+template <typename U, typename S>
+static bool CompareIntegers(OPERATION op, bool is_signed, U left, U right, bool& result) {
+  S signed_left = static_cast<S>(left);
+  S signed_right = static_cast<S>(right);
+
+  switch (op) {
+    case EQ_OPER:
+      result = (left == right);
+      return true;
+    case NE_OPER:
+      result = (left != right);
+      return true;
+    case LT_OPER:
+      result = is_signed ? signed_left < signed_right : left < right;
+      return true;
+    case LE_OPER:
+      result = is_signed ? signed_left <= signed_right : left <= right;
+      return true;
+    case GT_OPER:
+      result = is_signed ? signed_left > signed_right : left > right;
+      return true;
+    case GE_OPER:
+      result = is_signed ? signed_left >= signed_right : left >= right;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Wasm integer semantics: the arithmetic wraps and shift counts are taken modulo the width.
+//   A division by zero or an overflowing signed division traps: these are left to the generated code.
+template <typename U, typename S>
+static bool ComputeIntegers(OPERATION op, bool is_signed, U left, U right, U& result) {
+  const U mask = sizeof(U) * 8 - 1;
+
+  switch (op) {
+    case ADD_OPER:
+      result = left + right;
+      return true;
+    case SUB_OPER:
+      result = left - right;
+      return true;
+    case MUL_OPER:
+      result = left * right;
+      return true;
+    case AND_OPER:
+      result = left & right;
+      return true;
+    case OR_OPER:
+      result = left | right;
+      return true;
+    case XOR_OPER:
+      result = left ^ right;
+      return true;
+    case SHL_OPER:
+      result = left << (right & mask);
+      return true;
+    case SHR_OPER:
+      if (is_signed == true) {
+        result = static_cast<U>(static_cast<S>(left) >> (right & mask));
+      } else {
+        result = left >> (right & mask);
+      }
+      return true;
+    case DIV_OPER:
+    case REM_OPER:
+      if (right == 0 || (is_signed == true && static_cast<S>(right) == -1)) {
+        return false;
+      }
+
+      if (is_signed == true) {
+        S signed_left = static_cast<S>(left);
+        S signed_right = static_cast<S>(right);
+        result = static_cast<U>(op == DIV_OPER ? signed_left / signed_right : signed_left % signed_right);
+      } else {
+        result = (op == DIV_OPER) ? left / right : left % right;
+      }
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Is x op value always x?
+template <typename U>
+static bool IsRightIdentity(OPERATION op, U value) {
+  const U mask = sizeof(U) * 8 - 1;
+
+  switch (op) {
+    case ADD_OPER:
+    case SUB_OPER:
+    case OR_OPER:
+    case XOR_OPER:
+      return value == 0;
+    case MUL_OPER:
+    case DIV_OPER:
+      return value == 1;
+    case AND_OPER:
+      return value == static_cast<U>(~static_cast<U>(0));
+    case SHL_OPER:
+    case SHR_OPER:
+      return (value & mask) == 0;
+    default:
+      return false;
+  }
+}
+
+// Is value op x always x?
+template <typename U>
+static bool IsLeftIdentity(OPERATION op, U value) {
+  switch (op) {
+    case ADD_OPER:
+    case OR_OPER:
+    case XOR_OPER:
+      return value == 0;
+    case MUL_OPER:
+      return value == 1;
+    case AND_OPER:
+      return value == static_cast<U>(~static_cast<U>(0));
+    default:
+      return false;
+  }
+}
+
+// Same predicates as the code generation: an unordered comparison is true on NaN, an ordered one false.
+template <typename T>
+static bool CompareFloats(OPERATION op, bool ordered, T left, T right, bool& result) {
+  bool is_nan = std::isnan(left) || std::isnan(right);
+
+  switch (op) {
+    case EQ_OPER:
+      result = is_nan ? !ordered : left == right;
+      return true;
+    case NE_OPER:
+      result = is_nan ? !ordered : left != right;
+      return true;
+    case LT_OPER:
+      result = is_nan ? !ordered : left < right;
+      return true;
+    case LE_OPER:
+      result = is_nan ? !ordered : left <= right;
+      return true;
+    case GT_OPER:
+      result = is_nan ? !ordered : left > right;
+      return true;
+    case GE_OPER:
+      result = is_nan ? !ordered : left >= right;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// The NaN bits produced by an operation are not fully specified by Wasm: any NaN is left to the generated code.
+//   So are the min and max of two zeros, where the sign depends on the target.
+template <typename T>
+static bool ComputeFloats(OPERATION op, T left, T right, T& result) {
+  if (std::isnan(left) || std::isnan(right)) {
+    return false;
+  }
+
+  switch (op) {
+    case ADD_OPER:
+      result = left + right;
+      break;
+    case SUB_OPER:
+      result = left - right;
+      break;
+    case MUL_OPER:
+      result = left * right;
+      break;
+    case DIV_OPER:
+      result = left / right;
+      break;
+    case MIN_OPER:
+    case MAX_OPER:
+      if (left == 0 && right == 0) {
+        return false;
+      }
+      result = (op == MIN_OPER) ? std::fmin(left, right) : std::fmax(left, right);
+      break;
+    case COPYSIGN_OPER:
+      result = std::copysign(left, right);
+      break;
+    default:
+      return false;
+  }
+
+  return std::isnan(result) == false;
+}
+
+template <typename U>
+static bool ComputeInteger(OPERATION op, U value, U& result) {
+  const U top = static_cast<U>(1) << (sizeof(U) * 8 - 1);
+  result = 0;
+
+  switch (op) {
+    case CLZ_OPER:
+      for (U bit = top; bit != 0 && (value & bit) == 0; bit >>= 1) {
+        result++;
+      }
+      return true;
+    case CTZ_OPER:
+      for (U bit = 1; bit != 0 && (value & bit) == 0; bit <<= 1) {
+        result++;
+      }
+      return true;
+    case POPCNT_OPER:
+      for (; value != 0; value &= value - 1) {
+        result++;
+      }
+      return true;
+    default:
+      return false;
+  }
+}
+
+template <typename T>
+static bool ComputeFloat(OPERATION op, T value, T& result) {
+  if (std::isnan(value)) {
+    return false;
+  }
+
+  switch (op) {
+    case NEG_OPER:
+      result = -value;
+      break;
+    case ABS_OPER:
+      result = std::fabs(value);
+      break;
+    case CEIL_OPER:
+      result = std::ceil(value);
+      break;
+    case FLOOR_OPER:
+      result = std::floor(value);
+      break;
+    case TRUNC_OPER:
+      result = std::trunc(value);
+      break;
+    case NEAREST_OPER:
+      // Ties to even, the default rounding mode.
+      result = std::nearbyint(value);
+      break;
+    case SQRT_OPER:
+      result = std::sqrt(value);
+      break;
+    default:
+      return false;
+  }
+
+  return std::isnan(result) == false;
+}
+
+// Straight from the integer: going through a double would round twice for a float.
+template <typename T>
+static T ConvertInteger(ETYPE src, bool is_signed, uint64_t value) {
+  if (src == INT_32) {
+    if (is_signed == true) {
+      return static_cast<T>(static_cast<int32_t>(value));
+    }
+    return static_cast<T>(static_cast<uint32_t>(value));
+  }
+
+  if (is_signed == true) {
+    return static_cast<T>(static_cast<int64_t>(value));
+  }
+  return static_cast<T>(value);
+}
+
+// NaN and out of range values trap: nullptr, they are left to the generated code.
+static Const* TruncateFloat(double value, ETYPE dest, bool is_signed) {
+  if (std::isnan(value)) {
+    return nullptr;
+  }
+
+  double truncated = std::trunc(value);
+
+  if (dest == INT_32) {
+    if (is_signed == true && truncated >= -2147483648.0 && truncated < 2147483648.0) {
+      return CreateInteger(INT_32, static_cast<uint32_t>(static_cast<int32_t>(truncated)));
+    }
+
+    if (is_signed == false && truncated >= 0 && truncated < 4294967296.0) {
+      return CreateInteger(INT_32, static_cast<uint32_t>(truncated));
+    }
+  } else if (dest == INT_64) {
+    if (is_signed == true && truncated >= -9223372036854775808.0 && truncated < 9223372036854775808.0) {
+      return CreateInteger(INT_64, static_cast<uint64_t>(static_cast<int64_t>(truncated)));
+    }
+
+    if (is_signed == false && truncated >= 0 && truncated < 18446744073709551616.0) {
+      return CreateInteger(INT_64, static_cast<uint64_t>(truncated));
+    }
+  }
+
+  return nullptr;
+}
+
+static Const* FoldConversion(ConversionOperation* conversion, Expression* only) {
+  ETYPE src = conversion->GetSrc();
+  ETYPE dest = conversion->GetDest();
+  bool is_signed = conversion->GetSignedOrOrdered();
+  uint64_t bits;
+  float f;
+  double d;
+
+  switch (conversion->GetOperation()) {
+    case WRAP_OPER:
+      if (src == INT_64 && dest == INT_32 && GetIntegerConstant(only, INT_64, bits) == true) {
+        return CreateInteger(INT_32, static_cast<uint32_t>(bits));
+      }
+      break;
+    case EXTEND_OPER:
+      if (src == INT_32 && dest == INT_64 && GetIntegerConstant(only, INT_32, bits) == true) {
+        if (is_signed == true) {
+          bits = static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(bits)));
+        }
+        return CreateInteger(INT_64, bits);
+      }
+      break;
+    case CONVERT_OPER:
+      if ((src == INT_32 || src == INT_64) && GetIntegerConstant(only, src, bits) == true) {
+        if (dest == FLOAT_32) {
+          return CreateFloat(ConvertInteger<float>(src, is_signed, bits));
+        }
+
+        if (dest == FLOAT_64) {
+          return CreateFloat(ConvertInteger<double>(src, is_signed, bits));
+        }
+      }
+      break;
+    case PROMOTE_OPER:
+      if (dest == FLOAT_64 && GetFloatConstant(only, f) == true && std::isnan(f) == false) {
+        return CreateFloat(static_cast<double>(f));
+      }
+      break;
+    case DEMOTE_OPER:
+      if (dest == FLOAT_32 && GetFloatConstant(only, d) == true && std::isnan(d) == false) {
+        return CreateFloat(static_cast<float>(d));
+      }
+      break;
+    case REINTERPRET_OPER:
+      // Only the bits move, NaNs included: keep them away from the floating-point registers.
+      if (src == INT_32 && dest == FLOAT_32 && GetIntegerConstant(only, INT_32, bits) == true) {
+        uint32_t narrow = static_cast<uint32_t>(bits);
+        memcpy(&f, &narrow, sizeof(f));
+        return std::isnan(f) ? nullptr : CreateFloat(f);
+      }
+
+      if (src == INT_64 && dest == FLOAT_64 && GetIntegerConstant(only, INT_64, bits) == true) {
+        memcpy(&d, &bits, sizeof(d));
+        return std::isnan(d) ? nullptr : CreateFloat(d);
+      }
+
+      if (src == FLOAT_32 && dest == INT_32 && GetFloatConstant(only, f) == true && std::isnan(f) == false) {
+        uint32_t narrow;
+        memcpy(&narrow, &f, sizeof(narrow));
+        return CreateInteger(INT_32, narrow);
+      }
+
+      if (src == FLOAT_64 && dest == INT_64 && GetFloatConstant(only, d) == true && std::isnan(d) == false) {
+        memcpy(&bits, &d, sizeof(bits));
+        return CreateInteger(INT_64, bits);
+      }
+      break;
+    case TRUNC_OPER:
+      if (src == FLOAT_32 && GetFloatConstant(only, f) == true) {
+        return TruncateFloat(f, dest, is_signed);
+      }
+
+      if (src == FLOAT_64 && GetFloatConstant(only, d) == true) {
+        return TruncateFloat(d, dest, is_signed);
+      }
+      break;
+    default:
+      break;
+  }
+
+  return nullptr;
+}
+
+// No side effect and no trap: dropping the expression changes nothing.
+static bool IsPure(Expression* expr) {
+  return expr->Walk([](Expression* elem) {
+    switch (elem->GetKind()) {
+      case EXPR_NOP:
+      case EXPR_CONST:
+      case EXPR_GET_LOCAL:
+        return true;
+      case EXPR_BINOP: {
+        // Integer divisions trap.
+        Operation* operation = llvm::cast<Binop>(elem)->GetOperation();
+        bool is_float = (operation->GetType() == FLOAT_32 || operation->GetType() == FLOAT_64);
+        OPERATION op = operation->GetOperation();
+        return is_float == true || (op != DIV_OPER && op != REM_OPER);
+      }
+      case EXPR_UNOP: {
+        // Truncations to an integer trap.
+        Operation* operation = llvm::cast<Unop>(elem)->GetOperation();
+        ConversionOperation* conversion = dynamic_cast<ConversionOperation*>(operation);
+        return conversion == nullptr || conversion->GetOperation() != TRUNC_OPER ||
+               conversion->GetSrc() == conversion->GetDest();
+      }
+      default:
+        return false;
+    }
+  });
+}
+
+static bool IsSameLocal(Expression* left, Expression* right) {
+  GetLocal* left_get = llvm::dyn_cast<GetLocal>(left);
+  GetLocal* right_get = llvm::dyn_cast<GetLocal>(right);
+
+  if (left_get == nullptr || right_get == nullptr) {
+    return false;
+  }
+
+  Variable* left_var = left_get->GetVariable();
+  Variable* right_var = right_get->GetVariable();
+
+  return left_var->IsString() == false && right_var->IsString() == false &&
+         left_var->GetIdx() == right_var->GetIdx();
+}
+
+// Folds a tree bottom-up: each Visit returns the node replacing its argument, the argument itself if nothing changes.
+class WasmConstantFolder : public ExpressionVisitor<WasmConstantFolder, Expression*> {
+  protected:
+    template <typename U, typename S>
+    Expression* FoldIntegerBinop(Binop* expr, ETYPE type) {
+      Operation* operation = expr->GetOperation();
+      OPERATION op = operation->GetOperation();
+      bool is_signed = operation->GetSignedOrOrdered();
+      uint64_t left, right;
+      bool is_left_constant = GetIntegerConstant(expr->GetLeft(), type, left);
+      bool is_right_constant = GetIntegerConstant(expr->GetRight(), type, right);
+      bool compare;
+
+      if (is_left_constant == true && is_right_constant == true) {
+        if (CompareIntegers<U, S>(op, is_signed, left, right, compare) == true) {
+          return CreateInteger(INT_1, compare);
+        }
+
+        U result;
+        if (ComputeIntegers<U, S>(op, is_signed, left, right, result) == true) {
+          return CreateInteger(type, result);
+        }
+
+        return expr;
+      }
+
+      if (is_right_constant == true && IsRightIdentity<U>(op, right) == true) {
+        return expr->GetLeft();
+      }
+
+      if (is_left_constant == true && IsLeftIdentity<U>(op, left) == true) {
+        return expr->GetRight();
+      }
+
+      // A local compared with itself: same as comparing two equal constants.
+      if (IsSameLocal(expr->GetLeft(), expr->GetRight()) == true &&
+          CompareIntegers<U, S>(op, is_signed, 0, 0, compare) == true) {
+        return CreateInteger(INT_1, compare);
+      }
+
+      return expr;
+    }
+
+    template <typename T>
+    Expression* FoldFloatBinop(Binop* expr) {
+      Operation* operation = expr->GetOperation();
+      OPERATION op = operation->GetOperation();
+      T left, right;
+
+      if (GetFloatConstant(expr->GetLeft(), left) == false || GetFloatConstant(expr->GetRight(), right) == false) {
+        return expr;
+      }
+
+      bool compare;
+      if (CompareFloats<T>(op, operation->GetSignedOrOrdered(), left, right, compare) == true) {
+        return CreateInteger(INT_1, compare);
+      }
+
+      T result;
+      if (ComputeFloats<T>(op, left, right, result) == true) {
+        return CreateFloat(result);
+      }
+
+      return expr;
+    }
+
+    template <typename U>
+    Expression* FoldIntegerUnop(Unop* expr, ETYPE type) {
+      uint64_t value;
+      U result;
+
+      if (GetIntegerConstant(expr->GetOnly(), type, value) == true &&
+          ComputeInteger<U>(expr->GetOperation()->GetOperation(), value, result) == true) {
+        return CreateInteger(type, result);
+      }
+
+      return expr;
+    }
+
+    template <typename T>
+    Expression* FoldFloatUnop(Unop* expr) {
+      T value, result;
+
+      if (GetFloatConstant(expr->GetOnly(), value) == true &&
+          ComputeFloat<T>(expr->GetOperation()->GetOperation(), value, result) == true) {
+        return CreateFloat(result);
+      }
+
+      return expr;
+    }
+
+  public:
+    Expression* Fold(Expression* expr) {
+      std::vector<Expression*> children;
+      expr->GetChildren(children);
+
+      for (auto child : children) {
+        Expression* folded = Fold(child);
+
+        if (folded != child) {
+          expr->ReplaceChild(child, folded);
+        }
+      }
+
+      return Visit(expr);
+    }
+
+    Expression* VisitExpression(Expression* expr) {
+      return expr;
+    }
+
+    Expression* VisitBinop(Binop* expr) {
+      switch (expr->GetOperation()->GetType()) {
+        case INT_32:
+          return FoldIntegerBinop<uint32_t, int32_t>(expr, INT_32);
+        case INT_64:
+          return FoldIntegerBinop<uint64_t, int64_t>(expr, INT_64);
+        case FLOAT_32:
+          return FoldFloatBinop<float>(expr);
+        case FLOAT_64:
+          return FoldFloatBinop<double>(expr);
+        default:
+          return expr;
+      }
+    }
+
+    Expression* VisitUnop(Unop* expr) {
+      Operation* operation = expr->GetOperation();
+      ConversionOperation* conversion = dynamic_cast<ConversionOperation*>(operation);
+
+      // f32.trunc and f64.trunc are conversions to the same type.
+      if (conversion != nullptr && conversion->GetSrc() != conversion->GetDest()) {
+        Const* result = FoldConversion(conversion, expr->GetOnly());
+
+        if (result != nullptr) {
+          return result;
+        }
+
+        return expr;
+      }
+
+      switch (operation->GetType()) {
+        case INT_32:
+          return FoldIntegerUnop<uint32_t>(expr, INT_32);
+        case INT_64:
+          return FoldIntegerUnop<uint64_t>(expr, INT_64);
+        case FLOAT_32:
+          return FoldFloatUnop<float>(expr);
+        case FLOAT_64:
+          return FoldFloatUnop<double>(expr);
+        default:
+          return expr;
+      }
+    }
+
+    // Also catches the has_feature tests: they are constants from the parser on.
+    Expression* VisitIfExpression(IfExpression* expr) {
+      bool cond;
+
+      if (GetConstantCondition(expr->GetCondition(), cond) == false) {
+        return expr;
+      }
+
+      if (cond == true) {
+        return expr->GetTrue();
+      }
+
+      Expression* false_side = expr->GetFalse();
+      return (false_side != nullptr) ? false_side : new Nop();
+    }
+
+    Expression* VisitSelectExpression(SelectExpression* expr) {
+      bool cond;
+
+      if (GetConstantCondition(expr->GetCondition(), cond) == false) {
+        return expr;
+      }
+
+      // Both sides are evaluated: the other one can only go if it does nothing.
+      Expression* kept = cond ? expr->GetFirst() : expr->GetSecond();
+      Expression* dropped = cond ? expr->GetSecond() : expr->GetFirst();
+
+      return (IsPure(dropped) == true) ? kept : expr;
+    }
+};
+
+void ConstantFoldingPass::Run(WasmFunction* fct, void* data) {
+  (void) data;
+
+  WasmConstantFolder folder;
+
+  // A copy: replacing a top-level expression changes the function's vector.
+  std::vector<Expression*> ast = fct->GetAST();
+
+  for (auto expr : ast) {
+    Expression* folded = folder.Fold(expr);
+
+    if (folded != expr) {
+      fct->ReplaceExpression(expr, folded);
+    }
+  }
+}
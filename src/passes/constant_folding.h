@@ -0,0 +1,45 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#ifndef H_CONSTANT_FOLDING
+#define H_CONSTANT_FOLDING
+
+#include "pass.h"
+
+// Folds the operations on constants and the trivial identities before code generation.
+class ConstantFoldingPass : public WasmPass {
+  public:
+    virtual const char* GetName() const {
+      return "Constant folding pass";
+    }
+
+    virtual const char* GetOptionName() const {
+      return "constant-folding";
+    }
+
+    // The comparisons of a local with itself need the resolved indices.
+    virtual void GetDependencies(std::vector<std::string>& dependencies) const {
+      dependencies.push_back("name-resolution");
+    }
+
+    virtual bool IsFunctionLocal() const {
+      return true;
+    }
+
+    virtual void Run(WasmFunction* fct, void* data);
+};
+
+#endif
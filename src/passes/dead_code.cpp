@@ -0,0 +1,249 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <algorithm>
+#include <list>
+#include <vector>
+
+#include "dead_code.h"
+#include "expression_visitor.h"
+#include "function.h"
+#include "labels.h"
+
+// The nodes evaluating all their children in GetChildren order, before doing anything else.
+//   An if and a switch only evaluate their first child, the condition or the selector, for sure.
+static bool HasOperands(Expression* expr) {
+  switch (expr->GetKind()) {
+    case EXPR_UNOP:
+    case EXPR_BINOP:
+    case EXPR_SET_LOCAL:
+    case EXPR_IF:
+    case EXPR_BREAK_IF:
+    case EXPR_CALL:
+    case EXPR_CALL_IMPORT:
+    case EXPR_RETURN:
+    case EXPR_BREAK:
+    case EXPR_SELECT:
+    case EXPR_LOAD:
+    case EXPR_STORE:
+    case EXPR_MEMORY_GROW:
+    case EXPR_SWITCH:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Does a break of the tree go to the label target levels above it?
+static bool IsTargeted(Expression* expr, size_t target) {
+  bool targeted = false;
+
+  ForEachBreak(expr, 0, [&targeted, target](Variable* var, size_t inner) {
+    // An unresolved name could be anything.
+    if (var->IsString() == true || var->GetIdx() == inner + target) {
+      targeted = true;
+    }
+  });
+
+  return targeted;
+}
+
+static bool IsTargeted(const std::list<Expression*>& list, size_t target) {
+  for (auto expr : list) {
+    if (IsTargeted(expr, target) == true) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Control never goes past these: a block ending with one of them also qualifies, unless it is the target.
+static bool IsTransfer(Expression* expr) {
+  switch (expr->GetKind()) {
+    case EXPR_BREAK:
+    case EXPR_RETURN:
+    case EXPR_UNREACHABLE:
+      return true;
+    case EXPR_BLOCK: {
+      std::list<Expression*>* list = llvm::cast<BlockExpression>(expr)->GetList();
+      return list->empty() == false && IsTransfer(list->back()) == true && IsTargeted(*list, 0) == false;
+    }
+    default:
+      return false;
+  }
+}
+
+// A block or a loop that nobody breaks to is just a sequence: returns its list and the number of labels it pushes.
+static std::list<Expression*>* GetSequence(Expression* expr, size_t& labels) {
+  if (BlockExpression* block = llvm::dyn_cast<BlockExpression>(expr)) {
+    // A block converting its value to a type, like an inlined call, has to stay.
+    if (IsTargeted(*block->GetList(), 0) == false && block->GetMergeType() == VOID) {
+      labels = 1;
+      return block->GetList();
+    }
+  } else if (LoopExpression* loop = llvm::dyn_cast<LoopExpression>(expr)) {
+    // The loop label is pushed last, the exit one is above it.
+    if (IsTargeted(*loop->GetList(), 0) == false && IsTargeted(*loop->GetList(), 1) == false) {
+      labels = 2;
+      return loop->GetList();
+    }
+  }
+
+  return nullptr;
+}
+
+// Rewrites a tree bottom-up: each Visit returns the node replacing its argument, the argument itself if nothing changes.
+class DeadCodeEliminator : public ExpressionVisitor<DeadCodeEliminator, Expression*> {
+  protected:
+    // A sequence with a single expression is the expression itself, an empty one is a nop.
+    Expression* SimplifySequence(Expression* expr) {
+      size_t labels = 0;
+      std::list<Expression*>* sequence = GetSequence(expr, labels);
+
+      if (sequence == nullptr || sequence->size() > 1) {
+        return expr;
+      }
+
+      if (sequence->empty() == true) {
+        return new Nop();
+      }
+
+      Expression* only = sequence->front();
+      ShiftLabels(only, -static_cast<int>(labels));
+      return only;
+    }
+
+  public:
+    Expression* Rewrite(Expression* expr) {
+      std::vector<Expression*> children;
+      expr->GetChildren(children);
+
+      for (auto child : children) {
+        Expression* rewritten = Rewrite(child);
+
+        if (rewritten != child) {
+          expr->ReplaceChild(child, rewritten);
+        }
+      }
+
+      return Visit(expr);
+    }
+
+    // The sequences nobody breaks to are spliced in, and everything after a jump goes.
+    void RewriteList(std::list<Expression*>& list) {
+      std::list<Expression*> result;
+
+      for (auto expr : list) {
+        size_t labels = 0;
+        std::list<Expression*>* sequence = GetSequence(expr, labels);
+
+        if (sequence == nullptr) {
+          result.push_back(expr);
+          continue;
+        }
+
+        for (auto elem : *sequence) {
+          ShiftLabels(elem, -static_cast<int>(labels));
+          result.push_back(elem);
+        }
+      }
+
+      auto transfer = std::find_if(result.begin(), result.end(), IsTransfer);
+
+      if (transfer != result.end()) {
+        result.erase(++transfer, result.end());
+      }
+
+      list.swap(result);
+    }
+
+    // Operands are evaluated in order: once one of them jumps away, the next ones and the node itself are dead.
+    Expression* VisitExpression(Expression* expr) {
+      if (HasOperands(expr) == false) {
+        return expr;
+      }
+
+      std::vector<Expression*> children;
+      expr->GetChildren(children);
+
+      bool first_only = (llvm::isa<IfExpression>(expr) || llvm::isa<SwitchExpression>(expr));
+      size_t nbr = first_only ? std::min<size_t>(children.size(), 1) : children.size();
+
+      for (size_t i = 0; i < nbr; i++) {
+        if (IsTransfer(children[i]) == false) {
+          continue;
+        }
+
+        if (i == 0) {
+          return children[0];
+        }
+
+        // The operands before it still run: a block keeps them in order, one label deeper.
+        std::list<Expression*>* list = new std::list<Expression*>();
+
+        for (size_t j = 0; j <= i; j++) {
+          ShiftLabels(children[j], 1);
+          list->push_back(children[j]);
+        }
+
+        return new BlockExpression(nullptr, list);
+      }
+
+      return expr;
+    }
+
+    Expression* VisitLabelExpression(LabelExpression* expr) {
+      Expression* only = expr->GetExpression();
+
+      if (IsTargeted(only, 0) == true) {
+        return expr;
+      }
+
+      ShiftLabels(only, -1);
+      return only;
+    }
+
+    Expression* VisitBlockExpression(BlockExpression* expr) {
+      RewriteList(*expr->GetList());
+      return SimplifySequence(expr);
+    }
+
+    Expression* VisitLoopExpression(LoopExpression* expr) {
+      RewriteList(*expr->GetList());
+      return SimplifySequence(expr);
+    }
+
+    Expression* VisitCaseExpression(CaseExpression* expr) {
+      RewriteList(*expr->GetList());
+      return expr;
+    }
+};
+
+void DeadCodePass::Run(WasmFunction* fct, void* data) {
+  (void) data;
+
+  DeadCodeEliminator eliminator;
+  std::list<Expression*> body;
+
+  for (auto expr : fct->GetAST()) {
+    body.push_back(eliminator.Rewrite(expr));
+  }
+
+  eliminator.RewriteList(body);
+
+  fct->SetAST(std::vector<Expression*>(body.begin(), body.end()));
+}
@@ -0,0 +1,45 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#ifndef H_DEAD_CODE
+#define H_DEAD_CODE
+
+#include "pass.h"
+
+// Removes what follows a break, a return, or an unreachable, and the labels nobody breaks to.
+class DeadCodePass : public WasmPass {
+  public:
+    virtual const char* GetName() const {
+      return "Dead code pass";
+    }
+
+    virtual const char* GetOptionName() const {
+      return "dead-code";
+    }
+
+    // The breaks are matched to their labels by index.
+    virtual void GetDependencies(std::vector<std::string>& dependencies) const {
+      dependencies.push_back("name-resolution");
+    }
+
+    virtual bool IsFunctionLocal() const {
+      return true;
+    }
+
+    virtual void Run(WasmFunction* fct, void* data);
+};
+
+#endif
@@ -14,8 +14,12 @@
 // limitations under the License.
 */
 
+#include <memory>
+
 #include "driver.h"
+#include "globals.h"
 #include "pass_driver.h"
+#include "remark_writer.h"
 #include "wasm_file.h"
 
 void Driver::Drive() {
@@ -27,7 +31,14 @@ void Driver::Drive() {
   // Run the driver of passes.
   driver.Drive();
 
-  // Then generate the file code.
+  // Then generate the file code: LLVM reports its optimizations while it runs.
+  std::unique_ptr<RemarkWriter> remarks;
+  const char* remarks_file = Globals::Get()->GetRemarksFile();
+
+  if (remarks_file != nullptr) {
+    remarks.reset(new RemarkWriter(remarks_file));
+  }
+
   file_->Generate();
 
   // Dump for debug.
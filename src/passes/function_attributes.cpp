@@ -0,0 +1,67 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/Attributes.h"
+#include "llvm/IR/Function.h"
+
+#include "function.h"
+#include "function_attributes.h"
+#include "wasm_file.h"
+
+void FunctionAttributesPass::RunOnFile(WasmFile* file) {
+  const SideEffects& side_effects = analyses_->GetSideEffects();
+
+  for (auto module : file->GetWasmModules()) {
+    for (auto fct : module->GetWasmFunctions()) {
+      llvm::Function* llvm_fct = fct->GetFunction();
+
+      if (fct->IsBodyAvailable() == false || llvm_fct == nullptr) {
+        continue;
+      }
+
+      unsigned effects = side_effects.GetEffects(fct);
+
+      // A call to a function that does not touch memory can be removed if unused: not if it traps.
+      if ((effects & MAY_TRAP) == 0) {
+        if ((effects & (READS_MEMORY | WRITES_MEMORY)) == 0) {
+          llvm_fct->setDoesNotAccessMemory();
+        } else if ((effects & WRITES_MEMORY) == 0) {
+          llvm_fct->setOnlyReadsMemory();
+        }
+      }
+
+      // Traps do not unwind, only the imports could.
+      if ((effects & CALLS_IMPORT) == 0) {
+        llvm_fct->setDoesNotThrow();
+      }
+
+      // The attribute only exists since LLVM 3.8.
+#if LLVM_VERSION_MAJOR > 3 || (LLVM_VERSION_MAJOR == 3 && LLVM_VERSION_MINOR >= 8)
+      if ((effects & MAY_RECURSE) == 0) {
+        llvm_fct->addFnAttr(llvm::Attribute::NoRecurse);
+      }
+#endif
+
+      if ((effects & NEVER_RETURNS) != 0) {
+        llvm_fct->setDoesNotReturn();
+      }
+
+      // The callers keep the memory base across the call.
+      fct->SetMayGrowMemory((effects & GROWS_MEMORY) != 0);
+    }
+  }
+}
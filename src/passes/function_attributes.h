@@ -0,0 +1,42 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#ifndef H_FUNCTION_ATTRIBUTES
+#define H_FUNCTION_ATTRIBUTES
+
+#include "pass.h"
+
+// Sets the LLVM attributes of the functions from their side effects: calls can then be moved and merged.
+//   Also tells the code generation which calls might move the memory.
+class FunctionAttributesPass : public WasmFilePass {
+  public:
+    virtual const char* GetName() const {
+      return "Function attributes pass";
+    }
+
+    virtual const char* GetOptionName() const {
+      return "function-attributes";
+    }
+
+    // Only the LLVM prototypes change.
+    virtual unsigned GetPreservedAnalyses() const {
+      return kAllAnalyses;
+    }
+
+    virtual void RunOnFile(WasmFile* file);
+};
+
+#endif
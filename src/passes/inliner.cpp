@@ -0,0 +1,355 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <assert.h>
+#include <string.h>
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <vector>
+
+#include "ast_cache.h"
+#include "function.h"
+#include "inliner.h"
+#include "labels.h"
+#include "wasm_file.h"
+
+// Callees without calls up to this many nodes are inlined at each of their call sites.
+static const size_t kLeafSize = 32;
+
+// Callees with a single call site, up to this many nodes.
+static const size_t kSingleCallSiteSize = 256;
+
+// A caller grows by at most its own size, or this many nodes if it is smaller: files full of
+//   functions calling each other grow linearly.
+static const size_t kMinCallerGrowth = 128;
+
+// Parameters and locals, exploded: the resolved indices go up to this.
+static void GetLocalElems(WasmFunction* fct, std::vector<LocalElem*>& elems) {
+  for (auto param : fct->GetParams()) {
+    const std::deque<LocalElem*>& list = param->GetLocal()->GetList();
+    elems.insert(elems.end(), list.begin(), list.end());
+  }
+
+  for (auto local : fct->GetLocals()) {
+    const std::deque<LocalElem*>& list = local->GetList();
+    elems.insert(elems.end(), list.begin(), list.end());
+  }
+}
+
+static size_t GetNbrParams(WasmFunction* fct) {
+  size_t nbr = 0;
+
+  for (auto param : fct->GetParams()) {
+    nbr += param->GetLocal()->GetList().size();
+  }
+
+  return nbr;
+}
+
+static bool IsLeaf(WasmFunction* fct) {
+  return fct->Walk([](Expression* expr) {
+    return llvm::isa<CallExpression>(expr) == false || llvm::isa<CallImportExpression>(expr) == true;
+  });
+}
+
+// Does the body of callee still mean the same thing once copied into caller?
+static bool IsCopiable(WasmFunction* callee, WasmFunction* caller) {
+  bool same_module = callee->GetModule() == caller->GetModule();
+
+  return callee->Walk([same_module](Expression* expr) {
+    Variable* var = nullptr;
+
+    switch (expr->GetKind()) {
+      case EXPR_GET_LOCAL:
+        var = llvm::cast<GetLocal>(expr)->GetVariable();
+        break;
+      case EXPR_SET_LOCAL:
+        var = llvm::cast<SetLocal>(expr)->GetVariable();
+        break;
+      case EXPR_BREAK:
+        var = llvm::cast<BreakExpression>(expr)->GetVariable();
+        break;
+      case EXPR_BREAK_IF:
+        var = llvm::cast<BreakIfExpression>(expr)->GetVariable();
+        break;
+      // The functions, the imports and the memory belong to the module:
+      //   each module has its own llvm::Module, a copied call would reach into another one.
+      case EXPR_CALL:
+      case EXPR_CALL_IMPORT:
+      case EXPR_LOAD:
+      case EXPR_STORE:
+      case EXPR_MEMORY_SIZE:
+      case EXPR_MEMORY_GROW:
+        return same_module;
+      default:
+        break;
+    }
+
+    // A name would be looked up in the caller.
+    return var == nullptr || var->IsString() == false;
+  });
+}
+
+// The serialization does not keep what the passes found: the callees, and the types of the inlined blocks.
+static void CopyResolution(Expression* original, Expression* copy) {
+  if (CallExpression* call = llvm::dyn_cast<CallExpression>(copy)) {
+    call->CopyResolution(llvm::cast<CallExpression>(original));
+  } else if (BlockExpression* block = llvm::dyn_cast<BlockExpression>(copy)) {
+    block->SetMergeType(llvm::cast<BlockExpression>(original)->GetMergeType());
+  }
+
+  std::vector<Expression*> original_children;
+  std::vector<Expression*> copy_children;
+  original->GetChildren(original_children);
+  copy->GetChildren(copy_children);
+
+  assert(original_children.size() == copy_children.size());
+
+  for (size_t i = 0; i < copy_children.size(); i++) {
+    CopyResolution(original_children[i], copy_children[i]);
+  }
+}
+
+// Copies the body through the AST cache serialization.
+static void CopyBody(WasmFunction* fct, std::vector<Expression*>& copies) {
+  AstWriter writer;
+  const std::vector<Expression*>& body = fct->GetAST();
+
+  for (auto expr : body) {
+    writer.WriteExpression(expr);
+  }
+
+  // The names of the copies point into the string table: it lives as long as the AST.
+  const std::string& strings = writer.GetStrings();
+  char* table = new char[strings.size() + 1];
+  memcpy(table, strings.data(), strings.size());
+
+  const std::string& records = writer.GetRecords();
+  AstReader reader(records.data(), records.size(), table);
+
+  for (auto expr : body) {
+    Expression* copy = reader.ReadExpression();
+    CopyResolution(expr, copy);
+    copies.push_back(copy);
+  }
+}
+
+static void RenumberLocals(Expression* expr, size_t base) {
+  expr->Walk([base](Expression* elem) {
+    Variable* var = nullptr;
+
+    if (GetLocal* get = llvm::dyn_cast<GetLocal>(elem)) {
+      var = get->GetVariable();
+    } else if (SetLocal* set = llvm::dyn_cast<SetLocal>(elem)) {
+      var = set->GetVariable();
+    }
+
+    if (var != nullptr) {
+      var->Resolve(var->GetIdx() + base);
+    }
+
+    return true;
+  });
+}
+
+// The returns of the tree become breaks to the block inner labels above it.
+static Expression* ReplaceReturns(Expression* expr, size_t inner) {
+  std::vector<Expression*> children;
+  expr->GetChildren(children);
+
+  for (auto child : children) {
+    Expression* replaced = ReplaceReturns(child, inner + GetPushedLabels(expr, child));
+
+    if (replaced != child) {
+      expr->ReplaceChild(child, replaced);
+    }
+  }
+
+  if (ReturnExpression* ret = llvm::dyn_cast<ReturnExpression>(expr)) {
+    return new BreakExpression(new Variable(static_cast<int64_t>(inner)), ret->GetResult());
+  }
+
+  return expr;
+}
+
+// The call becomes a block: the arguments go to fresh locals, then comes a copy of the callee's body,
+//   leaving the block where it returned. The block's value is converted to the callee's result type.
+static Expression* InlineCall(WasmFunction* caller, CallExpression* call, WasmFunction* callee) {
+  std::vector<LocalElem*> caller_elems;
+  GetLocalElems(caller, caller_elems);
+  size_t base = caller_elems.size();
+
+  std::vector<LocalElem*> elems;
+  GetLocalElems(callee, elems);
+
+  for (auto elem : elems) {
+    caller->AddLocal(new Local(elem->GetType(), nullptr));
+  }
+
+  std::list<Expression*>* list = new std::list<Expression*>();
+
+  std::vector<Expression*> args;
+  call->GetChildren(args);
+
+  size_t idx = 0;
+
+  for (auto arg : args) {
+    // The argument is now inside the block.
+    ShiftLabels(arg, 1);
+    list->push_back(new SetLocal(new Variable(static_cast<int64_t>(base + idx)), arg));
+    idx++;
+  }
+
+  // The block might be in a loop: each call starts with zeroed locals.
+  for (; idx < elems.size(); idx++) {
+    Expression* zero = new Const(elems[idx]->GetType(), new ValueHolder(0));
+    list->push_back(new SetLocal(new Variable(static_cast<int64_t>(base + idx)), zero));
+  }
+
+  std::vector<Expression*> copies;
+  CopyBody(callee, copies);
+
+  for (auto copy : copies) {
+    RenumberLocals(copy, base);
+    list->push_back(ReplaceReturns(copy, 0));
+  }
+
+  BlockExpression* block = new BlockExpression(nullptr, list);
+  block->SetMergeType(callee->GetResult());
+  return block;
+}
+
+struct CallSite {
+  CallExpression* call_;
+  Expression* parent_;
+};
+
+// The call sites under expr, whose parent is given: a nullptr parent is the function itself.
+struct CallSiteCollection {
+  Expression* parent_;
+  std::vector<CallSite>* sites_;
+};
+
+// Post-order: a call is handled before the call using its result, so the parents stay valid.
+static bool CollectCallSites(Expression* expr, void* data) {
+  CallSiteCollection* collection = static_cast<CallSiteCollection*>(data);
+  CallSiteCollection children = {expr, collection->sites_};
+
+  expr->ForEachChild(CollectCallSites, &children);
+
+  if (llvm::isa<CallExpression>(expr) == true && llvm::isa<CallImportExpression>(expr) == false) {
+    CallSite site = {llvm::cast<CallExpression>(expr), collection->parent_};
+    collection->sites_->push_back(site);
+  }
+
+  return true;
+}
+
+// Number of nodes of the body.
+static size_t GetSize(WasmFunction* fct) {
+  size_t size = 0;
+
+  fct->Walk([&size](Expression* expr) {
+    (void) expr;
+    size++;
+    return true;
+  });
+
+  return size;
+}
+
+void InliningPass::RunOnFile(WasmFile* file) {
+  const WasmCallGraph& call_graph = analyses_->GetCallGraph();
+  std::map<WasmFunction*, size_t> nbr_call_sites;
+
+  for (auto module : file->GetWasmModules()) {
+    for (auto fct : module->GetWasmFunctions()) {
+      if (fct->IsBodyAvailable() == false) {
+        continue;
+      }
+
+      for (auto callee : call_graph.GetCallees(fct)) {
+        nbr_call_sites[callee]++;
+      }
+    }
+  }
+
+  for (auto module : file->GetWasmModules()) {
+    for (auto caller : module->GetWasmFunctions()) {
+      if (caller->IsBodyAvailable() == false) {
+        continue;
+      }
+
+      std::vector<CallSite> sites;
+      CallSiteCollection collection = {nullptr, &sites};
+
+      for (auto expr : caller->GetAST()) {
+        CollectCallSites(expr, &collection);
+      }
+
+      size_t budget = std::max(GetSize(caller), kMinCallerGrowth);
+
+      for (auto& site : sites) {
+        WasmFunction* callee = site.call_->GetCallee(caller);
+
+        if (callee == caller || callee->IsBodyAvailable() == false) {
+          continue;
+        }
+
+        size_t size = GetSize(callee);
+
+        if (size > budget) {
+          continue;
+        }
+
+        bool is_small_leaf = size <= kLeafSize && IsLeaf(callee) == true;
+        bool is_single_call_site = size <= kSingleCallSiteSize && nbr_call_sites[callee] == 1;
+
+        if (is_small_leaf == false && is_single_call_site == false) {
+          continue;
+        }
+
+        std::vector<Expression*> args;
+        site.call_->GetChildren(args);
+
+        if (args.size() != GetNbrParams(callee) || IsCopiable(callee, caller) == false) {
+          continue;
+        }
+
+        // The calls of the copied body are new call sites.
+        nbr_call_sites[callee]--;
+        callee->Walk([callee, &nbr_call_sites](Expression* expr) {
+          if (llvm::isa<CallExpression>(expr) == true && llvm::isa<CallImportExpression>(expr) == false) {
+            nbr_call_sites[llvm::cast<CallExpression>(expr)->GetCallee(callee)]++;
+          }
+          return true;
+        });
+
+        Expression* block = InlineCall(caller, site.call_, callee);
+
+        if (site.parent_ == nullptr) {
+          caller->ReplaceExpression(site.call_, block);
+        } else {
+          site.parent_->ReplaceChild(site.call_, block);
+        }
+
+        budget -= size;
+      }
+    }
+  }
+}
@@ -0,0 +1,46 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#ifndef H_INLINER
+#define H_INLINER
+
+#include "pass.h"
+
+/**
+ * Inlines the small leaf functions and the functions called from a single site, before any IR exists:
+ *   unlike LLVM, it also inlines a call going to another module of the file, as long as the callee has
+ *   no call, memory access or import: those belong to the callee's own module.
+ *   The callees are still generated, they might be exported or called elsewhere.
+ */
+class InliningPass : public WasmFilePass {
+  public:
+    virtual const char* GetName() const {
+      return "Inlining pass";
+    }
+
+    virtual const char* GetOptionName() const {
+      return "inline";
+    }
+
+    // The copied bodies are moved around by index: locals and labels have to be resolved.
+    virtual void GetDependencies(std::vector<std::string>& dependencies) const {
+      dependencies.push_back("name-resolution");
+    }
+
+    virtual void RunOnFile(WasmFile* file);
+};
+
+#endif
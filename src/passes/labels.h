@@ -0,0 +1,74 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#ifndef H_LABELS
+#define H_LABELS
+
+#include <vector>
+
+#include "expression.h"
+#include "switch_expression.h"
+
+// Label helpers for the passes moving trees around: labels are resolved as distances from the innermost one.
+
+// Labels pushed around child by expr: same as the name resolution, the switch selector is outside of it.
+inline size_t GetPushedLabels(Expression* expr, Expression* child) {
+  switch (expr->GetKind()) {
+    case EXPR_LOOP:
+      return 2;
+    case EXPR_LABEL:
+    case EXPR_BLOCK:
+      return 1;
+    case EXPR_SWITCH:
+      return (child == llvm::cast<SwitchExpression>(expr)->GetSelector()) ? 0 : 1;
+    default:
+      return 0;
+  }
+}
+
+// Calls fct on the label of each break of the tree, with the number of labels pushed since expr.
+template <typename F>
+void ForEachBreak(Expression* expr, size_t inner, F&& fct) {
+  Variable* var = nullptr;
+
+  if (BreakExpression* brk = llvm::dyn_cast<BreakExpression>(expr)) {
+    var = brk->GetVariable();
+  } else if (BreakIfExpression* brk_if = llvm::dyn_cast<BreakIfExpression>(expr)) {
+    var = brk_if->GetVariable();
+  }
+
+  if (var != nullptr) {
+    fct(var, inner);
+  }
+
+  std::vector<Expression*> children;
+  expr->GetChildren(children);
+
+  for (auto child : children) {
+    ForEachBreak(child, inner + GetPushedLabels(expr, child), fct);
+  }
+}
+
+// The tree moves delta labels deeper: the breaks leaving it are updated.
+inline void ShiftLabels(Expression* expr, int delta) {
+  ForEachBreak(expr, 0, [delta](Variable* var, size_t inner) {
+    if (var->IsString() == false && var->GetIdx() >= inner) {
+      var->Resolve(var->GetIdx() + delta);
+    }
+  });
+}
+
+#endif
@@ -14,11 +14,16 @@
 // limitations under the License.
 */
 
-#include "debug.h"
-#include "globals.h"
+#include "function.h"
+#include "name_resolution.h"
+#include "name_resolver.h"
 
-void PrintLine(int line) {
-  const char* name = Globals::Get()->GetFileName();
-  PrintLine(name, line);
-}
+void NameResolutionPass::Run(WasmFunction* fct, void* data) {
+  (void) data;
+
+  NameResolver resolver(fct);
 
+  for (auto expr : fct->GetAST()) {
+    expr->ResolveNames(resolver);
+  }
+}
@@ -0,0 +1,46 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#ifndef H_NAME_RESOLUTION
+#define H_NAME_RESOLUTION
+
+#include "pass.h"
+
+// Rewrites the named locals, labels, and callees into indices before code generation.
+class NameResolutionPass : public WasmPass {
+  public:
+    virtual const char* GetName() const {
+      return "Name resolution pass";
+    }
+
+    virtual const char* GetOptionName() const {
+      return "name-resolution";
+    }
+
+    // Callees are only looked up and the symbol table is locked.
+    virtual bool IsFunctionLocal() const {
+      return true;
+    }
+
+    // Variables change from names to indices: the use counts are by index.
+    virtual unsigned GetPreservedAnalyses() const {
+      return CALL_GRAPH_ANALYSIS;
+    }
+
+    virtual void Run(WasmFunction* fct, void* data);
+};
+
+#endif
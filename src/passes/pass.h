@@ -17,15 +17,69 @@
 #ifndef H_PASS
 #define H_PASS
 
+#include <string>
+#include <vector>
+
+#include "analysis.h"
+
 // Forward declaration.
+class WasmFile;
 class WasmFunction;
+class WasmModule;
+
+// What a pass runs on: the driver calls Run, RunOnModule, or RunOnFile accordingly.
+enum PassLevel {
+  FUNCTION_PASS_LEVEL,
+  MODULE_PASS_LEVEL,
+  FILE_PASS_LEVEL,
+};
 
 class WasmPass {
+  protected:
+    // Set by the driver before Init.
+    WasmAnalysisManager* analyses_;
+
   public:
+    WasmPass() : analyses_(nullptr) {
+    }
+
+    virtual ~WasmPass() {
+    }
+
     virtual const char* GetName() const {
       return "Unnamed pass";
     }
 
+    // The name used by --passes.
+    virtual const char* GetOptionName() const {
+      return "unnamed";
+    }
+
+    virtual PassLevel GetLevel() const {
+      return FUNCTION_PASS_LEVEL;
+    }
+
+    // Option names of the passes that have to run before this one: the driver adds them if needed.
+    virtual void GetDependencies(std::vector<std::string>& dependencies) const {
+      (void) dependencies;
+    }
+
+    // True if Gate, PreRun, and Run only touch the function they are given: the driver can then
+    //   run the pass on several functions at once. No call graph, no other function bodies.
+    //   PostRun is always called from the driver's thread, in function order.
+    virtual bool IsFunctionLocal() const {
+      return false;
+    }
+
+    // AnalysisKind bits still valid after the pass ran.
+    virtual unsigned GetPreservedAnalyses() const {
+      return kNoAnalysis;
+    }
+
+    void SetAnalysisManager(WasmAnalysisManager* analyses) {
+      analyses_ = analyses;
+    }
+
     // Gate determines if we do this.
     virtual bool Gate(WasmFunction* fct) {
       (void) fct;
@@ -35,6 +89,8 @@ class WasmPass {
 
     // Run if gate returned true before running the pass.
     virtual void* PreRun(WasmFunction* fct) {
+      (void) fct;
+
       return nullptr;
     }
 
@@ -49,6 +105,16 @@ class WasmPass {
       (void) data;
     }
 
+    // Run for module passes.
+    virtual void RunOnModule(WasmModule* module) {
+      (void) module;
+    }
+
+    // Run for file passes.
+    virtual void RunOnFile(WasmFile* file) {
+      (void) file;
+    }
+
     // Called before starting the driver.
     virtual void Init() {
     }
@@ -58,4 +124,18 @@ class WasmPass {
     }
 };
 
+class WasmModulePass : public WasmPass {
+  public:
+    virtual PassLevel GetLevel() const {
+      return MODULE_PASS_LEVEL;
+    }
+};
+
+class WasmFilePass : public WasmPass {
+  public:
+    virtual PassLevel GetLevel() const {
+      return FILE_PASS_LEVEL;
+    }
+};
+
 #endif
@@ -14,14 +14,130 @@
 // limitations under the License.
 */
 
+#include <assert.h>
+#include <stdio.h>
+
+#include <chrono>
 #include <list>
+#include <sstream>
 #include <vector>
 
 #include "basic.h"
+#include "constant_folding.h"
+#include "dead_code.h"
 #include "debug.h"
+#include "function_attributes.h"
+#include "globals.h"
+#include "inliner.h"
+#include "name_resolution.h"
 #include "pass.h"
 #include "pass_driver.h"
+#include "read_only_memory.h"
+#include "type_annotation.h"
 #include "wasm_file.h"
+#include "work_stealing_pool.h"
+
+// The pipeline when --passes is not given.
+static const char* kDefaultPasses = "name-resolution,inline,constant-folding,read-only-memory,dead-code,unreachable,function-attributes";
+
+// The code generation needs the types of the nodes: this one always runs, after the passes rewriting the tree.
+static const char* kTypeAnnotationPass = "type-annotation";
+
+WasmPass* PassDriver::CreatePass(const std::string& name) {
+  if (name == "name-resolution") {
+    return new NameResolutionPass();
+  }
+
+  if (name == "inline") {
+    return new InliningPass();
+  }
+
+  if (name == "constant-folding") {
+    return new ConstantFoldingPass();
+  }
+
+  if (name == "read-only-memory") {
+    return new ReadOnlyMemoryPass();
+  }
+
+  if (name == "dead-code") {
+    return new DeadCodePass();
+  }
+
+  if (name == "unreachable") {
+    return new UnreachablePass();
+  }
+
+  if (name == "type-annotation") {
+    return new TypeAnnotationPass();
+  }
+
+  if (name == "function-attributes") {
+    return new FunctionAttributesPass();
+  }
+
+  return nullptr;
+}
+
+bool PassDriver::IsScheduled(const std::string& name) const {
+  for (auto pass : passes_) {
+    if (name == pass->GetOptionName()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void PassDriver::AddPass(WasmPass* pass) {
+  std::vector<std::string> dependencies;
+  pass->GetDependencies(dependencies);
+
+  for (auto& name : dependencies) {
+    if (IsScheduled(name) == false) {
+      WasmPass* dependency = CreatePass(name);
+      assert(dependency != nullptr);
+      AddPass(dependency);
+    }
+  }
+
+  pass->SetAnalysisManager(&analyses_);
+  passes_.push_back(pass);
+  timings_.push_back(0);
+}
+
+void PassDriver::PopulatePasses() {
+  const char* list = Globals::Get()->GetPassList();
+  std::istringstream iss(list != nullptr ? list : kDefaultPasses);
+  std::string name;
+
+  while (std::getline(iss, name, ',')) {
+    if (name.empty() == true || name == kTypeAnnotationPass || IsScheduled(name) == true) {
+      continue;
+    }
+
+    WasmPass* pass = CreatePass(name);
+
+    if (pass == nullptr) {
+      fprintf(stderr, "Unknown pass %s, ignoring it\n", name.c_str());
+      continue;
+    }
+
+    AddPass(pass);
+  }
+
+  AddPass(CreatePass(kTypeAnnotationPass));
+}
+
+void PassDriver::Drive() {
+  InitPasses();
+  RunPasses();
+  CleanUpPasses();
+
+  if (Globals::Get()->GetTimePasses() == true) {
+    PrintTimings();
+  }
+}
 
 void PassDriver::InitPasses() {
   // Before running the passes: initialize them.
@@ -31,41 +147,186 @@ void PassDriver::InitPasses() {
 }
 
 void PassDriver::RunPasses() {
+  size_t nbr = passes_.size();
+  size_t idx = 0;
+
+  while (idx < nbr) {
+    switch (passes_[idx]->GetLevel()) {
+      case FUNCTION_PASS_LEVEL: {
+        // Consecutive function passes run together on each function in turn.
+        size_t last = idx + 1;
+
+        while (last < nbr && passes_[last]->GetLevel() == FUNCTION_PASS_LEVEL) {
+          last++;
+        }
+
+        RunFunctionPasses(idx, last);
+        idx = last;
+        break;
+      }
+      case MODULE_PASS_LEVEL:
+        RunModulePass(idx);
+        idx++;
+        break;
+      case FILE_PASS_LEVEL:
+        RunFilePass(idx);
+        idx++;
+        break;
+    }
+  }
+}
+
+bool PassDriver::AreFunctionLocal(size_t first, size_t last) const {
+  for (size_t idx = first; idx < last; idx++) {
+    if (passes_[idx]->IsFunctionLocal() == false) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void PassDriver::RunFunctionPasses(size_t first, size_t last) {
   // We want to go through each module.
   std::vector<WasmModule*>& modules = file_->GetWasmModules();
+  std::vector<WasmFunction*> functions;
 
   for (auto module : modules) {
-    std::list<WasmFunction*>& functions = module->GetWasmFunctions();
+    for (auto fct : module->GetWasmFunctions()) {
+      // Functions that are not reachable never had their body parsed.
+      if (fct->IsBodyAvailable() == true) {
+        functions.push_back(fct);
+      }
+    }
+  }
+
+  // The analyses are file-wide: they stay as they were until every function went through the passes.
+  unsigned preserved = kAllAnalyses;
+
+  for (size_t idx = first; idx < last; idx++) {
+    preserved &= passes_[idx]->GetPreservedAnalyses();
+  }
 
+  int jobs = Globals::Get()->GetJobs();
+
+  if (jobs <= 1 || AreFunctionLocal(first, last) == false) {
     for (auto fct : functions) {
       PASS_DRIVER_PRINT("Considering %s\n", fct->GetName().c_str());
-      RunPassesOnFunction(fct);
+      RunPassesOnFunction(fct, first, last);
     }
+
+    analyses_.InvalidateAll(preserved);
+    return;
   }
+
+  // Each function goes through the passes on a worker, the PostRuns wait for all of them.
+  size_t nbr_passes = last - first;
+  std::vector<DeferredPostRun> deferred(functions.size() * nbr_passes);
+
+  WorkStealingPool pool(jobs);
+  pool.Run(functions.size(), [this, &functions, &deferred, first, last, nbr_passes](size_t idx) {
+    RunPassesOnFunction(functions[idx], first, last, &deferred[idx * nbr_passes]);
+  });
+
+  MergeDeferredPostRuns(first, last, deferred);
+  analyses_.InvalidateAll(preserved);
 }
 
-void PassDriver::RunPassesOnFunction(WasmFunction* fct) {
-  // Before running the passes.
-  for (auto elem : passes_) {
-    PASS_DRIVER_PRINT("Running pass %s\n", elem->GetName());
-    if (elem->Gate(fct) == true) {
-      // Call the three callbacks.
-      void* data = elem->PreRun(fct);
+void PassDriver::MergeDeferredPostRuns(size_t first, size_t last, const std::vector<DeferredPostRun>& deferred) {
+  // Same order as a serial run whatever the threads did: function by function, pass by pass.
+  size_t nbr_passes = last - first;
+
+  for (size_t i = 0; i < deferred.size(); i++) {
+    const DeferredPostRun& elem = deferred[i];
+    size_t idx = first + i % nbr_passes;
+
+    if (elem.ran_ == true) {
+      passes_[idx]->PostRun(elem.data_);
+    }
+
+    timings_[idx] += elem.time_;
+  }
+}
+
+void PassDriver::RunPassesOnFunction(WasmFunction* fct, size_t first, size_t last, DeferredPostRun* deferred) {
+  for (size_t idx = first; idx < last; idx++) {
+    WasmPass* elem = passes_[idx];
+
+    PASS_DRIVER_PRINT("Running pass %s on %s\n", elem->GetName(), fct->GetName().c_str());
+    auto start = std::chrono::steady_clock::now();
+    bool ran = elem->Gate(fct);
+    void* data = nullptr;
+
+    if (ran == true) {
+      // Call the three callbacks, PostRun is left to the driver's thread when deferred.
+      data = elem->PreRun(fct);
       elem->Run(fct, data);
-      elem->PostRun(data);
+
+      if (deferred == nullptr) {
+        elem->PostRun(data);
+      }
+    }
+
+    double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (deferred == nullptr) {
+      timings_[idx] += time;
+    } else {
+      DeferredPostRun& result = deferred[idx - first];
+      result.ran_ = ran;
+      result.data_ = data;
+      result.time_ = time;
     }
   }
 }
 
+void PassDriver::RunModulePass(size_t idx) {
+  WasmPass* elem = passes_[idx];
+
+  PASS_DRIVER_PRINT("Running module pass %s\n", elem->GetName());
+  auto start = std::chrono::steady_clock::now();
+
+  for (auto module : file_->GetWasmModules()) {
+    elem->RunOnModule(module);
+  }
+
+  analyses_.InvalidateAll(elem->GetPreservedAnalyses());
+
+  timings_[idx] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void PassDriver::RunFilePass(size_t idx) {
+  WasmPass* elem = passes_[idx];
+
+  PASS_DRIVER_PRINT("Running file pass %s\n", elem->GetName());
+  auto start = std::chrono::steady_clock::now();
+
+  elem->RunOnFile(file_);
+  analyses_.InvalidateAll(elem->GetPreservedAnalyses());
+
+  timings_[idx] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
 void PassDriver::CleanUpPasses() {
-  // Before running the passes: initialize them.
+  // After running the passes: clean them up.
   for (auto elem : passes_) {
     elem->CleanUp();
   }
 }
 
-void PassDriver::PopulatePasses() {
-  UnreachablePass* unreachable = new UnreachablePass();
+void PassDriver::PrintTimings() const {
+  double total = 0;
+
+  for (auto timing : timings_) {
+    total += timing;
+  }
+
+  fprintf(stderr, "===-- Wasm pass timings --===\n");
+
+  for (size_t idx = 0; idx < passes_.size(); idx++) {
+    double percent = (total > 0) ? 100 * timings_[idx] / total : 0;
+    fprintf(stderr, "  %10.3f ms (%5.1f%%)  %s\n", timings_[idx] * 1000, percent, passes_[idx]->GetName());
+  }
 
-  AddPass(unreachable);
+  fprintf(stderr, "  %10.3f ms (100.0%%)  Total\n", total * 1000);
 }
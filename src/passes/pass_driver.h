@@ -17,8 +17,11 @@
 #ifndef H_PASS_DRIVER
 #define H_PASS_DRIVER
 
+#include <string>
 #include <vector>
 
+#include "analysis.h"
+
 // Forward declaration.
 class WasmPass;
 class WasmFile;
@@ -26,29 +29,48 @@ class WasmFunction;
 
 class PassDriver {
   protected:
+    // What happened to a pass on a function when it ran on a worker thread.
+    struct DeferredPostRun {
+      bool ran_;
+      void* data_;
+      double time_;
+
+      DeferredPostRun() : ran_(false), data_(nullptr), time_(0) {
+      }
+    };
+
     WasmFile* file_;
     std::vector<WasmPass*> passes_;
+    WasmAnalysisManager analyses_;
+
+    // Seconds spent in each pass, same order as passes_.
+    std::vector<double> timings_;
 
     void InitPasses();
     void RunPasses();
     void CleanUpPasses();
-    void RunPassesOnFunction(WasmFunction* fct);
+    void RunFunctionPasses(size_t first, size_t last);
+    void RunPassesOnFunction(WasmFunction* fct, size_t first, size_t last, DeferredPostRun* deferred = nullptr);
+    void MergeDeferredPostRuns(size_t first, size_t last, const std::vector<DeferredPostRun>& deferred);
+    bool AreFunctionLocal(size_t first, size_t last) const;
+    void RunModulePass(size_t idx);
+    void RunFilePass(size_t idx);
     void PopulatePasses();
+    void PrintTimings() const;
+    bool IsScheduled(const std::string& name) const;
 
   public:
-    PassDriver(WasmFile* f) : file_(f) {
+    PassDriver(WasmFile* f) : file_(f), analyses_(f) {
       PopulatePasses();
     }
 
-    void Drive() {
-      InitPasses();
-      RunPasses();
-      CleanUpPasses();
-    }
+    void Drive();
 
-    void AddPass(WasmPass* pass) {
-      passes_.push_back(pass);
-    }
+    // The passes it depends on are added first if they are not there yet.
+    void AddPass(WasmPass* pass);
+
+    // Returns nullptr for an unknown name.
+    static WasmPass* CreatePass(const std::string& name);
 };
 
 #endif
@@ -0,0 +1,138 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include <utility>
+#include <vector>
+
+#include "function.h"
+#include "memory.h"
+#include "read_only_memory.h"
+
+struct FoldedLoad {
+  Load* load_;
+  Expression* parent_;
+  Const* constant_;
+};
+
+// The loads under expr, whose parent is given: a nullptr parent is the function itself.
+struct LoadCollection {
+  Expression* parent_;
+  std::vector<std::pair<Load*, Expression*> >* loads_;
+};
+
+static bool CollectLoads(Expression* expr, void* data) {
+  LoadCollection* collection = static_cast<LoadCollection*>(data);
+  Load* load = llvm::dyn_cast<Load>(expr);
+
+  if (load != nullptr) {
+    collection->loads_->push_back(std::make_pair(load, collection->parent_));
+  }
+
+  LoadCollection children = {expr, collection->loads_};
+  return expr->ForEachChild(CollectLoads, &children);
+}
+
+// The constant a load of value's bits gives: value holds the loaded bytes only.
+static Const* CreateLoadedConstant(Load* load, uint64_t value) {
+  size_t size = load->GetSize();
+
+  switch (load->GetType()) {
+    case INT_32:
+    case INT_64:
+      // Narrow loads extend to the type: sign extension from the loaded size if signed.
+      if (load->GetSign() == true && size < 64 && ((value >> (size - 1)) & 1) != 0) {
+        value |= ~static_cast<uint64_t>(0) << size;
+      }
+
+      if (load->GetType() == INT_32) {
+        value = static_cast<uint32_t>(value);
+      }
+
+      return new Const(load->GetType(), new ValueHolder(static_cast<int64_t>(value)));
+    case FLOAT_32: {
+      uint32_t bits = static_cast<uint32_t>(value);
+      float f;
+      memcpy(&f, &bits, sizeof(f));
+      return new Const(FLOAT_32, new ValueHolder(f));
+    }
+    case FLOAT_64: {
+      double d;
+      memcpy(&d, &value, sizeof(d));
+      return new Const(FLOAT_64, new ValueHolder(d));
+    }
+    default:
+      return nullptr;
+  }
+}
+
+void ReadOnlyMemoryPass::RunOnModule(WasmModule* module) {
+  const ReadOnlyMemory& memory = analyses_->GetReadOnlyMemory(module);
+
+  for (auto fct : module->GetWasmFunctions()) {
+    if (fct->IsBodyAvailable() == false) {
+      continue;
+    }
+
+    std::vector<std::pair<Load*, Expression*> > loads;
+    LoadCollection collection = {nullptr, &loads};
+
+    for (auto expr : fct->GetAST()) {
+      CollectLoads(expr, &collection);
+    }
+
+    std::vector<FoldedLoad> folded;
+
+    for (auto& elem : loads) {
+      Load* load = elem.first;
+
+      // No store of the module can change what the load reads: LLVM may then hoist and merge it freely.
+      uint64_t first, last;
+
+      if (ReadOnlyMemory::GetAccessRange(load, first, last) == true && memory.IsReadOnly(first, last) == true) {
+        load->SetInvariant(true);
+      }
+
+      uint64_t address;
+      uint64_t value;
+
+      if (ReadOnlyMemory::GetConstantAddress(load, address) == false ||
+          memory.GetValue(address, load->GetSize() / 8, value) == false) {
+        continue;
+      }
+
+      Const* constant = CreateLoadedConstant(load, value);
+
+      if (constant == nullptr) {
+        continue;
+      }
+
+      FoldedLoad folded_load = {load, elem.second, constant};
+      folded.push_back(folded_load);
+    }
+
+    // The address of a folded load is a constant: no folded load is inside another one, the parents stay valid.
+    for (auto& elem : folded) {
+      if (elem.parent_ == nullptr) {
+        fct->ReplaceExpression(elem.load_, elem.constant_);
+      } else {
+        elem.parent_->ReplaceChild(elem.load_, elem.constant_);
+      }
+    }
+  }
+}
@@ -0,0 +1,44 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#ifndef H_READ_ONLY_MEMORY
+#define H_READ_ONLY_MEMORY
+
+#include "pass.h"
+
+/**
+ * Replaces the loads of read-only segment bytes at constant addresses by their value, lookup tables
+ *   mostly. The loads whose bounded address range no store can write are marked invariant.
+ */
+class ReadOnlyMemoryPass : public WasmModulePass {
+  public:
+    virtual const char* GetName() const {
+      return "Read-only memory pass";
+    }
+
+    virtual const char* GetOptionName() const {
+      return "read-only-memory";
+    }
+
+    // The folded loads do not read locals nor call anything.
+    virtual unsigned GetPreservedAnalyses() const {
+      return CALL_GRAPH_ANALYSIS | READ_ONLY_MEMORY_ANALYSIS;
+    }
+
+    virtual void RunOnModule(WasmModule* module);
+};
+
+#endif
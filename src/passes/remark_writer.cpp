@@ -0,0 +1,150 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "llvm/IR/DiagnosticPrinter.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "remark_writer.h"
+
+RemarkWriter::RemarkWriter(const char* file_name) : file_(nullptr) {
+  file_ = fopen(file_name, "w");
+
+  if (file_ == nullptr) {
+    fprintf(stderr, "Could not open the remarks file %s\n", file_name);
+    return;
+  }
+
+  // Without filtering: all the remarks come here, whatever -pass-remarks says.
+  llvm::getGlobalContext().setDiagnosticHandler(HandleDiagnostic, this, false);
+}
+
+RemarkWriter::~RemarkWriter() {
+  if (file_ != nullptr) {
+    llvm::getGlobalContext().setDiagnosticHandler(nullptr);
+    fclose(file_), file_ = nullptr;
+  }
+}
+
+bool RemarkWriter::IsReported(const char* pass) {
+  static const char* reported[] = {
+    "loop-vectorize",
+    "slp-vectorizer",
+    "inline",
+    "licm",
+    "loop-unroll",
+  };
+
+  for (auto name : reported) {
+    if (strcmp(name, pass) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+std::string RemarkWriter::Quote(const std::string& s) {
+  // Single quoted YAML: only the quotes need escaping, by doubling them.
+  std::string res = "'";
+
+  for (auto c : s) {
+    if (c == '\'') {
+      res += '\'';
+    }
+
+    res += c;
+  }
+
+  return res + "'";
+}
+
+void RemarkWriter::Write(const char* kind, const llvm::DiagnosticInfoOptimizationBase& remark) {
+  const char* pass = remark.getPassName();
+
+  if (IsReported(pass) == false) {
+    return;
+  }
+
+  fprintf(file_, "--- !%s\n", kind);
+  fprintf(file_, "Pass:            %s\n", pass);
+
+  if (remark.isLocationAvailable() == true) {
+    llvm::StringRef file_name;
+    unsigned int line = 0;
+    unsigned int column = 0;
+
+    remark.getLocation(&file_name, &line, &column);
+    fprintf(file_, "DebugLoc:        { File: %s, Line: %u, Column: %u }\n", Quote(file_name.str()).c_str(), line, column);
+  }
+
+  fprintf(file_, "Function:        %s\n", Quote(remark.getFunction().getName().str()).c_str());
+  fprintf(file_, "Message:         %s\n", Quote(remark.getMsg().str()).c_str());
+  fprintf(file_, "...\n");
+}
+
+void RemarkWriter::HandleDiagnostic(const llvm::DiagnosticInfo& info, void* context) {
+  RemarkWriter* writer = static_cast<RemarkWriter*>(context);
+
+  // All the remark kinds derive from DiagnosticInfoOptimizationBase.
+  const llvm::DiagnosticInfoOptimizationBase& remark = static_cast<const llvm::DiagnosticInfoOptimizationBase&>(info);
+
+  switch (info.getKind()) {
+    case llvm::DK_OptimizationRemark:
+      writer->Write("Passed", remark);
+      return;
+    case llvm::DK_OptimizationRemarkMissed:
+      writer->Write("Missed", remark);
+      return;
+    case llvm::DK_OptimizationRemarkAnalysis:
+      writer->Write("Analysis", remark);
+      return;
+    case llvm::DK_OptimizationFailure:
+      writer->Write("Failure", remark);
+      return;
+    default:
+      break;
+  }
+
+  // The rest is printed as LLVM does without a handler.
+  llvm::DiagnosticPrinterRawOStream printer(llvm::errs());
+
+  switch (info.getSeverity()) {
+    case llvm::DS_Error:
+      llvm::errs() << "error: ";
+      break;
+    case llvm::DS_Warning:
+      llvm::errs() << "warning: ";
+      break;
+    case llvm::DS_Remark:
+      llvm::errs() << "remark: ";
+      break;
+    case llvm::DS_Note:
+      llvm::errs() << "note: ";
+      break;
+  }
+
+  info.print(printer);
+  llvm::errs() << "\n";
+
+  if (info.getSeverity() == llvm::DS_Error) {
+    exit(EXIT_FAILURE);
+  }
+}
@@ -0,0 +1,46 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#ifndef H_REMARK_WRITER
+#define H_REMARK_WRITER
+
+#include <stdio.h>
+
+#include <string>
+
+#include "llvm/IR/DiagnosticInfo.h"
+
+/**
+ * Writes the optimization remarks of LLVM in YAML while it is installed: one document per remark,
+ *   with the .wast file and line in DebugLoc when the instruction has one (see Expression::Generate).
+ *   Only the vectorizers, the inliner, LICM and the unroller are reported.
+ */
+class RemarkWriter {
+  protected:
+    FILE* file_;
+
+    static void HandleDiagnostic(const llvm::DiagnosticInfo& info, void* context);
+    static bool IsReported(const char* pass);
+    static std::string Quote(const std::string& s);
+
+    void Write(const char* kind, const llvm::DiagnosticInfoOptimizationBase& remark);
+
+  public:
+    RemarkWriter(const char* file_name);
+    ~RemarkWriter();
+};
+
+#endif
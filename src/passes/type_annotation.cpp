@@ -0,0 +1,31 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "function.h"
+#include "type_annotation.h"
+#include "type_annotator.h"
+
+void TypeAnnotationPass::Run(WasmFunction* fct, void* data) {
+  (void) data;
+
+  TypeAnnotator annotator(fct);
+
+  for (auto expr : fct->GetAST()) {
+    annotator.Annotate(expr);
+  }
+
+  fct->SetValid(annotator.GetNbrErrors() == 0);
+}
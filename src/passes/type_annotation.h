@@ -0,0 +1,55 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#ifndef H_TYPE_ANNOTATION
+#define H_TYPE_ANNOTATION
+
+#include "pass.h"
+
+/**
+ * Stamps each node with the type of the value its code generation produces, see TypeAnnotator.
+ *   The code generation only switches on these types: the pass driver always runs this pass, last,
+ *   after the passes rewriting the tree. The nodes that do not type check clear the function's valid flag.
+ */
+class TypeAnnotationPass : public WasmPass {
+  public:
+    virtual const char* GetName() const {
+      return "Type annotation pass";
+    }
+
+    virtual const char* GetOptionName() const {
+      return "type-annotation";
+    }
+
+    // The locals are typed by index.
+    virtual void GetDependencies(std::vector<std::string>& dependencies) const {
+      dependencies.push_back("name-resolution");
+    }
+
+    // Only the signatures of the callees are looked at.
+    virtual bool IsFunctionLocal() const {
+      return true;
+    }
+
+    // The tree's shape does not change.
+    virtual unsigned GetPreservedAnalyses() const {
+      return kAllAnalyses;
+    }
+
+    virtual void Run(WasmFunction* fct, void* data);
+};
+
+#endif
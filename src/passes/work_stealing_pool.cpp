@@ -0,0 +1,101 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "work_stealing_pool.h"
+
+bool WorkStealingPool::Pop(TaskQueue& queue, size_t& task) {
+  std::lock_guard<std::mutex> guard(queue.lock_);
+
+  if (queue.begin_ == queue.end_) {
+    return false;
+  }
+
+  task = queue.begin_++;
+  return true;
+}
+
+bool WorkStealingPool::Steal(TaskQueue& queue, size_t& task) {
+  std::lock_guard<std::mutex> guard(queue.lock_);
+
+  if (queue.begin_ == queue.end_) {
+    return false;
+  }
+
+  task = --queue.end_;
+  return true;
+}
+
+void WorkStealingPool::Run(size_t nbr_tasks, const std::function<void(size_t)>& task) {
+  size_t nbr_threads = std::min(nbr_threads_, nbr_tasks);
+
+  // Not worth a thread.
+  if (nbr_threads <= 1) {
+    for (size_t i = 0; i < nbr_tasks; i++) {
+      task(i);
+    }
+    return;
+  }
+
+  // Hand out the tasks in slices, the first ones get the remainder.
+  std::vector<TaskQueue> queues(nbr_threads);
+  size_t per_thread = nbr_tasks / nbr_threads;
+  size_t remainder = nbr_tasks % nbr_threads;
+  size_t start = 0;
+
+  for (size_t i = 0; i < nbr_threads; i++) {
+    queues[i].begin_ = start;
+    start += per_thread + (i < remainder ? 1 : 0);
+    queues[i].end_ = start;
+  }
+
+  auto worker = [&queues, &task, nbr_threads](size_t id) {
+    size_t idx;
+
+    while (true) {
+      if (Pop(queues[id], idx) == false) {
+        // Nothing is ever added to a queue: once a full round of stealing fails, we are done.
+        bool stolen = false;
+
+        for (size_t i = 1; i < nbr_threads && stolen == false; i++) {
+          stolen = Steal(queues[(id + i) % nbr_threads], idx);
+        }
+
+        if (stolen == false) {
+          return;
+        }
+      }
+
+      task(idx);
+    }
+  };
+
+  // The calling thread is worker 0.
+  std::vector<std::thread> threads;
+
+  for (size_t i = 1; i < nbr_threads; i++) {
+    threads.push_back(std::thread(worker, i));
+  }
+
+  worker(0);
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
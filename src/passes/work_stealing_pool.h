@@ -0,0 +1,55 @@
+/*
+// Copyright (c) 2015 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#ifndef H_WORK_STEALING_POOL
+#define H_WORK_STEALING_POOL
+
+#include <stddef.h>
+
+#include <functional>
+#include <mutex>
+
+/**
+ * Runs a batch of independent tasks on a set of threads: each thread starts with its own
+ *   contiguous slice of the task indices and, once it is empty, steals from the others.
+ *   The threads only live for one Run: the driver has a handful of batches per file.
+ */
+class WorkStealingPool {
+  protected:
+    // One per thread: the owner takes from the front, thieves take from the back.
+    struct TaskQueue {
+      std::mutex lock_;
+      size_t begin_;
+      size_t end_;
+
+      TaskQueue() : begin_(0), end_(0) {
+      }
+    };
+
+    size_t nbr_threads_;
+
+    static bool Pop(TaskQueue& queue, size_t& task);
+    static bool Steal(TaskQueue& queue, size_t& task);
+
+  public:
+    WorkStealingPool(size_t nbr_threads) : nbr_threads_(nbr_threads) {
+    }
+
+    // Calls task(i) once for each i in [0, nbr_tasks), returns when they are all done.
+    void Run(size_t nbr_tasks, const std::function<void(size_t)>& task);
+};
+
+#endif
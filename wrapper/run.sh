@@ -16,14 +16,15 @@
 
 echo "Running tests"
 
+# Each line is a test file, optionally followed by the options to compile it with.
 if [ $# -eq 0 ]; then
   list=`cat wrapper/supported | grep -v '#'`
 else
-  list="$@"
+  list=`printf "%s\n" "$@"`
 fi
 
 echo "Test list is:"
-echo $list
+echo "$list"
 
 exe=${PWD}/llvm_wasm
 our_log=obj/test_output
@@ -34,11 +35,16 @@ if [ ! -e $exe ]; then
   exit 1
 fi
 
-for name in $list; do
+# Read the list on another descriptor: the commands of the loop must not consume it.
+while read -r name options <&3; do
+  if [ -z "$name" ]; then
+    continue
+  fi
+
   f="testsuite/$name"
   f_dir=`dirname $f`
   f_base=`basename $f`
-  echo "Testing $f_base in $f_dir"
+  echo "Testing $f_base in $f_dir $options"
 
   if [ ! -e $f ]; then
     echo "Skipping $f, does not exist"
@@ -47,7 +53,7 @@ for name in $list; do
     rm obj/*ll obj/*s 2> /dev/null
 
     # Build the llvm IR
-    $exe $f
+    $exe $options $f
 
     if [ $? -ne 0 ]; then
       echo "LLVM transformation of $f failed. Bailing."
@@ -107,6 +113,6 @@ for name in $list; do
       fi
     fi
   fi
-done
+done 3<<< "$list"
 
 echo "Tests passed"